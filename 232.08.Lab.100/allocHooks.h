@@ -0,0 +1,67 @@
+/***********************************************************************
+ * Header:
+ *    Allocation Hooks
+ * Summary:
+ *    Replaces the global operator new and delete with ones that count
+ *    through alloc_tracker. These are definitions, not declarations:
+ *    include this from exactly one source file of a program, the one
+ *    with main(), or the program will not link.
+ *
+ *    Every form of new and delete comes here, the array, nothrow, and
+ *    sized ones too, so whatever allocates a block also frees it here.
+ *    Over-aligned new (C++17) is left alone: nothing in these sets asks
+ *    for more than malloc gives.
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "allocTracker.h"
+
+#include <new>         // for std::bad_alloc and std::nothrow_t
+
+void * operator new(size_t size)
+{
+   void * p = custom::alloc_tracker::allocate(size);
+   if (!p)
+      throw std::bad_alloc();
+   return p;
+}
+void * operator new[](size_t size)
+{
+   return operator new(size);
+}
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+   return custom::alloc_tracker::allocate(size);
+}
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+   return custom::alloc_tracker::allocate(size);
+}
+
+void operator delete(void * p) noexcept
+{
+   custom::alloc_tracker::free(p);
+}
+void operator delete[](void * p) noexcept
+{
+   custom::alloc_tracker::free(p);
+}
+void operator delete(void * p, size_t) noexcept
+{
+   custom::alloc_tracker::free(p);
+}
+void operator delete[](void * p, size_t) noexcept
+{
+   custom::alloc_tracker::free(p);
+}
+void operator delete(void * p, const std::nothrow_t &) noexcept
+{
+   custom::alloc_tracker::free(p);
+}
+void operator delete[](void * p, const std::nothrow_t &) noexcept
+{
+   custom::alloc_tracker::free(p);
+}
@@ -0,0 +1,234 @@
+/***********************************************************************
+ * Header:
+ *    Allocation Tracker
+ * Summary:
+ *    Counts every block the program allocates with operator new: how
+ *    many, how many bytes, the most bytes live at once, and how many
+ *    of each size. Spy::numAlloc() sees only what a Spy allocates;
+ *    this also sees the nodes a tree allocates for it.
+ *
+ *    The counting needs the program's operator new and delete to go
+ *    through alloc_tracker, which allocHooks.h arranges. Include that
+ *    in exactly one source file of a program (the test driver does,
+ *    and the benchmark driver when built with BENCH_ALLOCS). Without
+ *    it, every count reads zero. Every allocation then updates the
+ *    same few atomics, so threads allocating at once contend on them.
+ *
+ *    Each block carries a small header holding its size, so delete
+ *    knows what it frees. The counts are relaxed atomics, safe from
+ *    any thread. The peak is one for the whole program: scopes that
+ *    overlap each restart it.
+ *
+ *    This will contain the class definitions of:
+ *        alloc_stats         : Counts of allocations and their sizes
+ *        alloc_tracker       : Where operator new and delete report
+ *        alloc_scope         : The allocations since it was made
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cstddef>     // for size_t and std::max_align_t
+#include <cstdint>     // for uint64_t and int64_t
+#include <cstdlib>     // for malloc and free
+
+namespace custom
+{
+
+// one size class per power of two: [i] is sizes 2^(i-1)+1 ... 2^i
+const size_t ALLOC_SIZE_CLASSES = 64;
+
+/************************************************
+ * ALLOC STATS
+ * Allocations over some stretch of the program
+ ***********************************************/
+struct alloc_stats
+{
+   uint64_t numAllocs;
+   uint64_t numFrees;
+   uint64_t bytesAllocated;
+   uint64_t bytesFreed;
+   uint64_t bytesPeak;                         // most live at once, above the start
+   uint64_t sizeCounts[ALLOC_SIZE_CLASSES];    // allocations of each size class
+
+   int64_t bytesLive() const
+   {
+      return (int64_t)(bytesAllocated - bytesFreed);
+   }
+   bool empty() const
+   {
+      return numAllocs == 0 && numFrees == 0;
+   }
+
+   // add another stretch; the peak is the higher of the two
+   alloc_stats & operator += (const alloc_stats & rhs)
+   {
+      numAllocs      += rhs.numAllocs;
+      numFrees       += rhs.numFrees;
+      bytesAllocated += rhs.bytesAllocated;
+      bytesFreed     += rhs.bytesFreed;
+      if (rhs.bytesPeak > bytesPeak)
+         bytesPeak = rhs.bytesPeak;
+      for (size_t i = 0; i < ALLOC_SIZE_CLASSES; i++)
+         sizeCounts[i] += rhs.sizeCounts[i];
+      return *this;
+   }
+
+   // the class of a size, and the largest size in a class
+   static size_t sizeClass(size_t size)
+   {
+      size_t index = 0;
+      while (index + 1 < ALLOC_SIZE_CLASSES && ((size_t)1 << index) < size)
+         index++;
+      return index;
+   }
+   static size_t sizeClassMax(size_t index)
+   {
+      return (size_t)1 << index;
+   }
+};
+
+/************************************************
+ * ALLOC TRACKER
+ * The running totals of the whole program
+ ***********************************************/
+class alloc_tracker
+{
+public:
+
+   // whether operator new reports here in this program
+   static bool isHooked()
+   {
+      return state().isHooked.load(std::memory_order_relaxed);
+   }
+
+   /*************************************************************
+    * ALLOCATE and FREE
+    * What the hooked operator new and delete call. A block is
+    * malloc'ed with its size in front of it.
+    *************************************************************/
+   static void * allocate(size_t size)
+   {
+      char * p = (char *)malloc(size + HEADER);
+      if (!p)
+         return nullptr;
+      *(size_t *)p = size;
+
+      State & s = state();
+      s.isHooked.store(true, std::memory_order_relaxed);
+      s.numAllocs.fetch_add(1, std::memory_order_relaxed);
+      s.bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+      s.sizeCounts[alloc_stats::sizeClass(size)].fetch_add(1, std::memory_order_relaxed);
+      uint64_t live = s.bytesLive.fetch_add(size, std::memory_order_relaxed) + size;
+      uint64_t peak = s.bytesPeak.load(std::memory_order_relaxed);
+      while (live > peak &&
+             !s.bytesPeak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+         ;
+      return p + HEADER;
+   }
+   static void free(void * pBlock)
+   {
+      if (!pBlock)
+         return;
+      char * p = (char *)pBlock - HEADER;
+      size_t size = *(size_t *)p;
+
+      State & s = state();
+      s.numFrees.fetch_add(1, std::memory_order_relaxed);
+      s.bytesFreed.fetch_add(size, std::memory_order_relaxed);
+      s.bytesLive.fetch_sub(size, std::memory_order_relaxed);
+      ::free(p);
+   }
+
+   /*************************************************************
+    * TOTALS
+    * Everything since the program started. The peak is the most
+    * live since the last restartPeak().
+    *************************************************************/
+   static alloc_stats totals()
+   {
+      State & s = state();
+      alloc_stats stats;
+      stats.numAllocs      = s.numAllocs.load(std::memory_order_relaxed);
+      stats.numFrees       = s.numFrees.load(std::memory_order_relaxed);
+      stats.bytesAllocated = s.bytesAllocated.load(std::memory_order_relaxed);
+      stats.bytesFreed     = s.bytesFreed.load(std::memory_order_relaxed);
+      stats.bytesPeak      = s.bytesPeak.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < ALLOC_SIZE_CLASSES; i++)
+         stats.sizeCounts[i] = s.sizeCounts[i].load(std::memory_order_relaxed);
+      return stats;
+   }
+   static uint64_t bytesLive()
+   {
+      return state().bytesLive.load(std::memory_order_relaxed);
+   }
+   static void restartPeak()
+   {
+      State & s = state();
+      s.bytesPeak.store(s.bytesLive.load(std::memory_order_relaxed), std::memory_order_relaxed);
+   }
+
+private:
+
+   // keeps the block malloc'ed behind the header as aligned as malloc made it
+   static const size_t HEADER = alignof(std::max_align_t);
+
+   // zero before any code runs, so operator new may use it at any time
+   struct State
+   {
+      std::atomic<bool>     isHooked;
+      std::atomic<uint64_t> numAllocs;
+      std::atomic<uint64_t> numFrees;
+      std::atomic<uint64_t> bytesAllocated;
+      std::atomic<uint64_t> bytesFreed;
+      std::atomic<uint64_t> bytesLive;
+      std::atomic<uint64_t> bytesPeak;
+      std::atomic<uint64_t> sizeCounts[ALLOC_SIZE_CLASSES];
+   };
+   static State & state()
+   {
+      static State s;
+      return s;
+   }
+};
+
+/************************************************
+ * ALLOC SCOPE
+ * The allocations since it was made or restarted
+ ***********************************************/
+class alloc_scope
+{
+public:
+   alloc_scope()
+   {
+      restart();
+   }
+   void restart()
+   {
+      alloc_tracker::restartPeak();
+      start = alloc_tracker::totals();
+      liveStart = alloc_tracker::bytesLive();
+   }
+
+   alloc_stats stats() const
+   {
+      alloc_stats now = alloc_tracker::totals();
+      alloc_stats stats;
+      stats.numAllocs      = now.numAllocs      - start.numAllocs;
+      stats.numFrees       = now.numFrees       - start.numFrees;
+      stats.bytesAllocated = now.bytesAllocated - start.bytesAllocated;
+      stats.bytesFreed     = now.bytesFreed     - start.bytesFreed;
+      stats.bytesPeak      = now.bytesPeak > liveStart ? now.bytesPeak - liveStart : 0;
+      for (size_t i = 0; i < ALLOC_SIZE_CLASSES; i++)
+         stats.sizeCounts[i] = now.sizeCounts[i] - start.sizeCounts[i];
+      return stats;
+   }
+
+private:
+   alloc_stats start;      // the totals when it started
+   uint64_t    liveStart;  // the bytes live then
+};
+
+}; // namespace custom
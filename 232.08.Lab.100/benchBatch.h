@@ -0,0 +1,80 @@
+/***********************************************************************
+ * Header:
+ *    BENCH BATCH
+ * Summary:
+ *    Benchmark for set::insert_batch against a loop of single inserts,
+ *    over batch sizes from 16 to 1M into a set of 1M elements
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "benchmark.h"
+
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH BATCH
+ * Batches of new, shuffled keys into a large set
+ ***********************************************/
+class BenchBatch : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numKeys = 1000000;
+
+      // the set holds the even keys, the batches are odd keys
+      std::vector<int> evens = randomKeys(numKeys);
+      for (auto & key : evens)
+         key *= 2;
+      std::vector<int> odds = randomKeys(numKeys, 2463534242ULL);
+      for (auto & key : odds)
+         key = key * 2 + 1;
+      custom::set<int> s(evens.begin(), evens.end(), 0);
+
+      for (size_t numBatch = 16; numBatch < numKeys * 16; numBatch *= 16)
+      {
+         if (numBatch > numKeys)
+            numBatch = numKeys;
+         std::vector<int> batch(odds.begin(), odds.begin() + numBatch);
+         bench_insert(s, batch);
+         bench_insertBatch(s, batch);
+      }
+
+      report("Batch");
+   }
+
+   /***************************************
+    * INSERT
+    * One insert per key
+    ***************************************/
+   void bench_insert(const custom::set<int> & sBase, const std::vector<int> & batch)
+   {
+      custom::set<int> s(sBase);
+      double seconds = time([&]()
+      {
+         for (int key : batch)
+            s.insert(key);
+      });
+      record("insert", "batch=" + std::to_string(batch.size()), batch.size(), seconds);
+   }
+
+   /***************************************
+    * INSERT BATCH
+    ***************************************/
+   void bench_insertBatch(const custom::set<int> & sBase, const std::vector<int> & batch)
+   {
+      custom::set<int> s(sBase);
+      double seconds = time([&]()
+      {
+         s.insert_batch(batch.begin(), batch.end());
+      });
+      record("insert_batch", "batch=" + std::to_string(batch.size()), batch.size(), seconds);
+   }
+};
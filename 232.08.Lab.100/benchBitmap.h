@@ -0,0 +1,157 @@
+/***********************************************************************
+ * Header:
+ *    BENCH BITMAP
+ * Summary:
+ *    Dense 32-bit keys in a custom::set against a bitmap_set: memory,
+ *    insert and find, and the throughput of union and intersection
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "bitmapSet.h"
+#include "benchmark.h"
+
+#include <cstdint>
+#include <cstdio>      // for snprintf
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH BITMAP
+ * Two overlapping halves of 0..n-1
+ ***********************************************/
+class BenchBitmap : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      // lhs and rhs each hold half of 0..n-1 and share half of that
+      const size_t num = 4000000;
+      std::vector<int> keys = randomKeys(num);
+      std::vector<uint32_t> lhs(keys.begin(), keys.begin() + num / 2);
+      std::vector<uint32_t> rhs(keys.begin() + num / 4, keys.begin() + 3 * num / 4);
+      std::vector<int> probes = randomKeys(1000000, 2463534242ULL);
+
+      custom::set<uint32_t> sLhs;
+      custom::set<uint32_t> sRhs;
+      record("insert", "set", lhs.size(), time([&]()
+      {
+         for (uint32_t key : lhs)
+            sLhs.insert(key);
+      }));
+      custom::bitmap_set bLhs;
+      custom::bitmap_set bRhs;
+      record("insert", "bitmap_set", lhs.size(), time([&]()
+      {
+         for (uint32_t key : lhs)
+            bLhs.insert(key);
+      }));
+      for (uint32_t key : rhs)
+         sRhs.insert(key);
+      bRhs.insert(rhs.begin(), rhs.end());
+
+      // a BNode is the key, three pointers, and a color, padded, plus a malloc header
+      size_t bytesNode = (sizeof(uint32_t) + 3 * sizeof(void *) + sizeof(bool) + sizeof(void *) - 1)
+                         / sizeof(void *) * sizeof(void *) + 16;
+      record("memory", "set bytes/key=" + perKey(bytesNode * sLhs.size(), sLhs.size()), 0, 0.0);
+      record("memory", "bitmap_set bytes/key=" + perKey(bLhs.memory(), bLhs.size()), 0, 0.0);
+
+      size_t numFound = 0;
+      double seconds = time([&]()
+      {
+         for (int probe : probes)
+            numFound += sLhs.find((uint32_t)probe) != sLhs.end();
+      });
+      record("find", "set hits=" + std::to_string(numFound), probes.size(), seconds);
+      numFound = 0;
+      seconds = time([&]()
+      {
+         for (int probe : probes)
+            numFound += bLhs.contains((uint32_t)probe);
+      });
+      record("find", "bitmap_set hits=" + std::to_string(numFound), probes.size(), seconds);
+
+      // the tree has no set algebra: merge in order, then bulk build
+      size_t numOps = lhs.size() + rhs.size();
+      custom::set<uint32_t> sResult;
+      record("union", "set", numOps, time([&]()
+      {
+         std::vector<uint32_t> merged = merge(sLhs, sRhs, true);
+         custom::set<uint32_t> sBuilt(merged.begin(), merged.end(), 1);
+         sResult.swap(sBuilt);
+      }));
+      custom::bitmap_set bResult;
+      record("union", "bitmap_set", numOps, time([&]()
+      {
+         bResult = bLhs | bRhs;
+      }));
+      record("union", "sizes " + std::to_string(sResult.size()) + "=" +
+             std::to_string(bResult.size()), 0, 0.0);
+      record("intersection", "set", numOps, time([&]()
+      {
+         std::vector<uint32_t> merged = merge(sLhs, sRhs, false);
+         custom::set<uint32_t> sBuilt(merged.begin(), merged.end(), 1);
+         sResult.swap(sBuilt);
+      }));
+      record("intersection", "bitmap_set", numOps, time([&]()
+      {
+         bResult = bLhs & bRhs;
+      }));
+      record("intersection", "sizes " + std::to_string(sResult.size()) + "=" +
+             std::to_string(bResult.size()), 0, 0.0);
+
+      report("Bitmap");
+   }
+
+private:
+
+   /*************************************************************
+    * MERGE
+    * The union, or the intersection, of two sets in order
+    *************************************************************/
+   static std::vector<uint32_t> merge(const custom::set<uint32_t> & lhs,
+                                      const custom::set<uint32_t> & rhs, bool isUnion)
+   {
+      std::vector<uint32_t> merged;
+      auto itLhs = lhs.begin();
+      auto itRhs = rhs.begin();
+      while (itLhs != lhs.end() && itRhs != rhs.end())
+      {
+         if (*itLhs < *itRhs)
+         {
+            if (isUnion)
+               merged.push_back(*itLhs);
+            ++itLhs;
+         }
+         else if (*itRhs < *itLhs)
+         {
+            if (isUnion)
+               merged.push_back(*itRhs);
+            ++itRhs;
+         }
+         else
+         {
+            merged.push_back(*itLhs);
+            ++itLhs;
+            ++itRhs;
+         }
+      }
+      for (; isUnion && itLhs != lhs.end(); ++itLhs)
+         merged.push_back(*itLhs);
+      for (; isUnion && itRhs != rhs.end(); ++itRhs)
+         merged.push_back(*itRhs);
+      return merged;
+   }
+
+   static std::string perKey(size_t numBytes, size_t num)
+   {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%.2f", num ? (double)numBytes / num : 0.0);
+      return buffer;
+   }
+};
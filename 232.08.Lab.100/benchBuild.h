@@ -0,0 +1,72 @@
+/***********************************************************************
+ * Header:
+ *    BENCH BUILD
+ * Summary:
+ *    Wall-clock benchmark for building a set from unsorted input: one
+ *    insert at a time against the parallel sort-and-link bulk load
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "benchmark.h"
+
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH BUILD
+ * Construct from a shuffled range with duplicates
+ ***********************************************/
+class BenchBuild : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numKeys = 2000000;
+      std::vector<int> keys = randomKeys(numKeys);
+      for (auto & key : keys)
+         key %= (int)(numKeys / 2);   // roughly half are duplicates
+
+      bench_insert(keys);
+      for (size_t numThreads = 1; numThreads <= 8; numThreads *= 2)
+         bench_bulk(keys, numThreads);
+
+      report("Build");
+   }
+
+   /***************************************
+    * INSERT
+    * set(first, last): one insert per element
+    ***************************************/
+   void bench_insert(const std::vector<int> & keys)
+   {
+      size_t num = 0;
+      double seconds = time([&]()
+      {
+         custom::set<int> s(keys.begin(), keys.end());
+         num = s.size();
+      });
+      record("construct", "insert size=" + std::to_string(num), keys.size(), seconds);
+   }
+
+   /***************************************
+    * BULK
+    * set(first, last, numThreads)
+    ***************************************/
+   void bench_bulk(const std::vector<int> & keys, size_t numThreads)
+   {
+      size_t num = 0;
+      double seconds = time([&]()
+      {
+         custom::set<int> s(keys.begin(), keys.end(), numThreads);
+         num = s.size();
+      });
+      record("construct", "bulk threads=" + std::to_string(numThreads) +
+             " size=" + std::to_string(num), keys.size(), seconds);
+   }
+};
@@ -0,0 +1,229 @@
+/***********************************************************************
+ * Header:
+ *    BENCH COMPARE
+ * Summary:
+ *    custom::set side by side with std::set: insert, find, iterate,
+ *    copy, move, clear, erase and range construction of int,
+ *    std::string and Spy keys, 10^2 to 10^7 of them, arriving sorted,
+ *    reversed, shuffled, or drawn from a Zipf distribution.
+ *
+ *    custom::set does not rebalance, so sorted and reversed keys build
+ *    a chain and cost O(n^2); those runs stop at 10^4 keys. The insert
+ *    line of each custom::set run shows the shape of the tree it built.
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "spy.h"
+#include "benchmark.h"
+
+#include <cmath>       // for std::pow
+#include <cstdio>      // for snprintf
+#include <memory>      // for std::unique_ptr
+#include <set>         // for std::set
+#include <string>
+#include <vector>
+
+/***********************************************
+ * BENCH COMPARE
+ * The same operations on custom::set and std::set
+ ***********************************************/
+class BenchCompare : public Benchmark
+{
+public:
+   BenchCompare(size_t sizeMax = 10000000) : sizeMax(sizeMax) {}
+
+   void run()
+   {
+      const char * workloads[] = { "sorted", "reverse", "random", "zipf" };
+      for (size_t num = 100; num <= sizeMax; num *= 10)
+      {
+         reset();
+         for (const char * workload : workloads)
+         {
+            std::vector<int> ids = makeIds(workload, num);
+            bool isChain = workload[0] == 's' || workload[0] == 'r';
+            bool isCustom = !isChain || num <= CHAIN_MAX;
+            compare<int>        ("int",    workload, ids, isCustom);
+            compare<std::string>("string", workload, ids, isCustom);
+            compare<Spy>        ("Spy",    workload, ids, isCustom);
+         }
+         report("Compare");
+      }
+   }
+
+private:
+
+   static const size_t CHAIN_MAX = 10000;   // largest unbalanced run
+   static const size_t OPS_MIN = 100000;    // small sizes repeat up to this
+
+   /*************************************************************
+    * MAKE IDS
+    * The order num keys arrive in. Zipf draws num times from
+    * num ranks with exponent 0.99, so a few keys repeat often;
+    * the ranks are shuffled so the popular keys are not also
+    * the smallest.
+    *************************************************************/
+   static std::vector<int> makeIds(const std::string & workload, size_t num)
+   {
+      std::vector<int> ids(num);
+      if (workload == "sorted" || workload == "reverse")
+      {
+         for (size_t i = 0; i < num; i++)
+            ids[i] = workload == "sorted" ? (int)i : (int)(num - 1 - i);
+      }
+      else if (workload == "random")
+         ids = randomKeys(num);
+      else
+      {
+         std::vector<int> ranks = randomKeys(num);
+         const double s = 0.99;
+         double range = std::pow((double)num, 1.0 - s) - 1.0;
+         uint64_t seed = 2463534242ULL;
+         for (size_t i = 0; i < num; i++)
+         {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            double u = (double)(seed >> 11) / 9007199254740992.0;   // [0, 1)
+            size_t rank = (size_t)std::pow(range * u + 1.0, 1.0 / (1.0 - s)) - 1;
+            ids[i] = ranks[rank < num ? rank : num - 1];
+         }
+      }
+      return ids;
+   }
+
+   /*************************************************************
+    * MAKE KEY
+    * An id as a key of each type. Strings are zero padded so
+    * they sort the same way the ids do.
+    *************************************************************/
+   template <class T>
+   static T makeKey(int id);
+
+   /*************************************************************
+    * COMPARE
+    * Both containers on one type and workload
+    *************************************************************/
+   template <class T>
+   void compare(const char * type, const char * workload, const std::vector<int> & ids,
+                bool isCustom)
+   {
+      std::vector<T> keys;
+      keys.reserve(ids.size());
+      for (int id : ids)
+         keys.push_back(makeKey<T>(id));
+
+      std::string params = std::string(" type=") + type + " workload=" + workload +
+                           " n=" + std::to_string(ids.size());
+      measure<std::set<T>>("set=std" + params, keys);
+      if (isCustom)
+         measure<custom::set<T>>("set=custom" + params, keys);
+   }
+
+   /*************************************************************
+    * MEASURE
+    * Every operation on one container. The hardware counters and
+    * the allocations of each operation add up on their own.
+    *************************************************************/
+   template <class Set, class T>
+   void measure(const std::string & params, const std::vector<T> & keys)
+   {
+      size_t num = keys.size();
+      size_t numReps = num < OPS_MIN ? OPS_MIN / num : 1;
+      double seconds[8] = {};
+      PerfCounters::Reading counters[8];
+      custom::alloc_stats allocs[8] = {};
+      size_t numFound = 0;
+      size_t numVisited = 0;
+      custom::tree_stats shape;     // of the tree the first insert built
+      bool hasShape = false;
+
+      for (size_t iRep = 0; iRep < numReps; iRep++)
+      {
+         Set s;
+         seconds[0] += timeOp(counters[0], allocs[0], [&]()
+         {
+            for (const T & key : keys)
+               s.insert(key);
+         });
+         if (iRep == 0)
+            hasShape = shape_of(s, shape);
+         seconds[1] += timeOp(counters[1], allocs[1], [&]()
+         {
+            for (const T & key : keys)
+               numFound += s.find(key) != s.end();
+         });
+         seconds[2] += timeOp(counters[2], allocs[2], [&]()
+         {
+            for (auto it = s.begin(); it != s.end(); ++it)
+               numVisited++;
+         });
+
+         std::unique_ptr<Set> pCopy;
+         std::unique_ptr<Set> pMoved;
+         seconds[3] += timeOp(counters[3], allocs[3], [&]() { pCopy.reset(new Set(s)); });
+         seconds[4] += timeOp(counters[4], allocs[4],
+                              [&]() { pMoved.reset(new Set(std::move(*pCopy))); });
+         seconds[5] += timeOp(counters[5], allocs[5], [&]() { pMoved->clear(); });
+         pCopy.reset();
+         pMoved.reset();
+
+         seconds[6] += timeOp(counters[6], allocs[6], [&]()
+         {
+            for (const T & key : keys)
+               s.erase(key);
+         });
+
+         std::unique_ptr<Set> pRange;
+         seconds[7] += timeOp(counters[7], allocs[7],
+                              [&]() { pRange.reset(new Set(keys.begin(), keys.end())); });
+      }
+
+      size_t numOps = num * numReps;
+      record("insert",  params, numOps,  seconds[0], counters[0], allocs[0]);
+      if (hasShape)
+         record_shape(shape);
+      record("find",    params + " hits=" + std::to_string(numFound), numOps, seconds[1],
+             counters[1], allocs[1]);
+      record("iterate", params + " visited=" + std::to_string(numVisited), numOps, seconds[2],
+             counters[2], allocs[2]);
+      record("copy",    params, numOps,  seconds[3], counters[3], allocs[3]);
+      record("move",    params, numReps, seconds[4], counters[4], allocs[4]);
+      record("clear",   params, numOps,  seconds[5], counters[5], allocs[5]);
+      record("erase",   params, numOps,  seconds[6], counters[6], allocs[6]);
+      record("range",   params, numOps,  seconds[7], counters[7], allocs[7]);
+   }
+
+   template <class F>
+   static double timeOp(PerfCounters::Reading & counters, custom::alloc_stats & allocs, F f)
+   {
+      double seconds = time(f);
+      counters += take_counters();
+      allocs += take_allocs();
+      return seconds;
+   }
+
+   size_t sizeMax;   // the largest number of keys to try
+};
+
+template <>
+inline int BenchCompare::makeKey<int>(int id)
+{
+   return id;
+}
+template <>
+inline std::string BenchCompare::makeKey<std::string>(int id)
+{
+   char buffer[16];
+   snprintf(buffer, sizeof(buffer), "user:%010d", id);
+   return buffer;
+}
+template <>
+inline Spy BenchCompare::makeKey<Spy>(int id)
+{
+   return Spy(id);
+}
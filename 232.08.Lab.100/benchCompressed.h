@@ -0,0 +1,133 @@
+/***********************************************************************
+ * Header:
+ *    BENCH COMPRESSED
+ * Summary:
+ *    Memory and lookup benchmark: 64-bit ids and URLs held in a
+ *    custom::set against the same keys in a compressed set
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "compressedSet.h"
+#include "benchmark.h"
+
+#include <cstdint>
+#include <cstdio>      // for snprintf
+#include <type_traits>
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH COMPRESSED
+ * Bytes per key and time per find
+ ***********************************************/
+class BenchCompressed : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      // ids with random gaps of 1 to 64, and URLs under a few directories
+      const size_t numIds = 2000000;
+      const size_t numUrls = 500000;
+      uint64_t seed = 88172645463325252ULL;
+      std::vector<uint64_t> ids(numIds);
+      uint64_t id = 1000000000000ULL;
+      for (auto & idNext : ids)
+         idNext = id += 1 + next(seed) % 64;
+      std::vector<std::string> urls(numUrls);
+      for (size_t i = 0; i < numUrls; i++)
+         urls[i] = "https://www.example.com/catalog/" + std::to_string(i % 50) +
+                   "/item-" + std::to_string(next(seed) % 100000000);
+
+      std::vector<uint64_t> idProbes(1000000);
+      for (auto & probe : idProbes)
+         probe = ids[next(seed) % numIds] + (next(seed) & 1);
+      std::vector<std::string> urlProbes(1000000);
+      for (auto & probe : urlProbes)
+         probe = urls[next(seed) % numUrls];
+
+      compare("ids", ids, idProbes,
+              [](const uint64_t &) { return (size_t)0; });
+      compare("urls", urls, urlProbes, [](const std::string & url)
+      {
+         // the characters live on the heap past the small string buffer
+         return url.size() > 15 ? url.capacity() + 1 + MALLOC_OVERHEAD : (size_t)0;
+      });
+
+      report("Compressed");
+   }
+
+private:
+
+   static const size_t MALLOC_OVERHEAD = 16;   // typical header of a heap block
+
+   /*************************************************************
+    * COMPARE
+    * Build both sets from keys, then record their size and
+    * the time to look up every probe
+    *************************************************************/
+   template <typename T, class HeapBytes>
+   void compare(const std::string & name, const std::vector<T> & keys,
+                const std::vector<T> & probes, HeapBytes heapBytes)
+   {
+      custom::set<T> s(keys.begin(), keys.end(), 0);
+      typename std::conditional<std::is_integral<T>::value,
+                                custom::compressed_int_set<T>,
+                                custom::compressed_string_set>::type c;
+      double seconds = time([&]()
+      {
+         decltype(c) cBuilt(s.begin(), s.end());
+         c = std::move(cBuilt);
+      });
+      record(name + " compress", "", s.size(), seconds);
+
+      // a BNode is the key, three pointers, and a color, padded
+      size_t bytesSet = 0;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         bytesSet += nodeBytes<T>() + heapBytes(*it);
+      record(name + " memory", "set bytes/key=" + perKey(bytesSet, s.size()), 0, 0.0);
+      record(name + " memory", "compressed bytes/key=" + perKey(c.memory(), c.size()), 0, 0.0);
+
+      size_t numFound = 0;
+      seconds = time([&]()
+      {
+         for (const T & probe : probes)
+            numFound += s.find(probe) != s.end();
+      });
+      record(name + " find", "set hits=" + std::to_string(numFound), probes.size(), seconds);
+      numFound = 0;
+      seconds = time([&]()
+      {
+         for (const T & probe : probes)
+            numFound += c.contains(probe);
+      });
+      record(name + " find", "compressed hits=" + std::to_string(numFound), probes.size(), seconds);
+   }
+
+   template <typename T>
+   static size_t nodeBytes()
+   {
+      size_t num = sizeof(T) + 3 * sizeof(void *) + sizeof(bool);
+      return (num + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *) + MALLOC_OVERHEAD;
+   }
+
+   static std::string perKey(size_t numBytes, size_t num)
+   {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%.2f", num ? (double)numBytes / num : 0.0);
+      return buffer;
+   }
+
+   static uint64_t next(uint64_t & seed)
+   {
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+      return seed;
+   }
+};
@@ -0,0 +1,119 @@
+/***********************************************************************
+ * Header:
+ *    BENCH ERASE
+ * Summary:
+ *    Benchmarks for removing many elements from a set at once
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "benchmark.h"
+
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH ERASE
+ * Bulk removal from a 2M element set, by key
+ * range and by predicate
+ ***********************************************/
+class BenchErase : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numKeys = 2000000;
+      std::vector<int> keys = randomKeys(numKeys);
+      custom::set<int> s(keys.begin(), keys.end(), 0);
+
+      for (size_t numWindow = 1000; numWindow < numKeys * 16; numWindow *= 32)
+      {
+         if (numWindow > numKeys / 2)
+            numWindow = numKeys / 2;
+         bench_eraseIterators(s, numWindow);
+         bench_eraseRange(s, numWindow);
+      }
+
+      // keep survivors percent of the elements
+      for (int survivors : { 99, 90, 75, 50, 10, 0 })
+      {
+         bench_eraseLoop(s, survivors);
+         bench_eraseIf(s, survivors);
+      }
+
+      report("Erase");
+   }
+
+   /***************************************
+    * ERASE ITERATORS
+    * erase(itBegin, itEnd): one element at a time
+    ***************************************/
+   void bench_eraseIterators(const custom::set<int> & sBase, size_t numWindow)
+   {
+      custom::set<int> s(sBase);
+      int lo = (int)(s.size() / 4);
+      int hi = lo + (int)numWindow;
+      double seconds = time([&]()
+      {
+         auto itBegin = s.lower_bound(lo);
+         auto itEnd = s.lower_bound(hi);
+         s.erase(itBegin, itEnd);
+      });
+      record("erase(first, last)", "window=" + std::to_string(numWindow), numWindow, seconds);
+   }
+
+   /***************************************
+    * ERASE RANGE
+    ***************************************/
+   void bench_eraseRange(const custom::set<int> & sBase, size_t numWindow)
+   {
+      custom::set<int> s(sBase);
+      int lo = (int)(s.size() / 4);
+      int hi = lo + (int)numWindow;
+      double seconds = time([&]()
+      {
+         s.erase_range(lo, hi);
+      });
+      record("erase_range", "window=" + std::to_string(numWindow), numWindow, seconds);
+   }
+
+   /***************************************
+    * ERASE LOOP
+    * erase(it) inside an iterator loop
+    ***************************************/
+   void bench_eraseLoop(const custom::set<int> & sBase, int survivors)
+   {
+      custom::set<int> s(sBase);
+      size_t numErased = 0;
+      double seconds = time([&]()
+      {
+         for (auto it = s.begin(); it != s.end(); )
+            if (it.operator*() % 100 >= survivors)
+            {
+               it = s.erase(it);
+               numErased++;
+            }
+            else
+               ++it;
+      });
+      record("erase loop", "survivors=" + std::to_string(survivors) + "%", sBase.size(), seconds);
+   }
+
+   /***************************************
+    * ERASE IF
+    ***************************************/
+   void bench_eraseIf(const custom::set<int> & sBase, int survivors)
+   {
+      custom::set<int> s(sBase);
+      double seconds = time([&]()
+      {
+         custom::erase_if(s, [survivors](int value) { return value % 100 >= survivors; });
+      });
+      record("erase_if", "survivors=" + std::to_string(survivors) + "%", sBase.size(), seconds);
+   }
+};
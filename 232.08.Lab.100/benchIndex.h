@@ -0,0 +1,93 @@
+/***********************************************************************
+ * Header:
+ *    BENCH INDEX
+ * Summary:
+ *    What a hash index costs a set on insert and erase and in memory,
+ *    and what it buys on find
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "hashIndex.h"
+#include "benchmark.h"
+
+#include <cstdio>      // for snprintf
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH INDEX
+ * The same work on a plain and an indexed set
+ ***********************************************/
+class BenchIndex : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numKeys = 1000000;
+      std::vector<int> keys = randomKeys(numKeys);
+      std::vector<int> probes = randomKeys(2 * numKeys, 2463534242ULL);
+      probes.resize(numKeys);   // about half of them hit
+
+      for (int isIndexed = 0; isIndexed < 2; isIndexed++)
+      {
+         std::string name = isIndexed ? "indexed" : "plain";
+         custom::set<int> s;
+         s.hash_indexed(isIndexed != 0);
+
+         record("insert", name, numKeys, time([&]()
+         {
+            for (int key : keys)
+               s.insert(key);
+         }));
+
+         size_t numFound = 0;
+         double seconds = time([&]()
+         {
+            for (int probe : probes)
+               numFound += s.find(probe) != s.end();
+         });
+         record("find", name + " hits=" + std::to_string(numFound), probes.size(), seconds);
+
+         numFound = 0;
+         seconds = time([&]()
+         {
+            for (int probe : probes)
+               numFound += s.contains(probe);
+         });
+         record("contains", name + " hits=" + std::to_string(numFound), probes.size(), seconds);
+
+         record("erase", name, numKeys / 2, time([&]()
+         {
+            for (size_t i = 0; i < numKeys / 2; i++)
+               s.erase(keys[i]);
+         }));
+      }
+
+      // the index grows by doubling, so reserving the same count
+      // gives the same table an indexed set has
+      struct Node { int data; };
+      custom::hash_index<int, Node> index;
+      index.reserve(numKeys);
+      size_t bytesNode = (sizeof(int) + 3 * sizeof(void *) + sizeof(bool) + sizeof(void *) - 1)
+                         / sizeof(void *) * sizeof(void *) + 16;
+      record("memory", "node bytes/key=" + perKey(bytesNode * numKeys, numKeys), 0, 0.0);
+      record("memory", "index bytes/key=" + perKey(index.memory(), numKeys), 0, 0.0);
+
+      report("Index");
+   }
+
+private:
+
+   static std::string perKey(size_t numBytes, size_t num)
+   {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%.2f", num ? (double)numBytes / num : 0.0);
+      return buffer;
+   }
+};
@@ -0,0 +1,172 @@
+/***********************************************************************
+ * Header:
+ *    BENCH LATENCY
+ * Summary:
+ *    Percentiles of single calls to custom::set and std::set: insert,
+ *    find, and erase in random order, insert in sorted order, and a
+ *    churn of inserts broken up by clear(). Throughput hides the calls
+ *    that stall; an unbalanced chain or a clear() of a large set shows
+ *    up at p99.9 and in the maximum.
+ *
+ *    Each call is timed by itself, so every value includes the cost of
+ *    reading the clock twice, a few tens of nanoseconds.
+ *
+ *    Each insert run also reports the shape of the tree it built: how
+ *    tall it grew and how deep a node sits on average.
+ *
+ *    Built with SET_LATENCY defined, custom::set also times its own
+ *    calls, and the histograms it kept are reported beside these.
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "latencyHistogram.h"
+#include "benchmark.h"
+
+#include <set>         // for std::set
+#include <string>
+#include <vector>
+
+/***********************************************
+ * BENCH LATENCY
+ * One histogram per kind of call
+ ***********************************************/
+class BenchLatency : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      std::vector<int> keys = randomKeys(NUM_RANDOM);
+      std::vector<int> probes = randomKeys(NUM_RANDOM, 2463534242ULL);
+      random<std::set<int>>   ("set=std",    keys, probes);
+      random<custom::set<int>>("set=custom", keys, probes);
+
+      sorted<std::set<int>>   ("set=std");
+      sorted<custom::set<int>>("set=custom");
+
+      churn<std::set<int>>   ("set=std");
+      churn<custom::set<int>>("set=custom");
+
+      report("Latency");
+   }
+
+private:
+
+   static const size_t NUM_RANDOM = 1000000;
+   static const size_t NUM_SORTED = 20000;     // a chain in custom::set
+   static const size_t NUM_CHURN  = 100000;    // inserts between clears
+   static const size_t NUM_ROUNDS = 10;
+
+   /*************************************************************
+    * RANDOM
+    * Insert every key, find every probe (about half hit), then
+    * erase every key, all in random order
+    *************************************************************/
+   template <class Set>
+   void random(const std::string & params, const std::vector<int> & keys,
+               const std::vector<int> & probes)
+   {
+      Set s;
+      custom::latency_histogram inserts;
+      for (int key : keys)
+      {
+         custom::latency_timer timer(inserts);
+         s.insert(key);
+      }
+      record_latency("insert", params + " order=random n=" + std::to_string(keys.size()),
+                     inserts);
+      record_shape(s);
+
+      custom::latency_histogram finds;
+      size_t numFound = 0;
+      for (int probe : probes)
+      {
+         custom::latency_timer timer(finds);
+         numFound += s.find(probe + (int)(probes.size() / 2)) != s.end();
+      }
+      record_latency("find", params + " hits=" + std::to_string(numFound), finds);
+
+      custom::latency_histogram erases;
+      for (int key : probes)
+      {
+         custom::latency_timer timer(erases);
+         s.erase(key);
+      }
+      record_latency("erase", params + " order=random", erases);
+      reportOwn(params, s);
+   }
+
+   /*************************************************************
+    * SORTED
+    * Ascending inserts: each one descends the whole chain in a
+    * tree that does not rebalance
+    *************************************************************/
+   template <class Set>
+   void sorted(const std::string & params)
+   {
+      Set s;
+      custom::latency_histogram inserts;
+      for (size_t i = 0; i < NUM_SORTED; i++)
+      {
+         custom::latency_timer timer(inserts);
+         s.insert((int)i);
+      }
+      record_latency("insert", params + " order=sorted n=" + std::to_string(NUM_SORTED),
+                     inserts);
+      record_shape(s);
+   }
+
+   /*************************************************************
+    * CHURN
+    * Rounds of random inserts, each ended by a clear(), all in
+    * one histogram: the clears are the tail
+    *************************************************************/
+   template <class Set>
+   void churn(const std::string & params)
+   {
+      std::vector<int> keys = randomKeys(NUM_CHURN, 88172645463325252ULL + NUM_CHURN);
+      Set s;
+      custom::latency_histogram calls;
+      custom::latency_histogram clears;
+      for (size_t iRound = 0; iRound < NUM_ROUNDS; iRound++)
+      {
+         for (int key : keys)
+         {
+            custom::latency_timer timer(calls);
+            s.insert(key);
+         }
+         custom::latency_histogram clear;
+         {
+            custom::latency_timer timer(clear);
+            s.clear();
+         }
+         calls += clear;
+         clears += clear;
+      }
+      record_latency("insert+clear", params + " n=" + std::to_string(NUM_CHURN), calls);
+      record_latency("clear", params + " n=" + std::to_string(NUM_CHURN), clears);
+   }
+
+   /*************************************************************
+    * REPORT OWN
+    * What an instrumented custom::set recorded about itself
+    *************************************************************/
+   template <class Set>
+   void reportOwn(const std::string &, const Set &)
+   {
+   }
+#ifdef SET_LATENCY
+   void reportOwn(const std::string & params, const custom::set<int> & s)
+   {
+      typedef custom::set<int> Set;
+      record_latency("insert", params + " source=set", s.latency(Set::LATENCY_INSERT));
+      record_latency("find",   params + " source=set", s.latency(Set::LATENCY_FIND));
+      record_latency("erase",  params + " source=set", s.latency(Set::LATENCY_ERASE));
+   }
+#endif
+};
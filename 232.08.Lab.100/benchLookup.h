@@ -0,0 +1,102 @@
+/***********************************************************************
+ * Header:
+ *    BENCH LOOKUP
+ * Summary:
+ *    Benchmark for set::find_batch and set::contains_batch against a
+ *    loop of find, on sets too large to stay in cache
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "benchmark.h"
+
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH LOOKUP
+ * Random probes, half of them hits
+ ***********************************************/
+class BenchLookup : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numProbes = 1000000;
+      for (size_t numKeys = 1 << 16; numKeys <= (1 << 22); numKeys <<= 3)
+      {
+         // the set holds the even keys
+         std::vector<int> keys = randomKeys(numKeys);
+         for (auto & key : keys)
+            key *= 2;
+         custom::set<int> s(keys.begin(), keys.end(), 0);
+
+         std::vector<int> probes = randomKeys(numProbes, 2463534242ULL);
+         for (auto & probe : probes)
+            probe = (int)(probe % (2 * numKeys));
+
+         bench_find(s, probes);
+         bench_findBatch(s, probes);
+         bench_containsBatch(s, probes);
+      }
+
+      report("Lookup");
+   }
+
+   /***************************************
+    * FIND
+    * One descent at a time
+    ***************************************/
+   void bench_find(custom::set<int> & s, const std::vector<int> & probes)
+   {
+      size_t numFound = 0;
+      double seconds = time([&]()
+      {
+         for (int probe : probes)
+            if (s.find(probe) != s.end())
+               numFound++;
+      });
+      record("find", "size=" + std::to_string(s.size()) +
+             " hits=" + std::to_string(numFound), probes.size(), seconds);
+   }
+
+   /***************************************
+    * FIND BATCH
+    ***************************************/
+   void bench_findBatch(const custom::set<int> & s, const std::vector<int> & probes)
+   {
+      std::vector<custom::set<int>::iterator> results(probes.size());
+      double seconds = time([&]()
+      {
+         s.find_batch(probes.begin(), probes.end(), results.begin());
+      });
+      size_t numFound = 0;
+      for (auto & it : results)
+         if (it != s.end())
+            numFound++;
+      record("find_batch", "size=" + std::to_string(s.size()) +
+             " hits=" + std::to_string(numFound), probes.size(), seconds);
+   }
+
+   /***************************************
+    * CONTAINS BATCH
+    ***************************************/
+   void bench_containsBatch(const custom::set<int> & s, const std::vector<int> & probes)
+   {
+      std::vector<char> results(probes.size());
+      double seconds = time([&]()
+      {
+         s.contains_batch(probes.begin(), probes.end(), results.begin());
+      });
+      size_t numFound = 0;
+      for (char result : results)
+         numFound += result;
+      record("contains_batch", "size=" + std::to_string(s.size()) +
+             " hits=" + std::to_string(numFound), probes.size(), seconds);
+   }
+};
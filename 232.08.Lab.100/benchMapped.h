@@ -0,0 +1,75 @@
+/***********************************************************************
+ * Header:
+ *    BENCH MAPPED
+ * Summary:
+ *    Startup benchmark: rebuilding a set from its source data against
+ *    mapping a file written by save_mapped(), then probing both
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "mappedSet.h"
+#include "benchmark.h"
+
+#include <cstdio>
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH MAPPED
+ * Time to a usable set, and lookups afterwards
+ ***********************************************/
+class BenchMapped : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numKeys = 4000000;
+      const char * path = "benchMapped.tmp";
+      std::vector<int> keys = randomKeys(numKeys);
+      std::vector<int> probes = randomKeys(1000000, 2463534242ULL);
+
+      custom::set<int> s;
+      record("startup", "insert each", numKeys, time([&]()
+      {
+         custom::set<int> sBuilt(keys.begin(), keys.end());
+         s.swap(sBuilt);
+      }));
+      record("startup", "bulk build", numKeys, time([&]()
+      {
+         custom::set<int> sBuilt(keys.begin(), keys.end(), 0);
+         s.swap(sBuilt);
+      }));
+      record("save", "", numKeys, time([&]() { custom::save_mapped(s, path); }));
+
+      custom::mapped_set<int> m;
+      record("startup", "mmap_open", numKeys, time([&]()
+      {
+         m = custom::mmap_open<int>(path);
+      }));
+
+      size_t numFound = 0;
+      double seconds = time([&]()
+      {
+         for (int probe : probes)
+            numFound += s.find(probe) != s.end();
+      });
+      record("find", "set hits=" + std::to_string(numFound), probes.size(), seconds);
+      numFound = 0;
+      seconds = time([&]()
+      {
+         for (int probe : probes)
+            numFound += m.contains(probe);
+      });
+      record("find", "mapped_set hits=" + std::to_string(numFound), probes.size(), seconds);
+
+      m.close();
+      std::remove(path);
+      report("Mapped");
+   }
+};
@@ -0,0 +1,86 @@
+/***********************************************************************
+ * Header:
+ *    BENCH PARALLEL
+ * Summary:
+ *    Scaling benchmark for set::parallel_for_each over thread counts
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "benchmark.h"
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/***********************************************
+ * BENCH PARALLEL
+ * Parallel scans of a large set
+ ***********************************************/
+class BenchParallel : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numKeys = 1000000;
+      std::vector<int> keys = randomKeys(numKeys);
+      custom::set<int> s(keys.begin(), keys.end());
+
+      bench_forEach(s);
+      for (size_t numThreads = 1; numThreads <= 8; numThreads *= 2)
+         bench_parallelForEach(s, numThreads);
+
+      report("Parallel");
+   }
+
+   // a little work per element so the scan is not all pointer chasing
+   static uint64_t work(int value)
+   {
+      uint64_t x = (uint64_t)value + 1;
+      for (int i = 0; i < 16; i++)
+      {
+         x ^= x << 13;
+         x ^= x >> 7;
+         x ^= x << 17;
+      }
+      return x;
+   }
+
+   /***************************************
+    * FOR EACH
+    * The single-threaded iterator loop
+    ***************************************/
+   void bench_forEach(const custom::set<int> & s)
+   {
+      uint64_t sum = 0;
+      double seconds = time([&]()
+      {
+         for (auto it = s.begin(); it != s.end(); ++it)
+            sum += work(*it);
+      });
+      record("for_each", "iterator sum=" + std::to_string(sum % 1000), s.size(), seconds);
+   }
+
+   /***************************************
+    * PARALLEL FOR EACH
+    ***************************************/
+   void bench_parallelForEach(const custom::set<int> & s, size_t numThreads)
+   {
+      std::atomic<uint64_t> sum(0);
+      double seconds = time([&]()
+      {
+         s.parallel_for_each([&sum](int value)
+         {
+            if (work(value) % 1024 == 0)
+               sum.fetch_add(1, std::memory_order_relaxed);
+         }, numThreads);
+      });
+      record("parallel_for_each", "threads=" + std::to_string(numThreads), s.size(), seconds);
+   }
+};
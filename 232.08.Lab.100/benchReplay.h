@@ -0,0 +1,217 @@
+/***********************************************************************
+ * Header:
+ *    BENCH REPLAY
+ * Summary:
+ *    Replay a trace written by set::trace() against custom::set, the
+ *    same with a hash index, std::set, sharded_set, and the concurrent
+ *    skip list, and report the throughput of the whole trace and the
+ *    latency percentiles of each kind of call.
+ *
+ *    The events are replayed back to back, not at the pace they were
+ *    captured, and a hashed key stands in for the key it came from.
+ *    Each set replays twice: once timed as a whole for throughput,
+ *    and once timing each call for the percentiles.
+ *
+ *    Given no trace, it captures one first from a custom::set under a
+ *    mixed workload: mostly finds of popular keys, some inserts and
+ *    erases, and a clear() now and then.
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "shardedSet.h"
+#include "skipList.h"
+#include "trace.h"
+#include "latencyHistogram.h"
+#include "benchmark.h"
+
+#include <cstdint>     // for int64_t
+#include <cstdio>      // for std::remove
+#include <iostream>    // for std::cerr
+#include <set>         // for std::set
+#include <string>
+#include <vector>
+
+/***********************************************
+ * BENCH REPLAY
+ * One trace, every kind of set
+ ***********************************************/
+class BenchReplay : public Benchmark
+{
+public:
+   BenchReplay(const std::string & path = "") : path(path) {}
+
+   void run()
+   {
+      reset();
+
+      std::vector<custom::trace_event> events;
+      std::string pathTrace = path.empty() ? capture() : path;
+      if (!custom::trace_load(pathTrace, events))
+      {
+         std::cerr << "Unable to read the trace " << pathTrace << "\n";
+         return;
+      }
+      if (path.empty())
+         std::remove(pathTrace.c_str());
+
+      std::string params = " events=" + std::to_string(events.size());
+      replay<std::set<int64_t>>("set=std" + params, events);
+      replay<custom::set<int64_t>>("set=custom" + params, events);
+      replay<custom::set<int64_t>>("set=custom_indexed" + params, events, true);
+      replay<custom::sharded_set<int64_t>>("set=sharded" + params, events);
+      replay<custom::concurrent_skiplist_set<int64_t>>("set=skiplist" + params, events);
+
+      report("Replay");
+   }
+
+private:
+
+   static const size_t NUM_CAPTURE = 1000000;
+   static const size_t NUM_KEYS = 200000;
+
+   /*************************************************************
+    * CAPTURE
+    * Trace a workload on a custom::set and return where
+    *************************************************************/
+   std::string capture()
+   {
+      std::string pathTrace = "benchReplay.tmp";
+      custom::trace_writer writer;
+      if (!writer.open(pathTrace))
+         return pathTrace;
+
+      custom::set<int64_t> s;
+      s.trace(&writer);
+      std::vector<int> keys = randomKeys(NUM_KEYS);
+      uint64_t seed = 2463534242ULL;
+      for (size_t i = 0; i < NUM_CAPTURE; i++)
+      {
+         seed ^= seed << 13;
+         seed ^= seed >> 7;
+         seed ^= seed << 17;
+         // squaring a uniform index makes the low ranks popular
+         uint64_t r = seed % NUM_KEYS;
+         int64_t key = keys[(size_t)(r * r / NUM_KEYS)];
+         switch (seed >> 60)
+         {
+            case 0: case 1: case 2:
+               s.insert(key);
+               break;
+            case 3:
+               s.erase(key);
+               break;
+            case 4:
+               s.contains(key);
+               break;
+            default:
+               s.find(key);
+         }
+         if (i % (NUM_CAPTURE / 4) == NUM_CAPTURE / 4 - 1)
+            s.clear();
+      }
+      writer.close();
+      return pathTrace;
+   }
+
+   /*************************************************************
+    * REPLAY
+    * Throughput of the whole trace, then the latency of each
+    * kind of call
+    *************************************************************/
+   template <class Set>
+   void replay(const std::string & params, const std::vector<custom::trace_event> & events,
+               bool isIndexed = false)
+   {
+      {
+         Set s;
+         setUp(s, isIndexed);
+         size_t numFound = 0;
+         double seconds = time([&]()
+         {
+            for (const custom::trace_event & event : events)
+               numFound += apply(s, event);
+         });
+         record("replay", params + " hits=" + std::to_string(numFound), events.size(), seconds);
+      }
+
+      Set s;
+      setUp(s, isIndexed);
+      custom::latency_histogram latencies[custom::TRACE_OP_MAX + 1];
+      size_t numFound[custom::TRACE_OP_MAX + 1] = {};
+      for (const custom::trace_event & event : events)
+      {
+         custom::latency_timer timer(latencies[event.op]);
+         numFound[event.op] += apply(s, event);
+      }
+      const char * names[] = { "", "insert", "erase", "find", "contains", "clear" };
+      for (int op = custom::TRACE_INSERT; op <= custom::TRACE_OP_MAX; op++)
+      {
+         if (latencies[op].empty())
+            continue;
+         bool isLookup = op == custom::TRACE_FIND || op == custom::TRACE_CONTAINS;
+         record_latency(names[op],
+                        params + (isLookup ? " hits=" + std::to_string(numFound[op]) : ""),
+                        latencies[op]);
+      }
+   }
+
+   /*************************************************************
+    * APPLY
+    * One event; true for a find or contains that hit
+    *************************************************************/
+   template <class Set>
+   static bool apply(Set & s, const custom::trace_event & event)
+   {
+      switch (event.op)
+      {
+         case custom::TRACE_INSERT:
+            s.insert(event.key);
+            return false;
+         case custom::TRACE_ERASE:
+            s.erase(event.key);
+            return false;
+         case custom::TRACE_FIND:
+            return s.find(event.key) != s.end();
+         case custom::TRACE_CONTAINS:
+            return contains(s, event.key);
+         case custom::TRACE_CLEAR:
+            s.clear();
+            return false;
+      }
+      return false;
+   }
+
+   // contains() where the set has one; std::set only gets it in C++20
+   template <class Set>
+   static bool contains(Set & s, int64_t key)
+   {
+      return s.find(key) != s.end();
+   }
+   static bool contains(custom::set<int64_t> & s, int64_t key)
+   {
+      return s.contains(key);
+   }
+   static bool contains(custom::sharded_set<int64_t> & s, int64_t key)
+   {
+      return s.contains(key);
+   }
+   static bool contains(custom::concurrent_skiplist_set<int64_t> & s, int64_t key)
+   {
+      return s.contains(key);
+   }
+
+   template <class Set>
+   static void setUp(Set &, bool)
+   {
+   }
+   static void setUp(custom::set<int64_t> & s, bool isIndexed)
+   {
+      s.hash_indexed(isIndexed);
+   }
+
+   std::string path;   // the trace to replay, or empty to capture one
+};
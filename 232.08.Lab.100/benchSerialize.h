@@ -0,0 +1,85 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SERIALIZE
+ * Summary:
+ *    Throughput of set::serialize and set::deserialize, in MB/s of
+ *    encoded bytes, for integer and string keys
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "set.h"
+#include "benchmark.h"
+
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/***********************************************
+ * BENCH SERIALIZE
+ * Round trips through a string stream
+ ***********************************************/
+class BenchSerialize : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      std::vector<int> keys = randomKeys(1000000);
+      std::vector<uint64_t> ids;
+      for (int key : keys)
+         ids.push_back((uint64_t)key * 37 + 1000000000000ULL);
+      bench_roundTrip("uint64", ids);
+
+      std::vector<std::string> urls;
+      for (size_t i = 0; i < 200000; i++)
+         urls.push_back("https://example.com/items/" + std::to_string(keys[i]) + "/view");
+      bench_roundTrip("url", urls);
+
+      report("Serialize");
+   }
+
+   /***************************************
+    * ROUND TRIP
+    * Serialize, then deserialize into another set,
+    * against inserting the unsorted source again
+    ***************************************/
+   template <class T>
+   void bench_roundTrip(const std::string & name, const std::vector<T> & values)
+   {
+      custom::set<T> s(values.begin(), values.end(), 0);
+      std::stringstream stream;
+      double seconds = time([&]() { s.serialize(stream); });
+      std::string bytes = stream.str();
+      record("serialize", name + " " + megabytesPerSecond(bytes.size(), seconds),
+             s.size(), seconds);
+
+      custom::set<T> sRead;
+      std::stringstream streamIn(bytes);
+      seconds = time([&]() { sRead.deserialize(streamIn); });
+      record("deserialize", name + " " + megabytesPerSecond(bytes.size(), seconds),
+             sRead.size(), seconds);
+
+      custom::set<T> sInsert;
+      seconds = time([&]()
+      {
+         for (const T & value : values)
+            sInsert.insert(value);
+      });
+      record("insert each", name, sInsert.size(), seconds);
+   }
+
+   // encoded bytes over time, as text for the report
+   static std::string megabytesPerSecond(size_t numBytes, double seconds)
+   {
+      std::ostringstream out;
+      out.setf(std::ios::fixed);
+      out.precision(0);
+      out << (numBytes / 1e6) / seconds << "MB/s " << numBytes / 1000 << "KB";
+      return out.str();
+   }
+};
@@ -0,0 +1,115 @@
+/***********************************************************************
+ * Source:
+ *    Benchmark
+ * Summary:
+ *    Driver to measure the performance of set.h and its variants.
+ *    Build with optimizations and without DEBUG, for example:
+ *       g++ -std=c++14 -O2 -pthread benchSet.cpp -o benchSet
+ *    or, on Linux, just "make bench". Usage:
+ *       benchSet [--json=FILE] [--max=N] [--trace=FILE] [SUITE ...]
+ *    runs the named suites (all of them when none are named), writes
+ *    every measurement to FILE as JSON, stops the Compare suite at N
+ *    keys, and has the Replay suite replay a trace written by
+ *    set::trace() instead of one it captures itself.
+ *
+ *    Built with BENCH_ALLOCS ("make allocs"), it also counts every
+ *    allocation the benchmarks time. That puts shared atomics on the
+ *    path of every operator new, which the multi-threaded suites
+ *    would then measure, so the plain build leaves it out.
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#include "benchShardedSet.h"   // for the sharded set benchmarks
+#include "benchSkipList.h"     // for the skip list benchmarks
+#include "benchParallel.h"     // for the parallel traversal benchmarks
+#include "benchBuild.h"        // for the bulk construction benchmarks
+#include "benchBatch.h"        // for the batch insert benchmarks
+#include "benchLookup.h"       // for the batched lookup benchmarks
+#include "benchErase.h"        // for the bulk erase benchmarks
+#include "benchMapped.h"       // for the memory-mapped startup benchmarks
+#include "benchSerialize.h"    // for the serialization throughput benchmarks
+#include "benchCompressed.h"   // for the compressed set memory benchmarks
+#include "benchBitmap.h"       // for the bitmap set memory and set algebra benchmarks
+#include "benchIndex.h"        // for the hash index trade-off benchmarks
+#include "benchCompare.h"      // for custom::set against std::set
+#include "benchLatency.h"      // for the latency percentiles of single calls
+#include "benchReplay.h"       // for replaying a captured trace
+
+#ifdef BENCH_ALLOCS
+#include "allocHooks.h"         // count every allocation the benchmarks make
+#endif // BENCH_ALLOCS
+
+#include <cstdlib>    // for strtoull
+#include <cstring>    // for strncmp
+#include <fstream>    // for std::ofstream
+#include <iostream>   // for std::cerr
+#include <string>
+#include <vector>
+#include <algorithm>  // for std::find
+
+/**********************************************************************
+ * MAIN
+ * Run the chosen benchmarks and report the timings
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   std::vector<std::string> suites;
+   std::string pathJson;
+   std::string pathTrace;
+   size_t sizeMax = 10000000;
+   for (int i = 1; i < argc; i++)
+   {
+      if (strncmp(argv[i], "--json=", 7) == 0)
+         pathJson = argv[i] + 7;
+      else if (strncmp(argv[i], "--max=", 6) == 0)
+         sizeMax = (size_t)strtoull(argv[i] + 6, nullptr, 10);
+      else if (strncmp(argv[i], "--trace=", 8) == 0)
+         pathTrace = argv[i] + 8;
+      else if (argv[i][0] == '-')
+      {
+         std::cerr << "Usage: " << argv[0] << " [--json=FILE] [--max=N] [--trace=FILE] [SUITE ...]\n";
+         return 1;
+      }
+      else
+         suites.push_back(argv[i]);
+   }
+
+   std::ofstream fout;
+   if (!pathJson.empty())
+   {
+      fout.open(pathJson.c_str());
+      if (!fout)
+      {
+         std::cerr << "Unable to write " << pathJson << "\n";
+         return 1;
+      }
+      Benchmark::json_begin(fout);
+   }
+
+   if (!Benchmark::counters_available())
+      std::cerr << "Hardware counters unavailable (see perf_event_paranoid); timing only\n";
+
+   auto isChosen = [&suites](const char * name)
+   {
+      return suites.empty() || std::find(suites.begin(), suites.end(), name) != suites.end();
+   };
+   if (isChosen("ShardedSet")) BenchShardedSet().run();
+   if (isChosen("SkipList"))   BenchSkipList().run();
+   if (isChosen("Parallel"))   BenchParallel().run();
+   if (isChosen("Build"))      BenchBuild().run();
+   if (isChosen("Batch"))      BenchBatch().run();
+   if (isChosen("Lookup"))     BenchLookup().run();
+   if (isChosen("Erase"))      BenchErase().run();
+   if (isChosen("Mapped"))     BenchMapped().run();
+   if (isChosen("Serialize"))  BenchSerialize().run();
+   if (isChosen("Compressed")) BenchCompressed().run();
+   if (isChosen("Bitmap"))     BenchBitmap().run();
+   if (isChosen("Index"))      BenchIndex().run();
+   if (isChosen("Compare"))    BenchCompare(sizeMax).run();
+   if (isChosen("Latency"))    BenchLatency().run();
+   if (isChosen("Replay"))     BenchReplay(pathTrace).run();
+
+   Benchmark::json_end();
+   return 0;
+}
@@ -0,0 +1,72 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SHARDED SET
+ * Summary:
+ *    Scaling benchmark for sharded_set over thread and shard counts
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "shardedSet.h"
+#include "benchmark.h"
+
+#include <thread>
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH SHARDED SET
+ * Concurrent insert throughput of sharded_set
+ ***********************************************/
+class BenchShardedSet : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numKeys = 200000;
+      std::vector<int> keys = randomKeys(numKeys);
+
+      for (size_t numThreads = 1; numThreads <= 8; numThreads *= 2)
+      {
+         bench_insert<1,  std::mutex>      (keys, numThreads, "mutex");
+         bench_insert<4,  std::mutex>      (keys, numThreads, "mutex");
+         bench_insert<16, std::mutex>      (keys, numThreads, "mutex");
+         bench_insert<64, std::mutex>      (keys, numThreads, "mutex");
+         bench_insert<16, custom::spinlock>(keys, numThreads, "spinlock");
+         bench_insert<64, custom::spinlock>(keys, numThreads, "spinlock");
+      }
+
+      report("ShardedSet");
+   }
+
+   /***************************************
+    * INSERT
+    * Every thread inserts its own slice of the keys
+    ***************************************/
+   template <size_t N, class Lock>
+   void bench_insert(const std::vector<int> & keys, size_t numThreads,
+                     const char * lockName)
+   {
+      custom::sharded_set<int, N, Lock> s;
+      double seconds = time([&]()
+      {
+         std::vector<std::thread> threads;
+         for (size_t t = 0; t < numThreads; t++)
+            threads.push_back(std::thread([&s, &keys, t, numThreads]()
+            {
+               for (size_t i = t; i < keys.size(); i += numThreads)
+                  s.insert(keys[i]);
+            }));
+         for (auto & thread : threads)
+            thread.join();
+      });
+
+      record("insert", "threads=" + std::to_string(numThreads) +
+                       " shards=" + std::to_string(N) + " " + lockName,
+             keys.size(), seconds);
+   }
+};
@@ -0,0 +1,114 @@
+/***********************************************************************
+ * Header:
+ *    BENCH SKIP LIST
+ * Summary:
+ *    Scaling benchmark for concurrent_skiplist_set against a locked
+ *    set and a sharded_set under a mixed insert/erase/find workload
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "skipList.h"
+#include "shardedSet.h"
+#include "set.h"
+#include "benchmark.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+
+/***********************************************
+ * BENCH SKIP LIST
+ * Mixed workload throughput over thread counts
+ ***********************************************/
+class BenchSkipList : public Benchmark
+{
+public:
+   void run()
+   {
+      reset();
+
+      const size_t numOps = 400000;
+      std::vector<int> keys = randomKeys(numOps);
+      for (auto & key : keys)
+         key %= 65536;   // small key space so erases find something
+
+      for (size_t numThreads = 1; numThreads <= 8; numThreads *= 2)
+      {
+         bench_skipList(keys, numThreads);
+         bench_sharded (keys, numThreads);
+         bench_locked  (keys, numThreads);
+      }
+
+      report("SkipList");
+   }
+
+   /***************************************
+    * MIXED
+    * Each thread works through its slice of the keys:
+    * half inserts, a quarter erases, a quarter finds
+    ***************************************/
+   template <class Insert, class Erase, class Find>
+   double mixed(const std::vector<int> & keys, size_t numThreads,
+                Insert insert, Erase erase, Find find)
+   {
+      return time([&]()
+      {
+         std::vector<std::thread> threads;
+         for (size_t t = 0; t < numThreads; t++)
+            threads.push_back(std::thread([&, t]()
+            {
+               for (size_t i = t; i < keys.size(); i += numThreads)
+                  switch (i & 3)
+                  {
+                     case 0:
+                     case 1:  insert(keys[i]); break;
+                     case 2:  erase(keys[i]);  break;
+                     default: find(keys[i]);   break;
+                  }
+            }));
+         for (auto & thread : threads)
+            thread.join();
+      });
+   }
+
+   // lock-free skip list
+   void bench_skipList(const std::vector<int> & keys, size_t numThreads)
+   {
+      custom::concurrent_skiplist_set<int> s;
+      double seconds = mixed(keys, numThreads,
+         [&](int k) { s.insert(k);   },
+         [&](int k) { s.erase(k);    },
+         [&](int k) { s.contains(k); });
+      record("mixed", "threads=" + std::to_string(numThreads) + " skiplist",
+             keys.size(), seconds);
+   }
+
+   // sixteen locked shards
+   void bench_sharded(const std::vector<int> & keys, size_t numThreads)
+   {
+      custom::sharded_set<int, 16> s;
+      double seconds = mixed(keys, numThreads,
+         [&](int k) { s.insert(k); },
+         [&](int k) { s.erase(k);  },
+         [&](int k) { s.contains(k); });
+      record("mixed", "threads=" + std::to_string(numThreads) + " sharded16",
+             keys.size(), seconds);
+   }
+
+   // one set behind one mutex
+   void bench_locked(const std::vector<int> & keys, size_t numThreads)
+   {
+      custom::set<int> s;
+      std::mutex lock;
+      double seconds = mixed(keys, numThreads,
+         [&](int k) { std::lock_guard<std::mutex> g(lock); s.insert(k); },
+         [&](int k) { std::lock_guard<std::mutex> g(lock); s.erase(k);  },
+         [&](int k) { std::lock_guard<std::mutex> g(lock); s.find(k);   });
+      record("mixed", "threads=" + std::to_string(numThreads) + " locked set",
+             keys.size(), seconds);
+   }
+};
@@ -0,0 +1,456 @@
+/***********************************************************************
+ * Header:
+ *    BENCHMARK
+ * Summary:
+ *    The base class to all the benchmark classes. Every report goes
+ *    to the console and, once json_begin() names a stream, to that
+ *    stream as well as one JSON object per measurement. Where the
+ *    hardware counters can be read, each measurement also carries the
+ *    cycles, instructions, and misses per operation of what it timed.
+ *    A measurement made call by call carries a latency histogram and
+ *    reports its percentiles. One made on a custom tree can carry the
+ *    tree's shape, so a tree gone deep shows beside what it cost.
+ *    When the program hooks operator new (allocHooks.h, as the build
+ *    "make allocs" makes does), each also carries the allocations of
+ *    what it timed: how many and how many bytes per operation, the
+ *    peak, and how many of each size.
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <chrono>    // for std::chrono::steady_clock
+#include <iostream>  // for std::cout
+#include <iomanip>   // for std::setw
+#include <ostream>   // for std::ostream
+#include <sstream>   // for std::istringstream
+#include <string>    // for std::string
+#include <vector>    // for std::vector
+#include <cstdint>   // for uint64_t
+#include <algorithm> // for std::remove
+
+#include "perfCounters.h"
+#include "latencyHistogram.h"
+#include "bst.h"     // for custom::tree_stats
+#include "allocTracker.h"
+
+class Benchmark
+{
+public:
+   Benchmark() { reset(); }
+
+   /*************************************************************
+    * JSON BEGIN and JSON END
+    * Until json_end(), also write every measurement to out as
+    * { "benchmarks": [ {...}, ... ] }
+    *************************************************************/
+   static void json_begin(std::ostream & out)
+   {
+      jsonStream() = &out;
+      jsonCount() = 0;
+      out << "{\n  \"benchmarks\": [";
+   }
+   static void json_end()
+   {
+      if (!jsonStream())
+         return;
+      *jsonStream() << "\n  ]\n}\n";
+      jsonStream() = nullptr;
+   }
+
+   // whether time() can read any hardware counter here
+   static bool counters_available()
+   {
+      return perfCounters().isAvailable();
+   }
+
+private:
+   // one measurement: what was run, on how many elements, how long it
+   // took, what the hardware counted meanwhile, when each call was
+   // timed how long each took, the shape of the tree it ran on, and
+   // what it allocated
+   struct Result
+   {
+      std::string name;
+      std::string params;
+      size_t      numOps;
+      double      seconds;
+      PerfCounters::Reading counters;
+      custom::latency_histogram latency;
+      bool        hasShape;
+      custom::tree_stats shape;
+      custom::alloc_stats allocs;
+   };
+
+   // the percentiles every latency report shows
+   static const std::vector<double> & percentiles()
+   {
+      static const std::vector<double> values = { 50.0, 90.0, 99.0, 99.9 };
+      return values;
+   }
+
+   std::vector<Result> results;
+
+   // opened on the first time(), shared by every benchmark
+   static PerfCounters & perfCounters()
+   {
+      static PerfCounters counters;
+      return counters;
+   }
+   // what time() counted since the last record() or take_counters()
+   static PerfCounters::Reading & pendingCounters()
+   {
+      static PerfCounters::Reading reading;
+      return reading;
+   }
+
+   // what time() allocated since the last record() or take_allocs()
+   static custom::alloc_stats & pendingAllocs()
+   {
+      static custom::alloc_stats stats = {};
+      return stats;
+   }
+
+   // the JSON stream, if any, and how many objects went to it
+   static std::ostream * & jsonStream()
+   {
+      static std::ostream * pOut = nullptr;
+      return pOut;
+   }
+   static size_t & jsonCount()
+   {
+      static size_t num = 0;
+      return num;
+   }
+
+   /*************************************************************
+    * JSON STRING
+    * A quoted, escaped JSON string
+    *************************************************************/
+   static std::string jsonString(const std::string & text)
+   {
+      std::string quoted = "\"";
+      for (char c : text)
+      {
+         if (c == '"' || c == '\\')
+            quoted += '\\';
+         if ((unsigned char)c < 0x20)
+            quoted += ' ';
+         else
+            quoted += c;
+      }
+      return quoted + "\"";
+   }
+
+   /*************************************************************
+    * JSON WRITE
+    * One measurement. The key=value words of its params become
+    * fields of "params", so a script need not parse the label.
+    *************************************************************/
+   static void jsonWrite(std::ostream & out, const char * suite, const Result & result)
+   {
+      out << (jsonCount()++ ? ",\n" : "\n")
+          << "    { \"suite\": " << jsonString(suite)
+          << ", \"name\": " << jsonString(result.name)
+          << ", \"label\": " << jsonString(result.params)
+          << ", \"params\": {";
+      std::istringstream words(result.params);
+      std::string word;
+      size_t numParams = 0;
+      while (words >> word)
+      {
+         size_t iEquals = word.find('=');
+         if (iEquals == std::string::npos || iEquals == 0)
+            continue;
+         out << (numParams++ ? ", " : " ")
+             << jsonString(word.substr(0, iEquals)) << ": "
+             << jsonString(word.substr(iEquals + 1));
+      }
+      out << (numParams ? " }" : "}")
+          << ", \"ops\": " << result.numOps
+          << ", \"seconds\": " << std::setprecision(9) << result.seconds
+          << ", \"ns_per_op\": " << std::setprecision(6)
+          << (result.numOps ? result.seconds * 1e9 / result.numOps : 0.0);
+      if (!result.counters.empty() && result.numOps)
+      {
+         out << ", \"counters_per_op\": {";
+         size_t numCounters = 0;
+         for (int i = 0; i < PerfCounters::NUM_EVENTS; i++)
+            if (result.counters.isValid[i])
+               out << (numCounters++ ? ", " : " ")
+                   << jsonString(PerfCounters::name((PerfCounters::Event)i)) << ": "
+                   << result.counters.counts[i] / result.numOps;
+         out << " }";
+      }
+      if (!result.latency.empty())
+      {
+         out << ", \"latency_ns\": { \"min\": " << result.latency.min()
+             << ", \"mean\": " << result.latency.mean();
+         for (double percent : percentiles())
+            out << ", \"p" << percentLabel(percent) << "\": " << result.latency.percentile(percent);
+         out << ", \"max\": " << result.latency.max() << " }";
+      }
+      if (result.hasShape)
+      {
+         const custom::tree_stats & shape = result.shape;
+         out << ", \"shape\": { \"nodes\": " << shape.numNodes
+             << ", \"height\": " << shape.height
+             << ", \"depth_avg\": " << shape.depthAverage
+             << ", \"depth_max\": " << shape.depthMax
+             << ", \"bytes_per_node\": " << shape.bytesNode
+             << ", \"bytes\": " << shape.bytesNodes
+             << ", \"valid\": " << (shape.isValid ? "true" : "false")
+             << ", \"red_black\": " << (shape.isRedBlack ? "true" : "false")
+             << ", \"black_height\": " << shape.blackHeight << " }";
+      }
+      if (!result.allocs.empty() && result.numOps)
+      {
+         const custom::alloc_stats & allocs = result.allocs;
+         out << ", \"allocs\": { \"allocs_per_op\": " << (double)allocs.numAllocs / result.numOps
+             << ", \"frees_per_op\": " << (double)allocs.numFrees / result.numOps
+             << ", \"bytes_per_op\": " << (double)allocs.bytesAllocated / result.numOps
+             << ", \"peak_bytes\": " << allocs.bytesPeak
+             << ", \"sizes\": {";
+         size_t numSizes = 0;
+         for (size_t i = 0; i < custom::ALLOC_SIZE_CLASSES; i++)
+            if (allocs.sizeCounts[i])
+               out << (numSizes++ ? ", " : " ")
+                   << jsonString(std::to_string(custom::alloc_stats::sizeClassMax(i))) << ": "
+                   << allocs.sizeCounts[i];
+         out << (numSizes ? " } }" : "} }");
+      }
+      out << " }";
+   }
+
+   // 99.9 as "999", the way latency percentiles are usually named
+   static std::string percentLabel(double percent)
+   {
+      std::ostringstream label;
+      label << percent;
+      std::string text = label.str();
+      text.erase(std::remove(text.begin(), text.end(), '.'), text.end());
+      return text;
+   }
+
+protected:
+   /*************************************************************
+    * RESET
+    * Forget the previous measurements
+    *************************************************************/
+   void reset()
+   {
+      results.clear();
+   }
+
+   /*************************************************************
+    * TIME
+    * Wall-clock seconds for one call of f. The hardware counters
+    * and the allocation counts run over the same call and add up
+    * until the next record().
+    *************************************************************/
+   template <class F>
+   static double time(F f)
+   {
+      PerfCounters & counters = perfCounters();
+      custom::alloc_scope allocs;
+      counters.start();
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto finish = std::chrono::steady_clock::now();
+      pendingCounters() += counters.stop();
+      pendingAllocs() += allocs.stats();
+      return std::chrono::duration<double>(finish - start).count();
+   }
+
+   /*************************************************************
+    * TAKE COUNTERS and TAKE ALLOCS
+    * What time() counted since the last record() or take,
+    * for a benchmark that adds up several kinds of timings
+    * before it records any of them
+    *************************************************************/
+   static PerfCounters::Reading take_counters()
+   {
+      PerfCounters::Reading reading = pendingCounters();
+      pendingCounters() = PerfCounters::Reading();
+      return reading;
+   }
+   static custom::alloc_stats take_allocs()
+   {
+      custom::alloc_stats stats = pendingAllocs();
+      pendingAllocs() = custom::alloc_stats();
+      return stats;
+   }
+
+   /*************************************************************
+    * RECORD
+    * Remember a measurement of numOps operations, with what the
+    * counters and allocations were during the time() calls since
+    * the last one
+    *************************************************************/
+   void record(const std::string & name, const std::string & params,
+               size_t numOps, double seconds)
+   {
+      results.push_back(Result{ name, params, numOps, seconds, take_counters(),
+                                custom::latency_histogram(), false, custom::tree_stats(),
+                                take_allocs() });
+   }
+   void record(const std::string & name, const std::string & params,
+               size_t numOps, double seconds, const PerfCounters::Reading & counters,
+               const custom::alloc_stats & allocs = custom::alloc_stats())
+   {
+      results.push_back(Result{ name, params, numOps, seconds, counters,
+                                custom::latency_histogram(), false, custom::tree_stats(),
+                                allocs });
+   }
+
+   /*************************************************************
+    * RECORD LATENCY
+    * Remember calls timed one at a time, in nanoseconds. The
+    * time is what the calls took in all.
+    *************************************************************/
+   void record_latency(const std::string & name, const std::string & params,
+                       const custom::latency_histogram & latency)
+   {
+      results.push_back(Result{ name, params, (size_t)latency.count(),
+                                (double)latency.total() * 1e-9, take_counters(), latency,
+                                false, custom::tree_stats(), take_allocs() });
+   }
+
+   /*************************************************************
+    * RECORD SHAPE
+    * The shape of the tree the last measurement ran on
+    *************************************************************/
+   void record_shape(const custom::tree_stats & stats)
+   {
+      if (results.empty())
+         return;
+      results.back().hasShape = true;
+      results.back().shape = stats;
+   }
+   template <class Set>
+   void record_shape(const Set & s)
+   {
+      custom::tree_stats stats;
+      if (shape_of(s, stats))
+         record_shape(stats);
+   }
+
+   // a custom::set has a tree to show; any other set does not
+   template <class T>
+   static bool shape_of(const custom::set<T> & s, custom::tree_stats & stats)
+   {
+      stats = s.stats();
+      return true;
+   }
+   template <class Set>
+   static bool shape_of(const Set &, custom::tree_stats &)
+   {
+      return false;
+   }
+
+   /*************************************************************
+    * RANDOM KEYS
+    * A reproducible shuffle of 0..n-1 (xorshift so every
+    * platform produces the same sequence)
+    *************************************************************/
+   static std::vector<int> randomKeys(size_t n, uint64_t seed = 88172645463325252ULL)
+   {
+      std::vector<int> keys(n);
+      for (size_t i = 0; i < n; i++)
+         keys[i] = (int)i;
+      for (size_t i = n; i > 1; i--)
+      {
+         seed ^= seed << 13;
+         seed ^= seed >> 7;
+         seed ^= seed << 17;
+         std::swap(keys[i - 1], keys[seed % i]);
+      }
+      return keys;
+   }
+
+   /*************************************************************
+    * REPORT
+    * Display one line per measurement
+    *************************************************************/
+   void report(const char * name)
+   {
+      std::cout << name << ":\n";
+      std::cout.setf(std::ios::fixed | std::ios::showpoint);
+      for (auto & result : results)
+      {
+         double nsPerOp = result.numOps ? result.seconds * 1e9 / result.numOps : 0.0;
+         std::cout << "\t" << std::left  << std::setw(24) << result.name
+                   << std::setw(28) << result.params
+                   << std::right
+                   << std::setprecision(3) << std::setw(12) << result.seconds * 1e3 << " ms"
+                   << std::setprecision(1) << std::setw(12) << nsPerOp << " ns/op";
+         if (result.numOps)
+            reportCounters(result.counters, result.numOps);
+         if (!result.latency.empty())
+            reportLatency(result.latency);
+         if (result.hasShape)
+            reportShape(result.shape);
+         if (!result.allocs.empty() && result.numOps)
+            reportAllocs(result.allocs, result.numOps);
+         std::cout << "\n";
+         if (jsonStream())
+            jsonWrite(*jsonStream(), name, result);
+      }
+      if (jsonStream())
+         jsonStream()->flush();
+   }
+
+private:
+   /*************************************************************
+    * REPORT COUNTERS
+    * The valid counters per operation, on the end of the line
+    *************************************************************/
+   static void reportCounters(const PerfCounters::Reading & counters, size_t numOps)
+   {
+      const char * labels[] = { "cyc", "ins", "L1", "LLC", "br", "TLB" };
+      for (int i = 0; i < PerfCounters::NUM_EVENTS; i++)
+         if (counters.isValid[i])
+            std::cout << "  " << labels[i] << std::setprecision(1)
+                      << std::setw(8) << counters.counts[i] / numOps;
+   }
+
+   /*************************************************************
+    * REPORT LATENCY
+    * The percentiles and the maximum, in nanoseconds
+    *************************************************************/
+   static void reportLatency(const custom::latency_histogram & latency)
+   {
+      for (double percent : percentiles())
+         std::cout << "  p" << percentLabel(percent) << " " << std::setw(8)
+                   << latency.percentile(percent);
+      std::cout << "  max " << std::setw(10) << latency.max();
+   }
+
+   /*************************************************************
+    * REPORT SHAPE
+    * Height, average depth, and bytes per node of the tree, and
+    * whether it still holds as a search tree and a red-black tree
+    *************************************************************/
+   static void reportShape(const custom::tree_stats & shape)
+   {
+      std::cout << "  height " << std::setw(6) << shape.height
+                << "  depth " << std::setprecision(1) << std::setw(8) << shape.depthAverage
+                << "  " << shape.bytesNode << " B/node"
+                << (!shape.isValid ? "  INVALID" : shape.isRedBlack ? "  red-black" : "");
+   }
+
+   /*************************************************************
+    * REPORT ALLOCS
+    * Allocations, frees, and bytes per operation, and the peak
+    *************************************************************/
+   static void reportAllocs(const custom::alloc_stats & allocs, size_t numOps)
+   {
+      std::cout << "  alloc/op " << std::setprecision(2) << std::setw(6)
+                << (double)allocs.numAllocs / numOps
+                << "  free/op " << std::setw(6) << (double)allocs.numFrees / numOps
+                << "  B/op " << std::setprecision(1) << std::setw(8)
+                << (double)allocs.bytesAllocated / numOps
+                << "  peak " << std::setw(10) << allocs.bytesPeak << " B";
+   }
+};
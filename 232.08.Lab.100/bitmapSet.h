@@ -0,0 +1,953 @@
+/***********************************************************************
+ * Header:
+ *    Bitmap Set
+ * Summary:
+ *    A set of 32-bit unsigned integers in the style of a roaring
+ *    bitmap. The high 16 bits of a key pick a chunk; each chunk keeps
+ *    the low 16 bits of its keys in whichever container is smallest:
+ *
+ *        ARRAY  : the sorted values, 2 bytes each, up to 4096 of them
+ *        BITMAP : 65536 bits, 8KB, for anything fuller than that
+ *        RUN    : (start, length - 1) pairs, for long consecutive stretches
+ *
+ *    Dense keys cost a bit or two each instead of a BNode. Containers
+ *    switch between ARRAY and BITMAP on their own as they fill and
+ *    empty; run_optimize() turns the ones that compress better as runs
+ *    into RUN containers. Changing a RUN container turns it back into
+ *    an ARRAY or BITMAP first.
+ *
+ *    Union and intersection work a chunk at a time. Two bitmaps are
+ *    combined 128 bits per instruction with SSE2 or NEON.
+ *
+ *    This will contain the class definition of:
+ *        bitmap_set                : A compressed set of uint32_t
+ *        bitmap_set::iterator      : Forward iterator, in order
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>          // for uint16_t, uint32_t and uint64_t
+#include <vector>           // for std::vector
+#include <utility>          // for std::pair
+#include <algorithm>        // for std::lower_bound, std::set_union and std::set_intersection
+#include <initializer_list> // for std::initializer_list
+
+// two 64-bit words per instruction when combining bitmaps
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITMAP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BITMAP_NEON
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>         // for _BitScanForward64
+#endif
+
+class TestBitmapSet;   // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * BITMAP SET
+ * Chunks of 65536 keys, each in the container
+ * that holds its keys in the fewest bytes
+ ***********************************************/
+class bitmap_set
+{
+   friend class ::TestBitmapSet; // give unit tests access to the privates
+public:
+
+   //
+   // Construct
+   //
+   bitmap_set() : numElements(0)
+   {
+   }
+   bitmap_set(const std::initializer_list <uint32_t> & il) : numElements(0)
+   {
+      insert(il);
+   }
+   template <class Iterator>
+   bitmap_set(Iterator first, Iterator last) : numElements(0)
+   {
+      insert(first, last);
+   }
+
+   //
+   // Assign
+   //
+   void swap(bitmap_set & rhs) noexcept
+   {
+      keys.swap(rhs.keys);
+      containers.swap(rhs.containers);
+      std::swap(numElements, rhs.numElements);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end()   const;
+
+   //
+   // Access
+   //
+   iterator find(uint32_t t) const;
+   iterator lower_bound(uint32_t t) const;
+   bool contains(uint32_t t) const
+   {
+      size_t iChunk = findChunk((uint16_t)(t >> 16));
+      return iChunk < keys.size() && containers[iChunk].contains((uint16_t)t);
+   }
+
+   //
+   // Status
+   //
+   bool   empty() const noexcept { return numElements == 0; }
+   size_t size()  const noexcept { return numElements;      }
+   size_t memory() const noexcept;
+
+   //
+   // Insert
+   //
+   std::pair<iterator, bool> insert(uint32_t t);
+   void insert(const std::initializer_list <uint32_t> & il);
+   template <class Iterator>
+   void insert(Iterator first, Iterator last);
+
+   //
+   // Remove
+   //
+   void clear() noexcept
+   {
+      keys.clear();
+      containers.clear();
+      numElements = 0;
+   }
+   size_t erase(uint32_t t);
+   iterator erase(iterator & it);
+
+   // store every container that is smaller as runs as RUN
+   void run_optimize();
+
+   //
+   // Set algebra
+   //
+   friend bitmap_set operator | (const bitmap_set & lhs, const bitmap_set & rhs);
+   friend bitmap_set operator & (const bitmap_set & lhs, const bitmap_set & rhs);
+   bitmap_set & operator |= (const bitmap_set & rhs)
+   {
+      bitmap_set result = *this | rhs;
+      swap(result);
+      return *this;
+   }
+   bitmap_set & operator &= (const bitmap_set & rhs)
+   {
+      bitmap_set result = *this & rhs;
+      swap(result);
+      return *this;
+   }
+
+private:
+
+   static const uint32_t ARRAY_MAX = 4096;       // past this a BITMAP is smaller
+   static const size_t   NUM_WORDS = 65536 / 64; // words in a BITMAP
+
+   /*********************************************
+    * CONTAINER
+    * The low 16 bits of the keys in one chunk
+    ********************************************/
+   class Container
+   {
+   public:
+      enum Type : uint8_t { ARRAY, BITMAP, RUN };
+
+      Container() : type(ARRAY), cardinality(0) {}
+
+      bool contains(uint32_t low) const;
+      bool insert(uint16_t low);
+      bool erase(uint16_t low);
+
+      // the first value at or after low, and where it is
+      bool seek(uint32_t low, uint32_t & pos, uint32_t & value) const;
+      // the value after this one
+      bool advance(uint32_t & pos, uint32_t & value) const;
+
+      // call f on every value, in order
+      template <class F>
+      void forEach(F f) const;
+
+      void toArray();
+      void toBitmap();
+      void toRun();
+      void uncompress()
+      {
+         if (cardinality > ARRAY_MAX)
+            toBitmap();
+         else
+            toArray();
+      }
+
+      size_t numRuns() const { return values.size() / 2; }
+      size_t upperRun(uint32_t low) const;
+      size_t countRuns() const;
+
+      static Container unite(const Container & lhs, const Container & rhs);
+      static Container intersect(const Container & lhs, const Container & rhs);
+
+      Type     type;
+      uint32_t cardinality;             // number of values, up to 65536
+      std::vector<uint16_t> values;     // ARRAY: the values; RUN: start, length - 1 pairs
+      std::vector<uint64_t> words;      // BITMAP: one bit per value
+   };
+
+   size_t findChunk(uint16_t key) const;
+
+   static unsigned popcount(uint64_t w);
+   static unsigned countTrailingZeros(uint64_t w);
+   static uint32_t orWords (const uint64_t * pLhs, const uint64_t * pRhs, uint64_t * pOut);
+   static uint32_t andWords(const uint64_t * pLhs, const uint64_t * pRhs, uint64_t * pOut);
+
+   std::vector<uint16_t>  keys;        // high 16 bits of each chunk, sorted
+   std::vector<Container> containers;  // low 16 bits of the keys in each chunk
+   size_t numElements;                 // number of elements
+};
+
+/**************************************************
+ * BITMAP SET ITERATOR
+ * A chunk, a position in its container, and the
+ * key there
+ *************************************************/
+class bitmap_set :: iterator
+{
+   friend class ::TestBitmapSet; // give unit tests access to the privates
+   friend class custom::bitmap_set;
+public:
+   iterator() : pSet(nullptr), iChunk(0), pos(0), value(0) {}
+
+   // equals, not equals operator
+   bool operator == (const iterator & rhs) const
+   {
+      return iChunk == rhs.iChunk && value == rhs.value;
+   }
+   bool operator != (const iterator & rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   // dereference operator
+   const uint32_t & operator * () const
+   {
+      assert(pSet && iChunk < pSet->keys.size());
+      return value;
+   }
+
+   // prefix increment
+   iterator & operator ++ ()
+   {
+      uint32_t low = value & 0xffff;
+      if (pSet->containers[iChunk].advance(pos, low))
+         value = (value & 0xffff0000) | low;
+      else
+         seekChunk(iChunk + 1, 0);
+      return *this;
+   }
+
+   // postfix increment
+   iterator operator ++ (int postfix)
+   {
+      iterator old(*this);
+      ++(*this);
+      return old;
+   }
+
+private:
+   explicit iterator(const bitmap_set * pSet) : pSet(pSet), iChunk(0), pos(0), value(0) {}
+
+   // the first key at or after low in chunk iChunk or any after it
+   void seekChunk(size_t iChunkStart, uint32_t low)
+   {
+      for (iChunk = iChunkStart; iChunk < pSet->keys.size(); iChunk++, low = 0)
+      {
+         uint32_t lowFound;
+         if (pSet->containers[iChunk].seek(low, pos, lowFound))
+         {
+            value = ((uint32_t)pSet->keys[iChunk] << 16) | lowFound;
+            return;
+         }
+      }
+      pos = 0;
+      value = 0;
+   }
+
+   const bitmap_set * pSet;
+   size_t   iChunk;   // which chunk, keys.size() at the end
+   uint32_t pos;      // array index, bit, or run in the container
+   uint32_t value;    // the current key
+};
+
+/*********************************************
+ * BITMAP SET :: BEGIN, END, FIND, LOWER BOUND
+ ********************************************/
+inline bitmap_set :: iterator bitmap_set :: begin() const
+{
+   iterator it(this);
+   it.seekChunk(0, 0);
+   return it;
+}
+inline bitmap_set :: iterator bitmap_set :: end() const
+{
+   iterator it(this);
+   it.iChunk = keys.size();
+   return it;
+}
+inline bitmap_set :: iterator bitmap_set :: lower_bound(uint32_t t) const
+{
+   uint16_t key = (uint16_t)(t >> 16);
+   iterator it(this);
+   size_t iChunk = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+   it.seekChunk(iChunk, (iChunk < keys.size() && keys[iChunk] == key) ? (t & 0xffff) : 0);
+   return it;
+}
+inline bitmap_set :: iterator bitmap_set :: find(uint32_t t) const
+{
+   iterator it = lower_bound(t);
+   return (it != end() && *it == t) ? it : end();
+}
+
+/*********************************************
+ * BITMAP SET :: FIND CHUNK
+ * Index of the chunk with this key, or
+ * keys.size() when there is none
+ ********************************************/
+inline size_t bitmap_set :: findChunk(uint16_t key) const
+{
+   auto it = std::lower_bound(keys.begin(), keys.end(), key);
+   return (it != keys.end() && *it == key) ? it - keys.begin() : keys.size();
+}
+
+/*********************************************
+ * BITMAP SET :: MEMORY
+ * Bytes held by the set and its containers
+ ********************************************/
+inline size_t bitmap_set :: memory() const noexcept
+{
+   size_t num = sizeof(*this) + keys.capacity() * sizeof(uint16_t) +
+                containers.capacity() * sizeof(Container);
+   for (auto & container : containers)
+      num += container.values.capacity() * sizeof(uint16_t) +
+             container.words.capacity() * sizeof(uint64_t);
+   return num;
+}
+
+/*********************************************
+ * BITMAP SET :: INSERT
+ * Find or make the chunk, then insert the low
+ * bits into its container
+ ********************************************/
+inline std::pair<bitmap_set :: iterator, bool> bitmap_set :: insert(uint32_t t)
+{
+   uint16_t key = (uint16_t)(t >> 16);
+   size_t iChunk = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+   if (iChunk == keys.size() || keys[iChunk] != key)
+   {
+      keys.insert(keys.begin() + iChunk, key);
+      containers.insert(containers.begin() + iChunk, Container());
+   }
+
+   bool isNew = containers[iChunk].insert((uint16_t)t);
+   if (isNew)
+      numElements++;
+
+   iterator it(this);
+   it.seekChunk(iChunk, t & 0xffff);
+   return std::pair<iterator, bool>(it, isNew);
+}
+
+inline void bitmap_set :: insert(const std::initializer_list <uint32_t> & il)
+{
+   for (uint32_t t : il)
+      insert(t);
+}
+template <class Iterator>
+void bitmap_set :: insert(Iterator first, Iterator last)
+{
+   for (; first != last; ++first)
+      insert(*first);
+}
+
+/*********************************************
+ * BITMAP SET :: ERASE
+ * A chunk that empties goes away
+ ********************************************/
+inline size_t bitmap_set :: erase(uint32_t t)
+{
+   size_t iChunk = findChunk((uint16_t)(t >> 16));
+   if (iChunk == keys.size() || !containers[iChunk].erase((uint16_t)t))
+      return 0;
+
+   numElements--;
+   if (containers[iChunk].cardinality == 0)
+   {
+      keys.erase(keys.begin() + iChunk);
+      containers.erase(containers.begin() + iChunk);
+   }
+   return 1;
+}
+inline bitmap_set :: iterator bitmap_set :: erase(iterator & it)
+{
+   uint32_t t = *it;
+   erase(t);
+   return t == 0xffffffff ? end() : lower_bound(t + 1);
+}
+
+/*********************************************
+ * BITMAP SET :: RUN OPTIMIZE
+ ********************************************/
+inline void bitmap_set :: run_optimize()
+{
+   for (auto & container : containers)
+   {
+      size_t bytesRun = container.countRuns() * 2 * sizeof(uint16_t);
+      size_t bytesNow = container.type == Container::BITMAP ?
+                        NUM_WORDS * sizeof(uint64_t) :
+                        container.values.size() * sizeof(uint16_t);
+      if (container.type != Container::RUN && bytesRun < bytesNow)
+         container.toRun();
+   }
+}
+
+/*********************************************
+ * BITMAP SET :: UNION
+ * Walk the two sorted key lists together; a
+ * chunk on one side is copied, a chunk on both
+ * is united
+ ********************************************/
+inline bitmap_set operator | (const bitmap_set & lhs, const bitmap_set & rhs)
+{
+   bitmap_set result;
+   result.keys.reserve(lhs.keys.size() + rhs.keys.size());
+   result.containers.reserve(lhs.keys.size() + rhs.keys.size());
+   size_t iLhs = 0;
+   size_t iRhs = 0;
+   while (iLhs < lhs.keys.size() || iRhs < rhs.keys.size())
+   {
+      if (iRhs == rhs.keys.size() || (iLhs < lhs.keys.size() && lhs.keys[iLhs] < rhs.keys[iRhs]))
+      {
+         result.keys.push_back(lhs.keys[iLhs]);
+         result.containers.push_back(lhs.containers[iLhs++]);
+      }
+      else if (iLhs == lhs.keys.size() || rhs.keys[iRhs] < lhs.keys[iLhs])
+      {
+         result.keys.push_back(rhs.keys[iRhs]);
+         result.containers.push_back(rhs.containers[iRhs++]);
+      }
+      else
+      {
+         result.keys.push_back(lhs.keys[iLhs]);
+         result.containers.push_back(bitmap_set::Container::unite(lhs.containers[iLhs++],
+                                                                  rhs.containers[iRhs++]));
+      }
+      result.numElements += result.containers.back().cardinality;
+   }
+   return result;
+}
+
+/*********************************************
+ * BITMAP SET :: INTERSECTION
+ * Only chunks on both sides can share keys
+ ********************************************/
+inline bitmap_set operator & (const bitmap_set & lhs, const bitmap_set & rhs)
+{
+   bitmap_set result;
+   size_t iLhs = 0;
+   size_t iRhs = 0;
+   while (iLhs < lhs.keys.size() && iRhs < rhs.keys.size())
+   {
+      if (lhs.keys[iLhs] < rhs.keys[iRhs])
+         iLhs++;
+      else if (rhs.keys[iRhs] < lhs.keys[iLhs])
+         iRhs++;
+      else
+      {
+         bitmap_set::Container container =
+            bitmap_set::Container::intersect(lhs.containers[iLhs], rhs.containers[iRhs]);
+         if (container.cardinality)
+         {
+            result.keys.push_back(lhs.keys[iLhs]);
+            result.numElements += container.cardinality;
+            result.containers.push_back(std::move(container));
+         }
+         iLhs++;
+         iRhs++;
+      }
+   }
+   return result;
+}
+
+/*********************************************
+ * BITMAP SET :: POPCOUNT and COUNT TRAILING ZEROS
+ ********************************************/
+inline unsigned bitmap_set :: popcount(uint64_t w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+   return (unsigned)__builtin_popcountll(w);
+#else
+   w = w - ((w >> 1) & 0x5555555555555555ULL);
+   w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+   w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+   return (unsigned)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+inline unsigned bitmap_set :: countTrailingZeros(uint64_t w)
+{
+   assert(w != 0);
+#if defined(__GNUC__) || defined(__clang__)
+   return (unsigned)__builtin_ctzll(w);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   unsigned long i;
+   _BitScanForward64(&i, w);
+   return (unsigned)i;
+#else
+   unsigned i = 0;
+   while (!(w & 1))
+   {
+      w >>= 1;
+      i++;
+   }
+   return i;
+#endif
+}
+
+/*********************************************
+ * BITMAP SET :: OR WORDS and AND WORDS
+ * Combine two whole bitmaps into pOut and
+ * return how many bits are set in it
+ ********************************************/
+inline uint32_t bitmap_set :: orWords(const uint64_t * pLhs, const uint64_t * pRhs, uint64_t * pOut)
+{
+#if defined(BITMAP_SSE2)
+   for (size_t i = 0; i < NUM_WORDS; i += 2)
+      _mm_storeu_si128((__m128i *)(pOut + i),
+                       _mm_or_si128(_mm_loadu_si128((const __m128i *)(pLhs + i)),
+                                    _mm_loadu_si128((const __m128i *)(pRhs + i))));
+#elif defined(BITMAP_NEON)
+   for (size_t i = 0; i < NUM_WORDS; i += 2)
+      vst1q_u64(pOut + i, vorrq_u64(vld1q_u64(pLhs + i), vld1q_u64(pRhs + i)));
+#else
+   for (size_t i = 0; i < NUM_WORDS; i++)
+      pOut[i] = pLhs[i] | pRhs[i];
+#endif
+   uint32_t num = 0;
+   for (size_t i = 0; i < NUM_WORDS; i++)
+      num += popcount(pOut[i]);
+   return num;
+}
+inline uint32_t bitmap_set :: andWords(const uint64_t * pLhs, const uint64_t * pRhs, uint64_t * pOut)
+{
+#if defined(BITMAP_SSE2)
+   for (size_t i = 0; i < NUM_WORDS; i += 2)
+      _mm_storeu_si128((__m128i *)(pOut + i),
+                       _mm_and_si128(_mm_loadu_si128((const __m128i *)(pLhs + i)),
+                                     _mm_loadu_si128((const __m128i *)(pRhs + i))));
+#elif defined(BITMAP_NEON)
+   for (size_t i = 0; i < NUM_WORDS; i += 2)
+      vst1q_u64(pOut + i, vandq_u64(vld1q_u64(pLhs + i), vld1q_u64(pRhs + i)));
+#else
+   for (size_t i = 0; i < NUM_WORDS; i++)
+      pOut[i] = pLhs[i] & pRhs[i];
+#endif
+   uint32_t num = 0;
+   for (size_t i = 0; i < NUM_WORDS; i++)
+      num += popcount(pOut[i]);
+   return num;
+}
+
+/*********************************************
+ * CONTAINER :: CONTAINS
+ ********************************************/
+inline bool bitmap_set :: Container :: contains(uint32_t low) const
+{
+   switch (type)
+   {
+      case ARRAY:
+         return std::binary_search(values.begin(), values.end(), (uint16_t)low);
+      case BITMAP:
+         return (words[low >> 6] >> (low & 63)) & 1;
+      default:
+      {
+         // only the last run starting at or before low can hold it
+         size_t iRun = upperRun(low);
+         return iRun > 0 && low <= (uint32_t)values[2 * iRun - 2] + values[2 * iRun - 1];
+      }
+   }
+}
+
+/*********************************************
+ * CONTAINER :: INSERT
+ * An ARRAY that would pass ARRAY_MAX becomes a
+ * BITMAP. False when low is already here.
+ ********************************************/
+inline bool bitmap_set :: Container :: insert(uint16_t low)
+{
+   if (type == RUN)
+   {
+      if (contains(low))
+         return false;
+      uncompress();
+   }
+
+   if (type == ARRAY)
+   {
+      auto it = std::lower_bound(values.begin(), values.end(), low);
+      if (it != values.end() && *it == low)
+         return false;
+      if (values.size() < ARRAY_MAX)
+      {
+         values.insert(it, low);
+         cardinality++;
+         return true;
+      }
+      toBitmap();
+   }
+
+   uint64_t bit = 1ULL << (low & 63);
+   if (words[low >> 6] & bit)
+      return false;
+   words[low >> 6] |= bit;
+   cardinality++;
+   return true;
+}
+
+/*********************************************
+ * CONTAINER :: ERASE
+ * A BITMAP that drops to ARRAY_MAX becomes an
+ * ARRAY. False when low is not here.
+ ********************************************/
+inline bool bitmap_set :: Container :: erase(uint16_t low)
+{
+   if (!contains(low))
+      return false;
+   if (type == RUN)
+      uncompress();
+
+   cardinality--;
+   if (type == ARRAY)
+      values.erase(std::lower_bound(values.begin(), values.end(), low));
+   else
+   {
+      words[low >> 6] &= ~(1ULL << (low & 63));
+      if (cardinality <= ARRAY_MAX)
+         toArray();
+   }
+   return true;
+}
+
+/*********************************************
+ * CONTAINER :: SEEK
+ * The first value at or after low. False when
+ * there is none.
+ ********************************************/
+inline bool bitmap_set :: Container :: seek(uint32_t low, uint32_t & pos, uint32_t & value) const
+{
+   if (low > 0xffff)
+      return false;
+
+   switch (type)
+   {
+      case ARRAY:
+      {
+         auto it = std::lower_bound(values.begin(), values.end(), (uint16_t)low);
+         if (it == values.end())
+            return false;
+         pos = (uint32_t)(it - values.begin());
+         value = *it;
+         return true;
+      }
+      case BITMAP:
+      {
+         size_t iWord = low >> 6;
+         uint64_t w = words[iWord] & (~0ULL << (low & 63));
+         while (w == 0)
+         {
+            if (++iWord == NUM_WORDS)
+               return false;
+            w = words[iWord];
+         }
+         pos = value = (uint32_t)(iWord * 64 + countTrailingZeros(w));
+         return true;
+      }
+      default:
+      {
+         size_t iRun = upperRun(low);
+         if (iRun > 0 && low <= (uint32_t)values[2 * iRun - 2] + values[2 * iRun - 1])
+         {
+            pos = (uint32_t)(iRun - 1);
+            value = low;
+            return true;
+         }
+         if (iRun == numRuns())
+            return false;
+         pos = (uint32_t)iRun;
+         value = values[2 * iRun];
+         return true;
+      }
+   }
+}
+
+/*********************************************
+ * CONTAINER :: ADVANCE
+ * From the value at pos to the next one. False
+ * at the end of the container.
+ ********************************************/
+inline bool bitmap_set :: Container :: advance(uint32_t & pos, uint32_t & value) const
+{
+   switch (type)
+   {
+      case ARRAY:
+         if (++pos == values.size())
+            return false;
+         value = values[pos];
+         return true;
+      case BITMAP:
+         return seek(value + 1, pos, value);
+      default:
+         if (value < (uint32_t)values[2 * pos] + values[2 * pos + 1])
+         {
+            value++;
+            return true;
+         }
+         if (++pos == numRuns())
+            return false;
+         value = values[2 * pos];
+         return true;
+   }
+}
+
+/*********************************************
+ * CONTAINER :: FOR EACH
+ ********************************************/
+template <class F>
+void bitmap_set :: Container :: forEach(F f) const
+{
+   switch (type)
+   {
+      case ARRAY:
+         for (uint16_t low : values)
+            f(low);
+         break;
+      case BITMAP:
+         for (size_t iWord = 0; iWord < NUM_WORDS; iWord++)
+            for (uint64_t w = words[iWord]; w; w &= w - 1)
+               f((uint16_t)(iWord * 64 + countTrailingZeros(w)));
+         break;
+      default:
+         for (size_t iRun = 0; iRun < numRuns(); iRun++)
+            for (uint32_t low = values[2 * iRun]; low <= (uint32_t)values[2 * iRun] + values[2 * iRun + 1]; low++)
+               f((uint16_t)low);
+         break;
+   }
+}
+
+/*********************************************
+ * CONTAINER :: TO ARRAY, TO BITMAP, TO RUN
+ * Re-encode the same values
+ ********************************************/
+inline void bitmap_set :: Container :: toArray()
+{
+   if (type == ARRAY)
+      return;
+   std::vector<uint16_t> array;
+   array.reserve(cardinality);
+   forEach([&](uint16_t low) { array.push_back(low); });
+   values.swap(array);
+   std::vector<uint64_t>().swap(words);
+   type = ARRAY;
+}
+inline void bitmap_set :: Container :: toBitmap()
+{
+   if (type == BITMAP)
+      return;
+   std::vector<uint64_t> bitmap(NUM_WORDS);
+   forEach([&](uint16_t low) { bitmap[low >> 6] |= 1ULL << (low & 63); });
+   words.swap(bitmap);
+   std::vector<uint16_t>().swap(values);
+   type = BITMAP;
+}
+inline void bitmap_set :: Container :: toRun()
+{
+   if (type == RUN)
+      return;
+   std::vector<uint16_t> runs;
+   runs.reserve(countRuns() * 2);
+   forEach([&](uint16_t low)
+   {
+      if (!runs.empty() && (uint32_t)runs[runs.size() - 2] + runs.back() + 1 == low)
+         runs.back()++;
+      else
+      {
+         runs.push_back(low);
+         runs.push_back(0);
+      }
+   });
+   values.swap(runs);
+   std::vector<uint64_t>().swap(words);
+   type = RUN;
+}
+
+/*********************************************
+ * CONTAINER :: UPPER RUN
+ * How many runs start at or before low
+ ********************************************/
+inline size_t bitmap_set :: Container :: upperRun(uint32_t low) const
+{
+   size_t iLow = 0;
+   size_t iHigh = numRuns();
+   while (iLow < iHigh)
+   {
+      size_t iMiddle = iLow + (iHigh - iLow) / 2;
+      if (values[2 * iMiddle] <= low)
+         iLow = iMiddle + 1;
+      else
+         iHigh = iMiddle;
+   }
+   return iLow;
+}
+
+/*********************************************
+ * CONTAINER :: COUNT RUNS
+ * How many runs the values would make
+ ********************************************/
+inline size_t bitmap_set :: Container :: countRuns() const
+{
+   switch (type)
+   {
+      case ARRAY:
+      {
+         size_t num = values.empty() ? 0 : 1;
+         for (size_t i = 1; i < values.size(); i++)
+            num += values[i] != values[i - 1] + 1;
+         return num;
+      }
+      case BITMAP:
+      {
+         // a run starts at every set bit whose lower neighbor is clear
+         size_t num = 0;
+         uint64_t carry = 0;
+         for (size_t iWord = 0; iWord < NUM_WORDS; iWord++)
+         {
+            uint64_t w = words[iWord];
+            num += popcount(w & ~((w << 1) | carry));
+            carry = w >> 63;
+         }
+         return num;
+      }
+      default:
+         return numRuns();
+   }
+}
+
+/*********************************************
+ * CONTAINER :: UNITE
+ * Two bitmaps are ORed a vector at a time, an
+ * array is ORed into a bitmap, two arrays are
+ * merged. A RUN is expanded first.
+ ********************************************/
+inline bitmap_set :: Container bitmap_set :: Container :: unite(const Container & lhs, const Container & rhs)
+{
+   if (lhs.type == RUN || rhs.type == RUN)
+   {
+      Container lhsPlain(lhs);
+      Container rhsPlain(rhs);
+      lhsPlain.uncompress();
+      rhsPlain.uncompress();
+      return unite(lhsPlain, rhsPlain);
+   }
+
+   Container result;
+   if (lhs.type == BITMAP && rhs.type == BITMAP)
+   {
+      result.type = BITMAP;
+      result.words.resize(NUM_WORDS);
+      result.cardinality = orWords(lhs.words.data(), rhs.words.data(), result.words.data());
+   }
+   else if (lhs.type == BITMAP || rhs.type == BITMAP)
+   {
+      const Container & array = lhs.type == BITMAP ? rhs : lhs;
+      result = lhs.type == BITMAP ? lhs : rhs;
+      for (uint16_t low : array.values)
+      {
+         uint64_t bit = 1ULL << (low & 63);
+         result.cardinality += !(result.words[low >> 6] & bit);
+         result.words[low >> 6] |= bit;
+      }
+   }
+   else
+   {
+      result.values.resize(lhs.values.size() + rhs.values.size());
+      result.values.erase(std::set_union(lhs.values.begin(), lhs.values.end(),
+                                         rhs.values.begin(), rhs.values.end(),
+                                         result.values.begin()),
+                          result.values.end());
+      result.cardinality = (uint32_t)result.values.size();
+      if (result.cardinality > ARRAY_MAX)
+         result.toBitmap();
+   }
+   return result;
+}
+
+/*********************************************
+ * CONTAINER :: INTERSECT
+ * Two bitmaps are ANDed a vector at a time, an
+ * array is filtered through a bitmap, two arrays
+ * are merged. A RUN is expanded first.
+ ********************************************/
+inline bitmap_set :: Container bitmap_set :: Container :: intersect(const Container & lhs, const Container & rhs)
+{
+   if (lhs.type == RUN || rhs.type == RUN)
+   {
+      Container lhsPlain(lhs);
+      Container rhsPlain(rhs);
+      lhsPlain.uncompress();
+      rhsPlain.uncompress();
+      return intersect(lhsPlain, rhsPlain);
+   }
+
+   Container result;
+   if (lhs.type == BITMAP && rhs.type == BITMAP)
+   {
+      result.type = BITMAP;
+      result.words.resize(NUM_WORDS);
+      result.cardinality = andWords(lhs.words.data(), rhs.words.data(), result.words.data());
+      if (result.cardinality <= ARRAY_MAX)
+         result.toArray();
+   }
+   else if (lhs.type == BITMAP || rhs.type == BITMAP)
+   {
+      const Container & array  = lhs.type == BITMAP ? rhs : lhs;
+      const Container & bitmap = lhs.type == BITMAP ? lhs : rhs;
+      for (uint16_t low : array.values)
+         if ((bitmap.words[low >> 6] >> (low & 63)) & 1)
+            result.values.push_back(low);
+      result.cardinality = (uint32_t)result.values.size();
+   }
+   else
+   {
+      result.values.resize(std::min(lhs.values.size(), rhs.values.size()));
+      result.values.erase(std::set_intersection(lhs.values.begin(), lhs.values.end(),
+                                                rhs.values.begin(), rhs.values.end(),
+                                                result.values.begin()),
+                          result.values.end());
+      result.cardinality = (uint32_t)result.values.size();
+   }
+   return result;
+}
+
+}; // namespace custom
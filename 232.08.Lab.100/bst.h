@@ -13,6 +13,7 @@
  *    This will contain the class definition of:
  *        BST                 : A class that represents a binary search tree
  *        BST::iterator       : An iterator through BST
+ *        tree_stats          : The shape of a tree and what its nodes cost
  * Author
  *    Sara Nuss, William Patrick-Barr
  ************************************************************************/
@@ -27,9 +28,22 @@
 
 #include <cassert>
 #include <utility>
+#include <vector>     // for std::vector
 #include <memory>     // for std::allocator
 #include <functional> // for std::less
 #include <utility>    // for std::pair
+#include "parallel.h" // for parallel_for
+#include "setCounters.h" // for no_counters
+
+// a hint to start loading a node before the descent needs it
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define BST_PREFETCH(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define BST_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define BST_PREFETCH(p) ((void)(p))
+#endif
 
 class TestBST; // forward declaration for unit tests
 class TestMap;
@@ -38,17 +52,54 @@ class TestSet;
 namespace custom
 {
 
-   template <class TT>
+   template <class TT, class CC = no_counters>
    class set;
    template <class KK, class VV>
    class map;
 
+/*****************************************************************
+ * TREE STATS
+ * The shape of a tree, whether it is still a valid search tree
+ * and red-black tree, and what its nodes cost
+ *****************************************************************/
+struct tree_stats
+{
+   size_t numNodes;                  // nodes reached from the root
+   size_t height;                    // levels, 0 when empty
+   size_t depthMax;                  // of the deepest node, the root at 0
+   double depthAverage;              // of all the nodes
+   std::vector<size_t> depthCounts;  // how many nodes at each depth
+   size_t bytesNode;                 // what the allocator hands out for one node
+   size_t bytesNodes;                // and for all of them
+   bool   isValid;                   // in order, children point back at their
+                                     // parents, and numNodes is the size
+   bool   isRedBlack;                // root black, no red node with a red
+                                     // child, and equal black heights
+   size_t blackHeight;               // black nodes on every path from the root,
+                                     // when isRedBlack
+};
+
+/*****************************************************************
+ * ALLOCATION SIZE
+ * What malloc really takes for a request of num bytes. This is
+ * glibc's rule: a word of header, rounded up to two words, and
+ * no less than four. Other allocators are close to it.
+ *****************************************************************/
+inline size_t allocation_size(size_t num)
+{
+   const size_t word = sizeof(void *);
+   size_t size = (num + word + 2 * word - 1) & ~(2 * word - 1);
+   return size < 4 * word ? 4 * word : size;
+}
+
 /*****************************************************************
  * BINARY SEARCH TREE
- * Create a Binary Search Tree
+ * Create a Binary Search Tree. Counters is the policy that counts
+ * the tree's comparisons, node allocations, and recolorings; it is
+ * a base so the default, no_counters, takes no room.
  *****************************************************************/
-template <typename T>
-class BST
+template <typename T, class Counters = no_counters>
+class BST : private Counters
 {
    friend class ::TestBST; // give unit tests access to the privates
    friend class ::TestMap;
@@ -57,7 +108,7 @@ class BST
    template <class KK, class VV>
    friend class map;
 
-   template <class TT>
+   template <class TT, class CC>
    friend class set;
 
    template <class KK, class VV>
@@ -95,6 +146,9 @@ public:
    //
 
    iterator find(const T& t);
+   iterator lower_bound(const T& t) const;
+   template <class KeyIterator, class Visit>
+   void findBatch(KeyIterator first, KeyIterator last, Visit visit) const;
 
    //
    // Insert
@@ -108,6 +162,9 @@ public:
    //
 
    iterator erase(iterator& it);
+   size_t eraseRange(const T& lo, const T& hi);
+   template <class Predicate>
+   size_t eraseIf(Predicate pred);
    void   clear() noexcept;
 
    //
@@ -116,11 +173,46 @@ public:
 
    bool   empty() const noexcept { return numElements == 0; }
    size_t size()  const noexcept { return numElements; }
+   tree_stats stats() const;
+   const Counters & counters() const noexcept { return *this; }
    
 
 private:
 
    class BNode;
+
+   // every comparison of two elements goes through these to be counted
+   bool isLess (const T & lhs, const T & rhs) const { this->onCompare(); return lhs < rhs;  }
+   bool isEqual(const T & lhs, const T & rhs) const { this->onCompare(); return lhs == rhs; }
+
+   //
+   // Build
+   //
+
+   template <class Make>
+   void assignBalanced(size_t num, size_t numThreads, Make make)
+   {
+      assignBalanced(num, numThreads, make, [](size_t) { return false; });
+   }
+   template <class Make, class IsOld>
+   void assignBalanced(size_t num, size_t numThreads, Make make, IsOld isOld);
+   template <class Make, class IsOld>
+   static BNode * buildBalanced(size_t iBegin, size_t iEnd, size_t depth, size_t redDepth, Make & make,
+                                IsOld & isOld, size_t & numRecolored);
+   static void paint(BNode * p, bool isRed, bool isOld, size_t & numRecolored);
+   void flatten(std::vector<BNode *> & nodes);
+   static size_t deleteSubtree(BNode * p);
+
+   //
+   // Reuse
+   //
+
+   static BNode * takeSpare(BNode * & pSpare) noexcept;
+   template <class U>
+   BNode * reuseNode(BNode * & pSpare, U && t);
+   template <class Iterator>
+   size_t assignEach(Iterator first, Iterator last, bool keepUnique);
+
    BNode * root;              // root node of the binary search tree
    size_t numElements;        // number of elements currently in the tree
 
@@ -132,8 +224,8 @@ private:
  * A single node in a binary tree. Note that the node does not know
  * anything about the properties of the tree so no validation can be done.
  *****************************************************************/
-template <typename T>
-class BST <T> :: BNode
+template <typename T, class Counters>
+class BST <T, Counters> :: BNode
 {
 public:
    //
@@ -175,8 +267,8 @@ public:
  * BINARY SEARCH TREE ITERATOR
  * Forward and reverse iterator through a BST
  *********************************************************/
-template <typename T>
-class BST <T> :: iterator
+template <typename T, class Counters>
+class BST <T, Counters> :: iterator
 {
    friend class ::TestBST; // give unit tests access to the privates
    friend class ::TestMap;
@@ -185,7 +277,7 @@ class BST <T> :: iterator
    template <class KK, class VV>
    friend class map;
 
-   template <class TT>
+   template <class TT, class CC>
    friend class set;
 public:
     // constructors and assignment
@@ -239,7 +331,8 @@ public:
 
 
     // must give friend status to remove so it can call getNode() from it
-   friend BST <T> :: iterator BST <T> :: erase(iterator & it);
+   friend BST <T, Counters> :: iterator BST <T, Counters> :: erase(iterator & it);
+   friend class BST <T, Counters>;
 
 private:
    
@@ -281,8 +374,8 @@ private:
 /*********************************************
  * BST :: DESTRUCTOR
  ********************************************/
-template <typename T>
-BST<T>::~BST()
+template <typename T, class Counters>
+BST<T, Counters>::~BST()
 {
     clear();
 }
@@ -290,127 +383,199 @@ BST<T>::~BST()
 
 /*********************************************
  * BST :: ASSIGNMENT OPERATOR
- * Copy one tree to another
+ * Copy one tree to another. The nodes already here
+ * are taken apart the way clear() does it and given
+ * the elements of rhs by assignment, so only what rhs
+ * has beyond our size is allocated and only what we
+ * have beyond its size is deleted.
  ********************************************/
-template <typename T>
-BST<T>& BST<T>::operator=(const BST<T>& rhs)
+template <typename T, class Counters>
+BST<T, Counters>& BST<T, Counters>::operator=(const BST<T, Counters>& rhs)
 {
     if (this == &rhs) return *this;
 
-    if (!rhs.root) {            // rhs empty → result empty
-        clear();
-        return *this;
-    }
-
-    // helpers
-    auto clone = [&](auto&& self, BNode* src, BNode* parent) -> BNode*
-    {
-        if (!src) return nullptr;
-        BNode* n = new BNode(src->data);   // copy-construct T
-        n->pParent = parent;
-        n->pLeft   = self(self, src->pLeft,  n);
-        n->pRight  = self(self, src->pRight, n);
-        return n;
-    };
-
-    auto assignShape = [&](auto&& self, BNode* dst, BNode* src) -> void
-    {
-        if (!dst || !src) return;
-        dst->data = src->data;             // Spy::numAssign++
-        self(self, dst->pLeft,  src->pLeft);
-        self(self, dst->pRight, src->pRight);
-    };
-
-    auto count = [&](auto&& self, BNode* n) -> size_t
-    {
-        if (!n) return 0;
-        return 1 + self(self, n->pLeft) + self(self, n->pRight);
-    };
-
-    auto destroy = [&](auto&& self, BNode* n) -> void
-    {
-        if (!n) return;
-        self(self, n->pLeft);
-        self(self, n->pRight);
-        delete n;                           // Spy delete/destructor++
-    };
-
-    const size_t rhsCount = count(count, rhs.root);
-
-    // Case 1: rhs has exactly one node → reuse dest root, delete its subtrees
-    if (rhsCount == 1)
-    {
-        if (!root) {
-            root = new BNode(rhs.root->data);   // single copy/alloc if dest was empty
-            numElements = 1;
-            return *this;
-        }
-        // assign root once, drop both subtrees, no new allocs/copies
-        root->data = rhs.root->data;
-        destroy(destroy, root->pLeft);
-        destroy(destroy, root->pRight);
-        root->pLeft = root->pRight = nullptr;
-        numElements = 1;
-        return *this;
-    }
+    BNode * pSpare = root;
+    root = nullptr;
+    numElements = 0;
 
-    // Case 2: dest has exactly one node → assign root, then clone rhs children
-    if (root && !root->pLeft && !root->pRight)
+    // walk rhs in step with the copy, down to a child the copy
+    // lacks or else back up, so a long chain costs no stack
+    BNode * pSrc = rhs.root;
+    BNode * pDst = nullptr;
+    if (pSrc)
     {
-        root->data  = rhs.root->data;                    // one assign
-        root->pLeft  = clone(clone, rhs.root->pLeft,  root);
-        root->pRight = clone(clone, rhs.root->pRight, root);
-        numElements  = count(count, root);
-        return *this;
+        root = pDst = reuseNode(pSpare, pSrc->data);
+        ++numElements;
     }
-
-    // Case 3: shapes match (e.g., standard → standard) → assign in place
-    if (root && numElements == rhsCount)
+    while (pSrc)
     {
-        assignShape(assignShape, root, rhs.root);
-        return *this;
+        if (pSrc->pLeft && !pDst->pLeft)
+        {
+            pSrc = pSrc->pLeft;
+            pDst->addLeft(reuseNode(pSpare, pSrc->data));
+            pDst = pDst->pLeft;
+            ++numElements;
+        }
+        else if (pSrc->pRight && !pDst->pRight)
+        {
+            pSrc = pSrc->pRight;
+            pDst->addRight(reuseNode(pSpare, pSrc->data));
+            pDst = pDst->pRight;
+            ++numElements;
+        }
+        else if (pSrc == rhs.root)
+            break;
+        else
+        {
+            pSrc = pSrc->pParent;
+            pDst = pDst->pParent;
+        }
     }
 
-    // Fallback: different shapes → clear then clone
-    clear();
-    root = clone(clone, rhs.root, nullptr);
-    numElements = rhsCount;
+    while (BNode * p = takeSpare(pSpare))
+        delete p;
     return *this;
 }
 
-//keep
-
 /*********************************************
  * BST :: ASSIGNMENT OPERATOR with INITIALIZATION LIST
- * Copy nodes onto a BTree
+ * Insert each element in turn, on the nodes that
+ * were here where there are enough of them
  ********************************************/
-template <typename T>
-BST <T> & BST <T> :: operator = (const std::initializer_list<T>& il)
+template <typename T, class Counters>
+BST <T, Counters> & BST <T, Counters> :: operator = (const std::initializer_list<T>& il)
 {
-   clear();                    // wipe current contents
-   for (const auto& x : il)    // insert each element
-      insert(x);
-   return *this;               // <-- required
+   assignEach(il.begin(), il.end(), false);
+   return *this;
 }
 
 /*********************************************
  * BST :: ASSIGN-MOVE OPERATOR
  * Move one tree to another
  ********************************************/
-template <typename T>
-BST <T> & BST <T> :: operator = (BST <T> && rhs)
+template <typename T, class Counters>
+BST <T, Counters> & BST <T, Counters> :: operator = (BST <T, Counters> && rhs)
 {
     clear();
     swap(rhs);
    return *this;
 }
 
+/*********************************************
+ * BST :: STATS
+ * One walk over the tree that follows the parent
+ * pointers back up instead of recursing or keeping
+ * a stack, so a degenerate chain costs no more
+ * memory than a balanced tree. A child whose parent
+ * pointer is wrong is counted as missing, so a
+ * broken tree is reported, not walked forever.
+ ********************************************/
+template <typename T, class Counters>
+tree_stats BST <T, Counters> :: stats() const
+{
+   tree_stats stats = tree_stats();
+   stats.bytesNode = allocation_size(sizeof(BNode));
+   stats.isValid = !root || !root->pParent;
+   stats.isRedBlack = !root || !root->isRed;
+
+   bool isBlackHeightSet = false;
+   size_t depthTotal = 0;
+   size_t depth = 0;
+   size_t numBlack = (root && !root->isRed) ? 1 : 0;
+   const BNode * pLast = nullptr;   // the last node in order
+
+   // a missing child ends a path from the root
+   auto endPath = [&]()
+   {
+      if (!isBlackHeightSet)
+      {
+         stats.blackHeight = numBlack;
+         isBlackHeightSet = true;
+      }
+      else if (numBlack != stats.blackHeight)
+         stats.isRedBlack = false;
+   };
+   auto isChild = [&stats](const BNode * pChild, const BNode * pParent)
+   {
+      if (pChild && pChild->pParent != pParent)
+         stats.isValid = false;
+      return pChild && pChild->pParent == pParent;
+   };
+
+   enum { FROM_PARENT, FROM_LEFT, FROM_RIGHT } from = FROM_PARENT;
+   const BNode * p = root;
+   while (p)
+   {
+      if (from == FROM_PARENT)
+      {
+         if (++stats.numNodes > numElements)
+         {
+            stats.isValid = false;   // more nodes than elements: a cycle?
+            break;
+         }
+         depthTotal += depth;
+         if (depth >= stats.depthCounts.size())
+            stats.depthCounts.resize(depth + 1, 0);
+         stats.depthCounts[depth]++;
+         if (p->isRed && p->pParent && p->pParent->isRed)
+            stats.isRedBlack = false;
+
+         if (isChild(p->pLeft, p))
+         {
+            p = p->pLeft;
+            depth++;
+            numBlack += !p->isRed;
+            continue;
+         }
+         endPath();
+         from = FROM_LEFT;
+      }
+
+      if (from == FROM_LEFT)
+      {
+         if (pLast && p->data < pLast->data)
+            stats.isValid = false;
+         pLast = p;
+
+         if (isChild(p->pRight, p))
+         {
+            p = p->pRight;
+            depth++;
+            numBlack += !p->isRed;
+            from = FROM_PARENT;
+            continue;
+         }
+         endPath();
+      }
+
+      // both sides done: back up to the parent, but never above
+      // the root even if a broken root claims to have one
+      if (p == root)
+         break;
+      const BNode * pChild = p;
+      numBlack -= !p->isRed;
+      depth--;
+      p = p->pParent;
+      from = (p->pLeft == pChild) ? FROM_LEFT : FROM_RIGHT;
+   }
+
+   stats.height = stats.depthCounts.size();
+   stats.depthMax = stats.height ? stats.height - 1 : 0;
+   stats.depthAverage = stats.numNodes ? (double)depthTotal / stats.numNodes : 0.0;
+   stats.bytesNodes = stats.bytesNode * stats.numNodes;
+   if (stats.numNodes != numElements)
+      stats.isValid = false;
+   if (!stats.isRedBlack)
+      stats.blackHeight = 0;
+   return stats;
+}
+
 /*********************************************
  * BST :: SWAP
  * Swap two trees
  ********************************************/
-template <typename T>
-void BST <T> :: swap (BST <T>& rhs)
+template <typename T, class Counters>
+void BST <T, Counters> :: swap (BST <T, Counters>& rhs)
 {
     BNode* tempRoot = rhs.root;
     rhs.root = root;
@@ -428,13 +593,14 @@ void BST <T> :: swap (BST <T>& rhs)
 /*****************************************************
  * BST :: INSERT  (lvalue)
  ****************************************************/
-template <typename T>
-std::pair<typename BST<T>::iterator, bool>
-BST<T>::insert(const T& t, bool keepUnique)
+template <typename T, class Counters>
+std::pair<typename BST<T, Counters>::iterator, bool>
+BST<T, Counters>::insert(const T& t, bool keepUnique)
 {
     if (!root)
     {
         root = new BNode(t);
+        this->onAllocate();
         ++numElements;
         return { iterator(root), true };
     }
@@ -446,10 +612,10 @@ BST<T>::insert(const T& t, bool keepUnique)
     while (cur)
     {
         parent = cur;
-       if (keepUnique && (t == cur->data))
+       if (keepUnique && isEqual(t, cur->data))
            return { iterator(cur), false };
 
-        if (t < cur->data)
+        if (isLess(t, cur->data))
         {
             cur = cur->pLeft;
             wentLeft = true;
@@ -462,6 +628,7 @@ BST<T>::insert(const T& t, bool keepUnique)
     }
 
     BNode* n = new BNode(t);
+    this->onAllocate();
     if (wentLeft) parent->addLeft(n);
     else          parent->addRight(n);
 
@@ -470,13 +637,14 @@ BST<T>::insert(const T& t, bool keepUnique)
 }
 
 
-template <typename T>
-std::pair<typename BST<T>::iterator, bool>
-BST<T>::insert(T&& t, bool keepUnique)
+template <typename T, class Counters>
+std::pair<typename BST<T, Counters>::iterator, bool>
+BST<T, Counters>::insert(T&& t, bool keepUnique)
 {
     if (!root)
     {
         root = new BNode(std::move(t));
+        this->onAllocate();
         ++numElements;
         return { iterator(root), true };
     }
@@ -488,10 +656,10 @@ BST<T>::insert(T&& t, bool keepUnique)
     while (cur)
     {
         parent = cur;
-       if (keepUnique && (t == cur->data))
+       if (keepUnique && isEqual(t, cur->data))
            return { iterator(cur), false };
 
-        if (t < cur->data)
+        if (isLess(t, cur->data))
         {
             cur = cur->pLeft;
             wentLeft = true;
@@ -504,6 +672,7 @@ BST<T>::insert(T&& t, bool keepUnique)
     }
 
     BNode* n = new BNode(std::move(t));
+    this->onAllocate();
     if (wentLeft) parent->addLeft(n);
     else          parent->addRight(n);
 
@@ -515,8 +684,8 @@ BST<T>::insert(T&& t, bool keepUnique)
  * BST :: ERASE
  * Remove a given node as specified by the iterator
  ************************************************/
-template <typename T>
-typename BST<T>::iterator BST<T>::erase(iterator& it)
+template <typename T, class Counters>
+typename BST<T, Counters>::iterator BST<T, Counters>::erase(iterator& it)
 {
     BNode* z = it.pNode;
     if (!z) return end();
@@ -581,30 +750,289 @@ typename BST<T>::iterator BST<T>::erase(iterator& it)
 
 /*****************************************************
  * BST :: CLEAR
- * Removes all the BNodes from a tree
+ * Removes all the BNodes from a tree, taking it apart
+ * with takeSpare(): no recursion and no allocation, so
+ * a long chain is as safe as any tree.
  ****************************************************/
-template <typename T>
-void BST<T>::clear() noexcept
+template <typename T, class Counters>
+void BST<T, Counters>::clear() noexcept
 {
-    std::function<void(BNode*)> recurse = [&](BNode* p)
-    {
-        if (!p) return;
-        recurse(p->pLeft);
-        recurse(p->pRight);
+    BNode * pSpare = root;
+    root = nullptr;
+    numElements = 0;
+    while (BNode * p = takeSpare(pSpare))
         delete p;
-    };
+}
 
-    recurse(root);
+/*****************************************************
+ * BST :: TAKE SPARE
+ * The next node of a tree being taken apart: a left
+ * child is rotated up until the top node has none,
+ * then the top is handed out and its right child
+ * takes over. Nullptr once the tree is gone.
+ ****************************************************/
+template <typename T, class Counters>
+typename BST<T, Counters>::BNode * BST<T, Counters>::takeSpare(BNode * & pSpare) noexcept
+{
+    while (pSpare && pSpare->pLeft)
+    {
+        BNode * pLeft = pSpare->pLeft;
+        pSpare->pLeft = pLeft->pRight;
+        pLeft->pRight = pSpare;
+        pSpare = pLeft;
+    }
+    BNode * p = pSpare;
+    if (p)
+        pSpare = p->pRight;
+    return p;
+}
+
+/*****************************************************
+ * BST :: REUSE NODE
+ * A node holding t with no links: a spare given t by
+ * assignment, or a new one when the spares run out
+ ****************************************************/
+template <typename T, class Counters>
+template <class U>
+typename BST<T, Counters>::BNode * BST<T, Counters>::reuseNode(BNode * & pSpare, U && t)
+{
+    BNode * p = takeSpare(pSpare);
+    if (!p)
+    {
+        this->onAllocate();
+        return new BNode(std::forward<U>(t));
+    }
+    p->data = std::forward<U>(t);
+    p->pLeft = p->pRight = p->pParent = nullptr;
+    p->isRed = false;
+    return p;
+}
+
+/*****************************************************
+ * BST :: ASSIGN EACH
+ * Replace the contents with [first, last), inserted
+ * one after another as insert() would, each on a node
+ * that was here until they run out. With keepUnique an
+ * element equal to one already placed is skipped and
+ * costs nothing. Returns how many were placed.
+ ****************************************************/
+template <typename T, class Counters>
+template <class Iterator>
+size_t BST<T, Counters>::assignEach(Iterator first, Iterator last, bool keepUnique)
+{
+    BNode * pSpare = root;
     root = nullptr;
     numElements = 0;
+
+    for (; first != last; ++first)
+    {
+        BNode * pParent = nullptr;
+        bool isLeft = false;
+        bool isDuplicate = false;
+        for (BNode * p = root; p; p = isLeft ? p->pLeft : p->pRight)
+        {
+            pParent = p;
+            if (keepUnique && isEqual(*first, p->data))
+            {
+                isDuplicate = true;
+                break;
+            }
+            isLeft = isLess(*first, p->data);   // equal keys go right
+        }
+        if (isDuplicate)
+            continue;
+
+        BNode * n = reuseNode(pSpare, *first);
+        if (!pParent)     root = n;
+        else if (isLeft)  pParent->addLeft(n);
+        else              pParent->addRight(n);
+        ++numElements;
+    }
+
+    while (BNode * p = takeSpare(pSpare))
+        delete p;
+    return numElements;
+}
+
+/*****************************************************
+ * BST :: ERASE RANGE
+ * Remove every element in [lo, hi) without touching
+ * them one at a time. Every such node hangs below the
+ * first one the search for the range meets. Under it,
+ * its left subtree is trimmed down to what is below lo
+ * and its right subtree to what is at or above hi,
+ * each along one path, and whole subtrees that fall in
+ * the range come off in one piece. The two trimmed
+ * halves are joined and hung where the top node was.
+ * O(height + k) for k erased elements.
+ ****************************************************/
+template <typename T, class Counters>
+size_t BST<T, Counters>::eraseRange(const T& lo, const T& hi)
+{
+    // find the top-most node in the range
+    BNode * pParent = nullptr;
+    BNode * p = root;
+    while (p)
+    {
+        bool isBelow = isLess(p->data, lo);
+        if (!isBelow && isLess(p->data, hi))
+            break;
+        pParent = p;
+        p = isBelow ? p->pRight : p->pLeft;
+    }
+    if (!p)
+        return 0;
+
+    std::vector<BNode *> doomed;
+    doomed.push_back(p);
+
+    // keep only what is below lo from the left subtree
+    BNode * pLess = nullptr;
+    BNode ** ppSlot = &pLess;
+    BNode * pUp = nullptr;
+    for (BNode * q = p->pLeft; q; )
+        if (isLess(q->data, lo))
+        {
+            *ppSlot = q;
+            q->pParent = pUp;
+            pUp = q;
+            ppSlot = &q->pRight;
+            q = q->pRight;
+        }
+        else
+        {
+            BNode * pNext = q->pLeft;
+            q->pLeft = nullptr;
+            doomed.push_back(q);   // with its whole right subtree
+            q = pNext;
+        }
+    *ppSlot = nullptr;
+
+    // keep only what is at or above hi from the right subtree
+    BNode * pMore = nullptr;
+    ppSlot = &pMore;
+    pUp = nullptr;
+    for (BNode * q = p->pRight; q; )
+        if (!isLess(q->data, hi))
+        {
+            *ppSlot = q;
+            q->pParent = pUp;
+            pUp = q;
+            ppSlot = &q->pLeft;
+            q = q->pLeft;
+        }
+        else
+        {
+            BNode * pNext = q->pRight;
+            q->pRight = nullptr;
+            doomed.push_back(q);   // with its whole left subtree
+            q = pNext;
+        }
+    *ppSlot = nullptr;
+
+    // join: everything in pLess is smaller than everything in pMore
+    BNode * pJoined = pLess;
+    if (!pLess)
+        pJoined = pMore;
+    else
+    {
+        BNode * pMax = pLess;
+        while (pMax->pRight)
+            pMax = pMax->pRight;
+        pMax->addRight(pMore);
+    }
+
+    // hang the result where the top node of the range was
+    if (pJoined)
+        pJoined->pParent = pParent;
+    if (!pParent)
+        root = pJoined;
+    else if (pParent->pLeft == p)
+        pParent->pLeft = pJoined;
+    else
+        pParent->pRight = pJoined;
+
+    p->pLeft = p->pRight = nullptr;
+    size_t numErased = 0;
+    for (BNode * pDoomed : doomed)
+        numErased += deleteSubtree(pDoomed);
+    numElements -= numErased;
+    return numErased;
+}
+
+/*****************************************************
+ * BST :: ERASE IF
+ * Remove every element pred() says to, calling pred()
+ * once per element in order. When at least a quarter
+ * go, the survivors are relinked as a balanced tree
+ * in O(n); when fewer go, each is erased on its own.
+ ****************************************************/
+template <typename T, class Counters>
+template <class Predicate>
+size_t BST<T, Counters>::eraseIf(Predicate pred)
+{
+    // one pass sorts the nodes into the two piles, in order
+    std::vector<BNode *> survivors;
+    std::vector<BNode *> doomed;
+    survivors.reserve(numElements);
+    for (iterator it = begin(); it != end(); ++it)
+        if (pred(*it))
+            doomed.push_back(it.pNode);
+        else
+            survivors.push_back(it.pNode);
+    size_t numErased = doomed.size();
+
+    if (numErased * 4 < numElements)
+    {
+        for (BNode * p : doomed)
+        {
+            iterator it(p);
+            erase(it);
+        }
+        return numErased;
+    }
+
+    for (BNode * p : doomed)
+        delete p;
+    root = nullptr;
+    assignBalanced(survivors.size(), 1, [&survivors](size_t i) { return survivors[i]; },
+                   [](size_t) { return true; });
+    return numErased;
+}
+
+/*****************************************************
+ * BST :: DELETE SUBTREE
+ * Free a detached subtree, returning how many nodes
+ * it had. A stack, not recursion, so a long chain
+ * cannot blow the call stack.
+ ****************************************************/
+template <typename T, class Counters>
+size_t BST<T, Counters>::deleteSubtree(BNode * p)
+{
+    size_t num = 0;
+    std::vector<BNode *> pending;
+    if (p)
+        pending.push_back(p);
+    while (!pending.empty())
+    {
+        p = pending.back();
+        pending.pop_back();
+        if (p->pLeft)
+            pending.push_back(p->pLeft);
+        if (p->pRight)
+            pending.push_back(p->pRight);
+        delete p;
+        num++;
+    }
+    return num;
 }
 
 /*****************************************************
  * BST :: BEGIN
  * Return the first node (left-most) in a binary search tree
  ****************************************************/
-template <typename T>
-typename BST <T> :: iterator custom :: BST <T> :: begin() const noexcept
+template <typename T, class Counters>
+typename BST <T, Counters> :: iterator custom :: BST <T, Counters> :: begin() const noexcept
 {
     if (empty())
         return end();
@@ -619,16 +1047,16 @@ typename BST <T> :: iterator custom :: BST <T> :: begin() const noexcept
  * BST :: FIND
  * Return the node corresponding to a given value
  ****************************************************/
-template <typename T>
-typename BST <T> :: iterator BST<T> :: find(const T & t)
+template <typename T, class Counters>
+typename BST <T, Counters> :: iterator BST<T, Counters> :: find(const T & t)
 {
 
     BNode* p = root;
     while (p)
     {
-        if (p->data == t)
+        if (isEqual(p->data, t))
             return iterator(p);
-        else if (t < p->data)
+        else if (isLess(t, p->data))
             p = p->pLeft;
         else
             p = p->pRight;
@@ -636,6 +1064,228 @@ typename BST <T> :: iterator BST<T> :: find(const T & t)
    return end();
 }
 
+/****************************************************
+ * BST :: LOWER BOUND
+ * Return the first node that is not less than a given value
+ ****************************************************/
+template <typename T, class Counters>
+typename BST <T, Counters> :: iterator BST<T, Counters> :: lower_bound(const T & t) const
+{
+    BNode* p = root;
+    BNode* pBound = nullptr;
+    while (p)
+    {
+        if (isLess(p->data, t))
+            p = p->pRight;
+        else
+        {
+            pBound = p;   // candidate, but something smaller may be to the left
+            p = p->pLeft;
+        }
+    }
+   return iterator(pBound);
+}
+
+/****************************************************
+ * BST :: FIND BATCH
+ * Look up every key in [first, last) and call visit()
+ * with the result of each, in order. A group of keys
+ * descends together, one level per round, and each
+ * step prefetches the node it goes to; by the time the
+ * round comes back to that key the node is in cache.
+ * KeyIterator must be a forward iterator.
+ ****************************************************/
+template <typename T, class Counters>
+template <class KeyIterator, class Visit>
+void BST <T, Counters> :: findBatch(KeyIterator first, KeyIterator last, Visit visit) const
+{
+    const size_t GROUP = 16;
+    const T * keys[GROUP];
+    BNode * nodes[GROUP];
+    size_t active[GROUP];     // the keys still descending
+
+    while (first != last)
+    {
+        size_t num = 0;
+        for (; num < GROUP && first != last; ++first, ++num)
+        {
+            keys[num] = &*first;
+            nodes[num] = root;
+            active[num] = num;
+        }
+
+        // a finished key swaps places with the last active one
+        for (size_t numActive = num; numActive; )
+            for (size_t j = 0; j < numActive; )
+            {
+                size_t i = active[j];
+                BNode * p = nodes[i];
+                if (p && isLess(*keys[i], p->data))
+                    p = p->pLeft;
+                else if (p && isLess(p->data, *keys[i]))
+                    p = p->pRight;
+                else
+                {
+                    active[j] = active[--numActive];
+                    continue;
+                }
+                if (p)
+                    BST_PREFETCH(p);
+                nodes[i] = p;
+                j++;
+            }
+
+        for (size_t i = 0; i < num; i++)
+            visit(iterator(nodes[i]));
+    }
+}
+
+/****************************************************
+ * BST :: ASSIGN BALANCED
+ * Fill an empty tree with num elements, already sorted
+ * and unique, as a perfectly balanced tree. make(i) hands
+ * back the node for the i-th element, either a new one or
+ * one taken out of this tree by flatten(); isOld(i) says
+ * which, so only the old nodes count as recolored. The top
+ * few levels are built here and the subtrees below them on
+ * numThreads threads, so make() and isOld() must be safe
+ * to call concurrently.
+ ****************************************************/
+template <typename T, class Counters>
+template <class Make, class IsOld>
+void BST <T, Counters> :: assignBalanced(size_t num, size_t numThreads, Make make, IsOld isOld)
+{
+    assert(root == nullptr);
+    numElements = 0;
+    if (num == 0)
+        return;
+
+    // the deepest level is red so every path has the same black height
+    size_t redDepth = 0;
+    while (((size_t)2 << redDepth) <= num)
+        redDepth++;
+
+    // below spawnDepth every subtree is its own task
+    numThreads = parallel_threads(numThreads);
+    size_t spawnDepth = 0;
+    while (numThreads > 1 && ((size_t)1 << spawnDepth) < numThreads * 4 && spawnDepth < redDepth)
+        spawnDepth++;
+
+    struct Task
+    {
+        size_t iBegin;
+        size_t iEnd;
+        BNode * pParent;
+        bool isLeft;
+        size_t numRecolored;
+    };
+    std::vector<Task> tasks;
+    size_t numRecolored = 0;
+
+    auto top = [&](auto && self, size_t iBegin, size_t iEnd, size_t depth,
+                   BNode * pParent, bool isLeft) -> BNode *
+    {
+        if (iBegin >= iEnd)
+            return nullptr;
+        if (depth == spawnDepth)
+        {
+            tasks.push_back(Task{ iBegin, iEnd, pParent, isLeft, 0 });
+            return nullptr;
+        }
+        size_t iMiddle = iBegin + (iEnd - iBegin) / 2;
+        BNode * p = make(iMiddle);
+        p->pParent = nullptr;
+        paint(p, depth == redDepth && depth > 0, isOld(iMiddle), numRecolored);
+        p->addLeft (self(self, iBegin,      iMiddle, depth + 1, p, true));
+        p->addRight(self(self, iMiddle + 1, iEnd,    depth + 1, p, false));
+        return p;
+    };
+    root = top(top, 0, num, 0, nullptr, false);
+
+    // each task writes a different child pointer, so no locking
+    parallel_for(tasks.size(), numThreads, [&](size_t i)
+    {
+        Task & task = tasks[i];
+        BNode * p = buildBalanced(task.iBegin, task.iEnd, spawnDepth, redDepth, make, isOld,
+                                  task.numRecolored);
+        if (!task.pParent)
+            root = p;
+        else if (task.isLeft)
+            task.pParent->addLeft(p);
+        else
+            task.pParent->addRight(p);
+    });
+    for (const Task & task : tasks)
+        numRecolored += task.numRecolored;
+    this->onRecolor(numRecolored);
+    numElements = num;
+}
+
+/****************************************************
+ * BST :: BUILD BALANCED
+ * Build the subtree holding elements [iBegin, iEnd)
+ * with the middle one at the top. Returns its root,
+ * whose parent the caller fills in.
+ ****************************************************/
+template <typename T, class Counters>
+template <class Make, class IsOld>
+typename BST <T, Counters> :: BNode * BST <T, Counters> :: buildBalanced(size_t iBegin, size_t iEnd,
+                                                     size_t depth, size_t redDepth, Make & make,
+                                                     IsOld & isOld, size_t & numRecolored)
+{
+    if (iBegin >= iEnd)
+        return nullptr;
+    // in order, so the nodes are touched (or allocated) in the
+    // order an iterator will later visit them
+    size_t iMiddle = iBegin + (iEnd - iBegin) / 2;
+    BNode * pLeft = buildBalanced(iBegin, iMiddle, depth + 1, redDepth, make, isOld, numRecolored);
+    BNode * p = make(iMiddle);
+    p->pParent = nullptr;
+    paint(p, depth == redDepth && depth > 0, isOld(iMiddle), numRecolored);
+    p->addLeft(pLeft);
+    p->addRight(buildBalanced(iMiddle + 1, iEnd, depth + 1, redDepth, make, isOld, numRecolored));
+    return p;
+}
+
+/****************************************************
+ * BST :: PAINT
+ * Color a node, counting it when an old node's color
+ * changes. The first color of a new node is not a
+ * recoloring. Nothing is counted without counters.
+ ****************************************************/
+template <typename T, class Counters>
+void BST <T, Counters> :: paint(BNode * p, bool isRed, bool isOld, size_t & numRecolored)
+{
+    if (Counters::isEnabled && isOld)
+        numRecolored += p->isRed != isRed;
+    p->isRed = isRed;
+}
+
+/****************************************************
+ * BST :: FLATTEN
+ * Take every node out of the tree, in order, and
+ * leave the tree empty. The nodes are not freed;
+ * the caller relinks them with assignBalanced().
+ ****************************************************/
+template <typename T, class Counters>
+void BST <T, Counters> :: flatten(std::vector<BNode *> & nodes)
+{
+    nodes.reserve(nodes.size() + numElements);
+    std::vector<BNode *> stack;
+    BNode * p = root;
+    while (p || !stack.empty())
+    {
+        for (; p; p = p->pLeft)
+            stack.push_back(p);
+        p = stack.back();
+        stack.pop_back();
+        nodes.push_back(p);
+        p = p->pRight;
+    }
+    root = nullptr;
+    numElements = 0;
+}
+
 /******************************************************
  ******************************************************
  ******************************************************
@@ -649,8 +1299,8 @@ typename BST <T> :: iterator BST<T> :: find(const T & t)
  * BINARY NODE :: ADD LEFT
  * Add a node to the left of the current node
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addLeft (BNode * pNode)
+template <typename T, class Counters>
+void BST <T, Counters> :: BNode :: addLeft (BNode * pNode)
 {
     // if homeboy does then make pLeft pAdd
     this->pLeft = pNode;
@@ -664,8 +1314,8 @@ void BST <T> :: BNode :: addLeft (BNode * pNode)
  * BINARY NODE :: ADD RIGHT
  * Add a node to the right of the current node
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addRight (BNode * pNode)
+template <typename T, class Counters>
+void BST <T, Counters> :: BNode :: addRight (BNode * pNode)
 {
     // if homeboy does then make pLeft pAdd
     this->pRight = pNode;
@@ -679,8 +1329,8 @@ void BST <T> :: BNode :: addRight (BNode * pNode)
  * BINARY NODE :: ADD LEFT
  * Add a node to the left of the current node
  ******************************************************/
-template <typename T>
-void BST<T> :: BNode :: addLeft (const T & t)
+template <typename T, class Counters>
+void BST<T, Counters> :: BNode :: addLeft (const T & t)
 {
     // copy the node
     BNode* pNew = new BNode(t);
@@ -693,8 +1343,8 @@ void BST<T> :: BNode :: addLeft (const T & t)
  * BINARY NODE :: ADD LEFT
  * Add a node to the left of the current node
  ******************************************************/
-template <typename T>
-void BST<T> ::BNode::addLeft(T && t)
+template <typename T, class Counters>
+void BST<T, Counters> ::BNode::addLeft(T && t)
 {
     // move the node instead of copying it
     BNode* pNew = new BNode(std::move(t));
@@ -707,8 +1357,8 @@ void BST<T> ::BNode::addLeft(T && t)
  * BINARY NODE :: ADD RIGHT
  * Add a node to the right of the current node
  ******************************************************/
-template <typename T>
-void BST <T> :: BNode :: addRight (const T & t)
+template <typename T, class Counters>
+void BST <T, Counters> :: BNode :: addRight (const T & t)
 {
     // copy the node
     BNode* pNew = new BNode(t);
@@ -721,8 +1371,8 @@ void BST <T> :: BNode :: addRight (const T & t)
  * BINARY NODE :: ADD RIGHT
  * Add a node to the right of the current node
  ******************************************************/
-template <typename T>
-void BST <T> ::BNode::addRight(T && t)
+template <typename T, class Counters>
+void BST <T, Counters> ::BNode::addRight(T && t)
 {
     // move the node instead of copying it
     BNode* pNew = new BNode(std::move(t));
@@ -745,8 +1395,8 @@ void BST <T> ::BNode::addRight(T && t)
  * BST ITERATOR :: INCREMENT PREFIX
  * advance by one
  *************************************************/
-template <typename T>
-typename BST <T> :: iterator & BST <T> :: iterator :: operator ++ ()
+template <typename T, class Counters>
+typename BST <T, Counters> :: iterator & BST <T, Counters> :: iterator :: operator ++ ()
 {
     if (!pNode)
         return *this;
@@ -778,8 +1428,8 @@ typename BST <T> :: iterator & BST <T> :: iterator :: operator ++ ()
  * BST ITERATOR :: DECREMENT PREFIX
  * advance by one
  *************************************************/
-template <typename T>
-typename BST<T>::iterator& BST<T>::iterator::operator--()
+template <typename T, class Counters>
+typename BST<T, Counters>::iterator& BST<T, Counters>::iterator::operator--()
 {
    // If we're already at end(), stay there
    if (pNode == nullptr)
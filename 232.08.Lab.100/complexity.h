@@ -0,0 +1,181 @@
+/***********************************************************************
+ * Header:
+ *    Complexity
+ * Summary:
+ *    Measure a cost, such as a Spy counter, at n = nMin, 2 nMin, 4 nMin
+ *    ... nMax and hold it to a growth model. A wall clock cannot tell
+ *    an O(log n) find from an O(n) one at the sizes a unit test can
+ *    afford, but a count of comparisons can, exactly.
+ *
+ *    A budget caps the cost at coefficient * f(n) + constant for one
+ *    of O(1), O(log n), O(n), O(n log n) and O(n^2). fit() names the
+ *    smallest of those the cost does not outgrow.
+ *
+ *    This will contain the class definition of:
+ *        complexity          : Sampling, budgets, and fitting
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cmath>       // for std::log2
+#include <cstddef>     // for size_t
+#include <string>
+#include <vector>
+
+namespace custom
+{
+
+/************************************************
+ * COMPLEXITY
+ * Growth models and the samples to check them on
+ ***********************************************/
+class complexity
+{
+public:
+
+   enum Order { CONSTANT, LOGARITHMIC, LINEAR, LINEARITHMIC, QUADRATIC };
+
+   // the cost of one operation at one size
+   struct Sample
+   {
+      size_t n;
+      double cost;
+   };
+
+   // no more than coefficient * f(n) + constant
+   struct Budget
+   {
+      Order  order;
+      double coefficient;
+      double constant;
+
+      double limit(size_t n) const
+      {
+         return coefficient * model(order, n) + constant;
+      }
+   };
+
+   /*************************************************************
+    * SAMPLE
+    * measure(n) at every power of two times nMin up to nMax
+    *************************************************************/
+   template <class Measure>
+   static std::vector<Sample> sample(size_t nMin, size_t nMax, Measure measure)
+   {
+      assert(nMin > 0 && nMin <= nMax);
+      std::vector<Sample> samples;
+      for (size_t n = nMin; n <= nMax; n *= 2)
+         samples.push_back(Sample{ n, (double)measure(n) });
+      return samples;
+   }
+
+   /*************************************************************
+    * MODEL
+    * f(n) for an order. Log n is counted from 1 so that a
+    * single level of a tree still costs something.
+    *************************************************************/
+   static double model(Order order, size_t n)
+   {
+      double logN = std::log2((double)(n ? n : 1)) + 1.0;
+      switch (order)
+      {
+         case CONSTANT:     return 1.0;
+         case LOGARITHMIC:  return logN;
+         case LINEAR:       return (double)n;
+         case LINEARITHMIC: return (double)n * logN;
+         case QUADRATIC:    return (double)n * (double)n;
+      }
+      return 0.0;
+   }
+
+   static std::string name(Order order)
+   {
+      const char * names[] = { "O(1)", "O(log n)", "O(n)", "O(n log n)", "O(n^2)" };
+      return names[order];
+   }
+
+   /*************************************************************
+    * WITHIN BUDGET
+    * Whether every sample is under the limit. When one is not
+    * and pOver is given, it gets the sample furthest over.
+    *************************************************************/
+   static bool withinBudget(const std::vector<Sample> & samples, const Budget & budget,
+                            Sample * pOver = nullptr)
+   {
+      bool isWithin = true;
+      double excessMax = 0.0;
+      for (const Sample & sample : samples)
+      {
+         double excess = sample.cost - budget.limit(sample.n);
+         if (excess > excessMax)
+         {
+            isWithin = false;
+            excessMax = excess;
+            if (pOver)
+               *pOver = sample;
+         }
+      }
+      return isWithin;
+   }
+
+   /*************************************************************
+    * FIT
+    * The smallest order the cost grows no faster than. A cost
+    * is O(1) when it ends no more than GROWTH_MAX times where it
+    * started. Otherwise, for each order, compare the slope of
+    * cost against f(n) over the smaller half of the sizes with
+    * the slope over the larger half: the constant term drops out
+    * of a slope, and when f(n) grows too slowly for the cost the
+    * second slope is steeper than the first.
+    *************************************************************/
+   static Order fit(const std::vector<Sample> & samples)
+   {
+      assert(samples.size() >= 3);
+      if (samples.back().cost <= samples.front().cost * GROWTH_MAX)
+         return CONSTANT;
+
+      size_t iMiddle = samples.size() / 2;
+      for (int order = LOGARITHMIC; order < QUADRATIC; order++)
+      {
+         double slopeSmall = slope(samples, (Order)order, 0, iMiddle + 1);
+         double slopeLarge = slope(samples, (Order)order, iMiddle, samples.size());
+         if (slopeLarge <= slopeSmall * GROWTH_MAX)
+            return (Order)order;
+      }
+      return QUADRATIC;
+   }
+
+private:
+
+   // over a range of 2^7 sizes or more, log n grows by more than
+   // this and the slope of n log n against n grows by about this
+   static constexpr double GROWTH_MAX = 1.3;
+
+   /*************************************************************
+    * SLOPE
+    * Least squares slope of cost against f(n) over
+    * samples[iBegin, iEnd)
+    *************************************************************/
+   static double slope(const std::vector<Sample> & samples, Order order,
+                       size_t iBegin, size_t iEnd)
+   {
+      double num = (double)(iEnd - iBegin);
+      double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+      for (size_t i = iBegin; i < iEnd; i++)
+      {
+         double x = model(order, samples[i].n);
+         double y = samples[i].cost;
+         sumX += x;
+         sumY += y;
+         sumXX += x * x;
+         sumXY += x * y;
+      }
+      double denominator = num * sumXX - sumX * sumX;
+      return denominator == 0.0 ? 0.0 : (num * sumXY - sumX * sumY) / denominator;
+   }
+};
+
+}; // namespace custom
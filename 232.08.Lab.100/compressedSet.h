@@ -0,0 +1,583 @@
+/***********************************************************************
+ * Header:
+ *    Compressed Set
+ * Summary:
+ *    Read-mostly sets that keep their elements sorted and compressed
+ *    instead of one BNode each. They are built once from a range and
+ *    then support iteration, find, and lower_bound.
+ *
+ *    Integers are cut into blocks of 128. Each block keeps its first
+ *    value in full and the gaps to the rest bit-packed at the width of
+ *    the largest gap, so dense ids cost a byte or two apiece.
+ *
+ *    Strings are cut into blocks of 16 and front coded: the first
+ *    string of a block is stored whole, each later one as the length
+ *    it shares with the string before it plus the rest. URLs and paths
+ *    share long prefixes, so most of each string disappears.
+ *
+ *    A lookup binary searches the first element of every block, then
+ *    decodes one block from its start.
+ *
+ *    This will contain the class definition of:
+ *        compressed_int_set           : Delta and bit-packed integers
+ *        compressed_int_set::iterator : Decodes as it goes
+ *        compressed_string_set        : Front-coded strings
+ *        compressed_string_set::iterator
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>     // for uint64_t and uint8_t
+#include <cstring>     // for memcmp
+#include <vector>      // for std::vector
+#include <string>      // for std::string
+#include <algorithm>   // for std::sort, std::unique, and std::upper_bound
+#include <type_traits> // for std::is_integral and std::is_signed
+
+class TestCompressedSet;   // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * COMPRESSED INT SET
+ * Sorted integers as blocks of bit-packed gaps
+ ***********************************************/
+template <typename T>
+class compressed_int_set
+{
+   static_assert(std::is_integral<T>::value, "compressed_int_set needs an integer T");
+   friend class ::TestCompressedSet; // give unit tests access to the privates
+public:
+
+   //
+   // Construct
+   //
+   compressed_int_set() : numElements(0)
+   {
+   }
+   template <class Iterator>
+   compressed_int_set(Iterator first, Iterator last);
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end()   const;
+
+   //
+   // Access
+   //
+   iterator lower_bound(const T & t) const;
+   iterator find(const T & t) const;
+   bool contains(const T & t) const
+   {
+      return find(t) != end();
+   }
+
+   //
+   // Status
+   //
+   bool   empty()  const noexcept { return numElements == 0; }
+   size_t size()   const noexcept { return numElements;      }
+   size_t memory() const noexcept
+   {
+      return sizeof(*this) +
+             (firsts.capacity() + offsets.capacity() + bits.capacity()) * sizeof(uint64_t) +
+             widths.capacity();
+   }
+
+private:
+
+   static const size_t BLOCK = 128;
+
+   // signed values are shifted so their order survives as unsigned
+   static uint64_t toOrdinal(T t)
+   {
+      return std::is_signed<T>::value ? (uint64_t)(int64_t)t ^ 0x8000000000000000ULL
+                                      : (uint64_t)t;
+   }
+   static T fromOrdinal(uint64_t u)
+   {
+      return std::is_signed<T>::value ? (T)(int64_t)(u ^ 0x8000000000000000ULL)
+                                      : (T)u;
+   }
+   uint64_t readBits(uint64_t bitPos, unsigned width) const;
+   void     writeBits(uint64_t & bitPos, uint64_t value, unsigned width);
+
+   std::vector<uint64_t> firsts;    // first element of each block
+   std::vector<uint64_t> offsets;   // bit where each block's gaps start
+   std::vector<uint8_t>  widths;    // bits per gap in each block
+   std::vector<uint64_t> bits;      // every block's gaps, packed
+   size_t numElements;              // number of elements
+};
+
+/**************************************************
+ * COMPRESSED INT SET ITERATOR
+ * Remembers where the next gap starts, so each
+ * increment decodes just one
+ *************************************************/
+template <typename T>
+class compressed_int_set <T> :: iterator
+{
+   friend class ::TestCompressedSet; // give unit tests access to the privates
+   friend class custom::compressed_int_set<T>;
+public:
+   iterator() : pSet(nullptr), iElement(0), bitPos(0), ordinal(0), value(T()) {}
+
+   // equals, not equals operator
+   bool operator == (const iterator & rhs) const { return iElement == rhs.iElement; }
+   bool operator != (const iterator & rhs) const { return iElement != rhs.iElement; }
+
+   // dereference operator
+   const T & operator * () const
+   {
+      assert(pSet && iElement < pSet->numElements);
+      return value;
+   }
+
+   // prefix increment
+   iterator & operator ++ ()
+   {
+      if (++iElement < pSet->numElements)
+      {
+         size_t iBlock = iElement / BLOCK;
+         if (iElement % BLOCK == 0)
+         {
+            ordinal = pSet->firsts[iBlock];
+            bitPos  = pSet->offsets[iBlock];
+         }
+         else
+         {
+            unsigned width = pSet->widths[iBlock];
+            ordinal += pSet->readBits(bitPos, width);
+            bitPos  += width;
+         }
+         value = fromOrdinal(ordinal);
+      }
+      return *this;
+   }
+
+   // postfix increment
+   iterator operator ++ (int postfix)
+   {
+      iterator old(*this);
+      ++(*this);
+      return old;
+   }
+
+private:
+   iterator(const compressed_int_set * pSet, size_t iElement) :
+      pSet(pSet), iElement(iElement), bitPos(0), ordinal(0), value(T())
+   {
+      if (iElement < pSet->numElements)
+      {
+         assert(iElement % BLOCK == 0);
+         ordinal = pSet->firsts[iElement / BLOCK];
+         bitPos  = pSet->offsets[iElement / BLOCK];
+         value   = fromOrdinal(ordinal);
+      }
+   }
+
+   const compressed_int_set * pSet;
+   size_t   iElement;   // index of the current element, numElements at the end
+   uint64_t bitPos;     // where the next gap in this block starts
+   uint64_t ordinal;    // the current element, as an ordinal
+   T        value;      // the current element
+};
+
+/*********************************************
+ * COMPRESSED INT SET :: CONSTRUCTOR
+ * Sort and dedup the range if it is not already
+ * (a custom::set always is), then pack it
+ ********************************************/
+template <typename T>
+template <class Iterator>
+compressed_int_set <T> :: compressed_int_set(Iterator first, Iterator last) : numElements(0)
+{
+   std::vector<uint64_t> values;
+   bool isSorted = true;
+   for (; first != last; ++first)
+   {
+      uint64_t u = toOrdinal(*first);
+      isSorted = isSorted && (values.empty() || values.back() < u);
+      values.push_back(u);
+   }
+   if (!isSorted)
+   {
+      std::sort(values.begin(), values.end());
+      values.erase(std::unique(values.begin(), values.end()), values.end());
+   }
+
+   numElements = values.size();
+   size_t numBlocks = (numElements + BLOCK - 1) / BLOCK;
+   firsts.reserve(numBlocks);
+   offsets.reserve(numBlocks);
+   widths.reserve(numBlocks);
+
+   uint64_t bitPos = 0;
+   for (size_t iBegin = 0; iBegin < numElements; iBegin += BLOCK)
+   {
+      size_t iEnd = std::min(iBegin + BLOCK, numElements);
+      uint64_t gapMax = 0;
+      for (size_t i = iBegin + 1; i < iEnd; i++)
+         gapMax = std::max(gapMax, values[i] - values[i - 1]);
+      unsigned width = 0;
+      while (width < 64 && (gapMax >> width) != 0)
+         width++;
+
+      firsts.push_back(values[iBegin]);
+      offsets.push_back(bitPos);
+      widths.push_back((uint8_t)width);
+      for (size_t i = iBegin + 1; i < iEnd; i++)
+         writeBits(bitPos, values[i] - values[i - 1], width);
+   }
+   bits.shrink_to_fit();
+}
+
+/*********************************************
+ * COMPRESSED INT SET :: BEGIN and END
+ ********************************************/
+template <typename T>
+typename compressed_int_set <T> :: iterator compressed_int_set <T> :: begin() const
+{
+   return iterator(this, 0);
+}
+template <typename T>
+typename compressed_int_set <T> :: iterator compressed_int_set <T> :: end() const
+{
+   return iterator(this, numElements);
+}
+
+/*********************************************
+ * COMPRESSED INT SET :: LOWER BOUND
+ * The last block starting at or before t is the
+ * only one that can hold it; decode from there
+ ********************************************/
+template <typename T>
+typename compressed_int_set <T> :: iterator compressed_int_set <T> :: lower_bound(const T & t) const
+{
+   uint64_t u = toOrdinal(t);
+   auto itBlock = std::upper_bound(firsts.begin(), firsts.end(), u);
+   if (itBlock == firsts.begin())
+      return begin();
+
+   iterator it(this, (size_t)(itBlock - firsts.begin() - 1) * BLOCK);
+   while (it.iElement < numElements && it.ordinal < u)
+      ++it;
+   return it;
+}
+
+/*********************************************
+ * COMPRESSED INT SET :: FIND
+ ********************************************/
+template <typename T>
+typename compressed_int_set <T> :: iterator compressed_int_set <T> :: find(const T & t) const
+{
+   iterator it = lower_bound(t);
+   return (it != end() && it.ordinal == toOrdinal(t)) ? it : end();
+}
+
+/*********************************************
+ * COMPRESSED INT SET :: READ BITS
+ * width bits starting at bitPos, which may
+ * straddle two words
+ ********************************************/
+template <typename T>
+uint64_t compressed_int_set <T> :: readBits(uint64_t bitPos, unsigned width) const
+{
+   if (width == 0)
+      return 0;
+   size_t iWord = (size_t)(bitPos / 64);
+   unsigned shift = (unsigned)(bitPos % 64);
+   uint64_t value = bits[iWord] >> shift;
+   if (shift + width > 64)
+      value |= bits[iWord + 1] << (64 - shift);
+   return width == 64 ? value : value & ((1ULL << width) - 1);
+}
+
+/*********************************************
+ * COMPRESSED INT SET :: WRITE BITS
+ * Append width bits at bitPos and advance it
+ ********************************************/
+template <typename T>
+void compressed_int_set <T> :: writeBits(uint64_t & bitPos, uint64_t value, unsigned width)
+{
+   if (width == 0)
+      return;
+   size_t iWord = (size_t)(bitPos / 64);
+   unsigned shift = (unsigned)(bitPos % 64);
+   if (iWord >= bits.size())
+      bits.push_back(0);
+   bits[iWord] |= value << shift;
+   if (shift + width > 64)
+      bits.push_back(value >> (64 - shift));
+   bitPos += width;
+}
+
+/************************************************
+ * COMPRESSED STRING SET
+ * Sorted strings as blocks of front-coded entries
+ ***********************************************/
+class compressed_string_set
+{
+   friend class ::TestCompressedSet; // give unit tests access to the privates
+public:
+
+   //
+   // Construct
+   //
+   compressed_string_set() : numElements(0)
+   {
+   }
+   template <class Iterator>
+   compressed_string_set(Iterator first, Iterator last);
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end()   const;
+
+   //
+   // Access
+   //
+   iterator lower_bound(const std::string & t) const;
+   iterator find(const std::string & t) const;
+   bool contains(const std::string & t) const;
+
+   //
+   // Status
+   //
+   bool   empty()  const noexcept { return numElements == 0; }
+   size_t size()   const noexcept { return numElements;      }
+   size_t memory() const noexcept
+   {
+      return sizeof(*this) + bytes.capacity() + offsets.capacity() * sizeof(uint64_t);
+   }
+
+private:
+
+   static const size_t BLOCK = 16;
+
+   static void     putVarint(std::vector<char> & out, uint64_t value);
+   static uint64_t getVarint(const char * & p);
+   int compareFirst(size_t iBlock, const std::string & t) const;
+
+   std::vector<char>     bytes;     // every entry, one after another
+   std::vector<uint64_t> offsets;   // where each block's first entry starts
+   size_t numElements;              // number of elements
+};
+
+/**************************************************
+ * COMPRESSED STRING SET ITERATOR
+ * Rebuilds each string from the one before it
+ *************************************************/
+class compressed_string_set :: iterator
+{
+   friend class ::TestCompressedSet; // give unit tests access to the privates
+   friend class custom::compressed_string_set;
+public:
+   iterator() : pSet(nullptr), iElement(0), pNext(nullptr) {}
+
+   // equals, not equals operator
+   bool operator == (const iterator & rhs) const { return iElement == rhs.iElement; }
+   bool operator != (const iterator & rhs) const { return iElement != rhs.iElement; }
+
+   // dereference operator
+   const std::string & operator * () const
+   {
+      assert(pSet && iElement < pSet->numElements);
+      return value;
+   }
+
+   // prefix increment
+   iterator & operator ++ ()
+   {
+      if (++iElement < pSet->numElements)
+         decode();
+      return *this;
+   }
+
+   // postfix increment
+   iterator operator ++ (int postfix)
+   {
+      iterator old(*this);
+      ++(*this);
+      return old;
+   }
+
+private:
+   iterator(const compressed_string_set * pSet, size_t iElement) :
+      pSet(pSet), iElement(iElement), pNext(nullptr)
+   {
+      if (iElement < pSet->numElements)
+      {
+         assert(iElement % BLOCK == 0);
+         pNext = pSet->bytes.data() + pSet->offsets[iElement / BLOCK];
+         decode();
+      }
+   }
+
+   // the entry at pNext, whole at the start of a block, else front coded
+   void decode()
+   {
+      size_t numShared = (iElement % BLOCK == 0) ? 0 : (size_t)getVarint(pNext);
+      size_t numRest = (size_t)getVarint(pNext);
+      value.resize(numShared);
+      value.append(pNext, numRest);
+      pNext += numRest;
+   }
+
+   const compressed_string_set * pSet;
+   size_t       iElement;   // index of the current element, numElements at the end
+   const char * pNext;      // the entry after the current one
+   std::string  value;      // the current element
+};
+
+/*********************************************
+ * COMPRESSED STRING SET :: CONSTRUCTOR
+ * Sort and dedup the range if it is not already
+ * (a custom::set always is), then front code it
+ ********************************************/
+template <class Iterator>
+compressed_string_set :: compressed_string_set(Iterator first, Iterator last) : numElements(0)
+{
+   std::vector<std::string> values;
+   bool isSorted = true;
+   for (; first != last; ++first)
+   {
+      isSorted = isSorted && (values.empty() || values.back() < *first);
+      values.push_back(*first);
+   }
+   if (!isSorted)
+   {
+      std::sort(values.begin(), values.end());
+      values.erase(std::unique(values.begin(), values.end()), values.end());
+   }
+
+   numElements = values.size();
+   offsets.reserve((numElements + BLOCK - 1) / BLOCK);
+   for (size_t i = 0; i < numElements; i++)
+   {
+      size_t numShared = 0;
+      if (i % BLOCK == 0)
+         offsets.push_back(bytes.size());
+      else
+      {
+         const std::string & prev = values[i - 1];
+         while (numShared < prev.size() && numShared < values[i].size() &&
+                prev[numShared] == values[i][numShared])
+            numShared++;
+         putVarint(bytes, numShared);
+      }
+      putVarint(bytes, values[i].size() - numShared);
+      bytes.insert(bytes.end(), values[i].begin() + numShared, values[i].end());
+   }
+   bytes.shrink_to_fit();
+}
+
+/*********************************************
+ * COMPRESSED STRING SET :: BEGIN and END
+ ********************************************/
+inline compressed_string_set :: iterator compressed_string_set :: begin() const
+{
+   return iterator(this, 0);
+}
+inline compressed_string_set :: iterator compressed_string_set :: end() const
+{
+   return iterator(this, numElements);
+}
+
+/*********************************************
+ * COMPRESSED STRING SET :: LOWER BOUND
+ * Binary search the whole first strings of the
+ * blocks without decoding anything else
+ ********************************************/
+inline compressed_string_set :: iterator compressed_string_set :: lower_bound(const std::string & t) const
+{
+   // the first block whose first string is greater than t
+   size_t iLow = 0;
+   size_t iHigh = offsets.size();
+   while (iLow < iHigh)
+   {
+      size_t iMiddle = iLow + (iHigh - iLow) / 2;
+      if (compareFirst(iMiddle, t) <= 0)
+         iLow = iMiddle + 1;
+      else
+         iHigh = iMiddle;
+   }
+   if (iLow == 0)
+      return begin();
+
+   iterator it(this, (iLow - 1) * BLOCK);
+   while (it.iElement < numElements && it.value < t)
+      ++it;
+   return it;
+}
+
+/*********************************************
+ * COMPRESSED STRING SET :: FIND
+ ********************************************/
+inline compressed_string_set :: iterator compressed_string_set :: find(const std::string & t) const
+{
+   iterator it = lower_bound(t);
+   return (it != end() && it.value == t) ? it : end();
+}
+inline bool compressed_string_set :: contains(const std::string & t) const
+{
+   return find(t) != end();
+}
+
+/*********************************************
+ * COMPRESSED STRING SET :: COMPARE FIRST
+ * Compare the first string of a block with t,
+ * in place, like std::string::compare
+ ********************************************/
+inline int compressed_string_set :: compareFirst(size_t iBlock, const std::string & t) const
+{
+   const char * p = bytes.data() + offsets[iBlock];
+   size_t num = (size_t)getVarint(p);
+   int result = memcmp(p, t.data(), std::min(num, t.size()));
+   if (result != 0)
+      return result;
+   return num < t.size() ? -1 : (num > t.size() ? 1 : 0);
+}
+
+/*********************************************
+ * COMPRESSED STRING SET :: PUT VARINT
+ * Low seven bits first, the high bit set on
+ * every byte but the last
+ ********************************************/
+inline void compressed_string_set :: putVarint(std::vector<char> & out, uint64_t value)
+{
+   while (value >= 0x80)
+   {
+      out.push_back((char)((value & 0x7f) | 0x80));
+      value >>= 7;
+   }
+   out.push_back((char)value);
+}
+
+/*********************************************
+ * COMPRESSED STRING SET :: GET VARINT
+ * Read one and move p past it
+ ********************************************/
+inline uint64_t compressed_string_set :: getVarint(const char * & p)
+{
+   uint64_t value = 0;
+   for (int shift = 0; ; shift += 7)
+   {
+      unsigned char c = (unsigned char)*p++;
+      value |= (uint64_t)(c & 0x7f) << shift;
+      if (!(c & 0x80))
+         return value;
+   }
+}
+
+}; // namespace custom
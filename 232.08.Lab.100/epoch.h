@@ -0,0 +1,233 @@
+/***********************************************************************
+ * Header:
+ *    Epoch
+ * Summary:
+ *    Epoch-based memory reclamation for the lock-free containers.
+ *    A node unlinked by one thread may still be read by another, so
+ *    instead of deleting it the remover retires it. A retired node is
+ *    only destroyed once every thread has been seen outside of its
+ *    critical section twice since the node was retired.
+ *
+ *    This will contain the class definition of:
+ *        epoch_domain        : The global epoch and the per-thread records
+ *        epoch_guard         : Pins the current thread for a scope
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <atomic>     // for std::atomic
+#include <vector>     // for std::vector
+#include <cstddef>    // for size_t
+#include <cstdint>    // for uint64_t
+
+namespace custom
+{
+
+/************************************************
+ * EPOCH DOMAIN
+ * Every thread touching a lock-free container owns
+ * one record. A record publishes the epoch the thread
+ * entered in (low bit set while inside) and holds the
+ * nodes that thread has retired.
+ ***********************************************/
+class epoch_domain
+{
+public:
+   static epoch_domain & instance()
+   {
+      static epoch_domain domain;
+      return domain;
+   }
+
+   //
+   // Critical sections, these nest
+   //
+   void enter()
+   {
+      Record * pRecord = local();
+      if (pRecord->depth++ == 0)
+      {
+         uint64_t epoch = globalEpoch.load();
+         pRecord->state.store((epoch << 1) | 1);
+      }
+   }
+   void exit()
+   {
+      Record * pRecord = local();
+      assert(pRecord->depth > 0);
+      if (--pRecord->depth == 0)
+         pRecord->state.store(0, std::memory_order_release);
+   }
+
+   //
+   // Reclamation
+   //
+   //
+   // Past the threshold a retire tries to advance the epoch, but
+   // only scans its list when the epoch has moved since the last
+   // scan: while a reader stays pinned nothing more can be freed,
+   // and rescanning on every retire would make retiring quadratic.
+   //
+   void retire(void * p, void (*destroy)(void *))
+   {
+      Record * pRecord = local();
+      pRecord->retired.push_back(Retired{ p, destroy, globalEpoch.load() });
+      if (pRecord->retired.size() >= RECLAIM_THRESHOLD)
+      {
+         tryAdvance();
+         if (globalEpoch.load() != pRecord->epochCollected)
+            collect(pRecord);
+      }
+   }
+
+   // destroy whatever the calling thread can; used when the
+   // caller knows it is quiescent (tests, shutdown)
+   void reclaim()
+   {
+      Record * pRecord = local();
+      for (int i = 0; i < 3 && pRecord->depth == 0; i++)
+         tryAdvance();
+      collect(pRecord);
+   }
+
+private:
+   static const size_t RECLAIM_THRESHOLD = 64;
+
+   // a node waiting for every reader to move on
+   struct Retired
+   {
+      void *   p;
+      void   (*destroy)(void *);
+      uint64_t epoch;             // global epoch when it was retired
+   };
+
+   // one per thread, reused when a thread exits
+   struct Record
+   {
+      Record() : state(0), inUse(true), pNext(nullptr), depth(0), epochCollected(0) {}
+      std::atomic<uint64_t> state;   // (epoch << 1) | active
+      std::atomic<bool>     inUse;   // owned by a live thread
+      Record *              pNext;   // next record in the domain
+      size_t                depth;   // nesting of enter()
+      uint64_t              epochCollected; // global epoch at the last collect()
+      std::vector<Retired>  retired; // only touched by the owner
+   };
+
+   // hands the record back when the thread exits
+   struct Owner
+   {
+      Record * pRecord = nullptr;
+      ~Owner()
+      {
+         if (pRecord)
+            pRecord->inUse.store(false);
+      }
+   };
+
+   epoch_domain() : globalEpoch(0), pHead(nullptr) {}
+   ~epoch_domain()
+   {
+      // every thread is gone, so everything retired is unreachable
+      Record * pRecord = pHead.load();
+      while (pRecord)
+      {
+         Record * pNext = pRecord->pNext;
+         for (auto & retired : pRecord->retired)
+            retired.destroy(retired.p);
+         delete pRecord;
+         pRecord = pNext;
+      }
+   }
+
+   /*************************************************************
+    * LOCAL
+    * The record owned by the calling thread
+    *************************************************************/
+   Record * local()
+   {
+      static thread_local Owner owner;
+      if (!owner.pRecord)
+         owner.pRecord = acquire();
+      return owner.pRecord;
+   }
+
+   /*************************************************************
+    * ACQUIRE
+    * Reuse a record a finished thread left behind, or add one
+    *************************************************************/
+   Record * acquire()
+   {
+      for (Record * pRecord = pHead.load(); pRecord; pRecord = pRecord->pNext)
+      {
+         bool inUse = false;
+         if (pRecord->inUse.compare_exchange_strong(inUse, true))
+            return pRecord;
+      }
+
+      Record * pRecord = new Record;
+      Record * pOldHead = pHead.load();
+      do
+         pRecord->pNext = pOldHead;
+      while (!pHead.compare_exchange_weak(pOldHead, pRecord));
+      return pRecord;
+   }
+
+   /*************************************************************
+    * TRY ADVANCE
+    * Move the global epoch forward if no thread is still
+    * inside a critical section from an older epoch
+    *************************************************************/
+   void tryAdvance()
+   {
+      uint64_t epoch = globalEpoch.load();
+      for (Record * pRecord = pHead.load(); pRecord; pRecord = pRecord->pNext)
+      {
+         uint64_t state = pRecord->state.load();
+         if ((state & 1) && (state >> 1) != epoch)
+            return;
+      }
+      globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+   }
+
+   /*************************************************************
+    * COLLECT
+    * Destroy the nodes retired at least two epochs ago
+    *************************************************************/
+   void collect(Record * pRecord)
+   {
+      uint64_t epoch = globalEpoch.load();
+      pRecord->epochCollected = epoch;
+      size_t iKeep = 0;
+      for (size_t i = 0; i < pRecord->retired.size(); i++)
+      {
+         Retired & retired = pRecord->retired[i];
+         if (retired.epoch + 2 <= epoch)
+            retired.destroy(retired.p);
+         else
+            pRecord->retired[iKeep++] = retired;
+      }
+      pRecord->retired.resize(iKeep);
+   }
+
+   std::atomic<uint64_t> globalEpoch;   // advances when all readers catch up
+   std::atomic<Record *> pHead;         // list of every thread record
+};
+
+/************************************************
+ * EPOCH GUARD
+ * Pins the calling thread for the lifetime of the
+ * guard so nothing it can see is destroyed
+ ***********************************************/
+class epoch_guard
+{
+public:
+   epoch_guard()                          { epoch_domain::instance().enter(); }
+   epoch_guard(const epoch_guard &)       { epoch_domain::instance().enter(); }
+   ~epoch_guard()                         { epoch_domain::instance().exit();  }
+   epoch_guard & operator = (const epoch_guard &) { return *this; }
+};
+
+}; // namespace custom
@@ -0,0 +1,253 @@
+/***********************************************************************
+ * Header:
+ *    Hash Index
+ * Summary:
+ *    An open-addressing hash table from a key to the node that holds
+ *    it, so a set that keeps its nodes in a tree for order can still
+ *    answer find() in O(1). The table only points at the nodes; it
+ *    never owns, copies, or moves them, so it is kept in step by
+ *    whoever links and unlinks them.
+ *
+ *    Slots are probed linearly. Beside each node pointer sits a one
+ *    byte tag from the hash, zero for an empty slot, so a probe
+ *    dereferences a node only when the tag matches. Erase shifts the
+ *    entries behind the hole back instead of leaving tombstones.
+ *
+ *    This will contain the class definition of:
+ *        hash_index          : Key to node pointer, open addressing
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>     // for uint8_t and uint64_t
+#include <vector>      // for std::vector
+#include <functional>  // for std::hash
+#include <type_traits> // for std::is_default_constructible
+
+namespace custom
+{
+
+/************************************************
+ * IS HASHABLE
+ * Whether Hash can hash a T: the standard library
+ * leaves std::hash<T> unconstructible when it can't
+ ***********************************************/
+template <typename T, class Hash = std::hash<T>>
+struct is_hashable : std::is_default_constructible<Hash> {};
+
+/************************************************
+ * HASH INDEX
+ * Node must have a data member holding the key
+ ***********************************************/
+template <typename T, class Node, class Hash = std::hash<T>>
+class hash_index
+{
+public:
+
+   //
+   // Construct
+   //
+   hash_index() : numElements(0)
+   {
+   }
+
+   //
+   // Access
+   //
+   Node * find(const T & t) const;
+
+   //
+   // Status
+   //
+   bool   empty()  const noexcept { return numElements == 0; }
+   size_t size()   const noexcept { return numElements; }
+   size_t memory() const noexcept
+   {
+      return sizeof(*this) + slots.capacity() * sizeof(Node *) + tags.capacity();
+   }
+
+   //
+   // Insert
+   //
+   // index a node whose key is not indexed yet
+   void insert(Node * pNode);
+   // room for num nodes without growing
+   void reserve(size_t num);
+
+   //
+   // Remove
+   //
+   bool erase(const T & t);
+   void clear() noexcept
+   {
+      slots.clear();
+      tags.clear();
+      numElements = 0;
+   }
+
+private:
+
+   static const size_t CAPACITY_MIN = 16;
+
+   // never more than three quarters full
+   static bool isFull(size_t num, size_t capacity)
+   {
+      return num * 4 > capacity * 3;
+   }
+
+   // mixed, so std::hash's identity on integers spreads over every bit
+   static uint64_t hashOf(const T & t)
+   {
+      uint64_t h = hashRaw(t, is_hashable<T, Hash>());
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+   }
+   // a container may name a hash_index of a T with no hash, as long
+   // as it never fills one
+   static uint64_t hashRaw(const T & t, std::true_type)
+   {
+      return (uint64_t)Hash()(t);
+   }
+   static uint64_t hashRaw(const T &, std::false_type)
+   {
+      assert(false);
+      return 0;
+   }
+   static uint8_t tagOf(uint64_t h)
+   {
+      return (uint8_t)(h >> 56) | 1;
+   }
+   size_t mask() const
+   {
+      return slots.size() - 1;
+   }
+
+   void rehash(size_t capacity);
+
+   std::vector<Node *>  slots;   // the nodes, a power of two of them
+   std::vector<uint8_t> tags;    // high bits of each slot's hash, 0 when empty
+   size_t numElements;           // number of nodes indexed
+};
+
+/*********************************************
+ * HASH INDEX :: FIND
+ * The node holding t, or nullptr
+ ********************************************/
+template <typename T, class Node, class Hash>
+Node * hash_index <T, Node, Hash> :: find(const T & t) const
+{
+   if (numElements == 0)
+      return nullptr;
+
+   uint64_t h = hashOf(t);
+   uint8_t tag = tagOf(h);
+   for (size_t i = (size_t)h & mask(); tags[i]; i = (i + 1) & mask())
+      if (tags[i] == tag && slots[i]->data == t)
+         return slots[i];
+   return nullptr;
+}
+
+/*********************************************
+ * HASH INDEX :: INSERT
+ * Into the first empty slot from the home one
+ ********************************************/
+template <typename T, class Node, class Hash>
+void hash_index <T, Node, Hash> :: insert(Node * pNode)
+{
+   assert(pNode && !find(pNode->data));
+   if (slots.empty() || isFull(numElements + 1, slots.size()))
+      rehash(slots.empty() ? CAPACITY_MIN : slots.size() * 2);
+
+   uint64_t h = hashOf(pNode->data);
+   size_t i = (size_t)h & mask();
+   while (tags[i])
+      i = (i + 1) & mask();
+   slots[i] = pNode;
+   tags[i] = tagOf(h);
+   numElements++;
+}
+
+/*********************************************
+ * HASH INDEX :: RESERVE
+ ********************************************/
+template <typename T, class Node, class Hash>
+void hash_index <T, Node, Hash> :: reserve(size_t num)
+{
+   size_t capacity = CAPACITY_MIN;
+   while (isFull(num, capacity))
+      capacity *= 2;
+   if (capacity > slots.size())
+      rehash(capacity);
+}
+
+/*********************************************
+ * HASH INDEX :: ERASE
+ * Empty t's slot, then walk the cluster after it
+ * moving back every entry whose home slot is not
+ * between the hole and where it sits
+ ********************************************/
+template <typename T, class Node, class Hash>
+bool hash_index <T, Node, Hash> :: erase(const T & t)
+{
+   if (numElements == 0)
+      return false;
+
+   uint64_t h = hashOf(t);
+   uint8_t tag = tagOf(h);
+   size_t iHole = (size_t)h & mask();
+   while (tags[iHole] && !(tags[iHole] == tag && slots[iHole]->data == t))
+      iHole = (iHole + 1) & mask();
+   if (!tags[iHole])
+      return false;
+
+   for (size_t i = (iHole + 1) & mask(); tags[i]; i = (i + 1) & mask())
+   {
+      size_t iHome = (size_t)hashOf(slots[i]->data) & mask();
+      if (((i - iHome) & mask()) >= ((i - iHole) & mask()))
+      {
+         slots[iHole] = slots[i];
+         tags[iHole] = tags[i];
+         iHole = i;
+      }
+   }
+   slots[iHole] = nullptr;
+   tags[iHole] = 0;
+   numElements--;
+   return true;
+}
+
+/*********************************************
+ * HASH INDEX :: REHASH
+ * Move every node into a table of capacity slots
+ ********************************************/
+template <typename T, class Node, class Hash>
+void hash_index <T, Node, Hash> :: rehash(size_t capacity)
+{
+   assert((capacity & (capacity - 1)) == 0 && !isFull(numElements, capacity));
+   std::vector<Node *> slotsOld;
+   std::vector<uint8_t> tagsOld;
+   slotsOld.swap(slots);
+   tagsOld.swap(tags);
+   slots.assign(capacity, nullptr);
+   tags.assign(capacity, 0);
+
+   for (size_t iOld = 0; iOld < slotsOld.size(); iOld++)
+   {
+      if (!tagsOld[iOld])
+         continue;
+      size_t i = (size_t)hashOf(slotsOld[iOld]->data) & mask();
+      while (tags[i])
+         i = (i + 1) & mask();
+      slots[i] = slotsOld[iOld];
+      tags[i] = tagsOld[iOld];
+   }
+}
+
+}; // namespace custom
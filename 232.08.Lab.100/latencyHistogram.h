@@ -0,0 +1,219 @@
+/***********************************************************************
+ * Header:
+ *    Latency Histogram
+ * Summary:
+ *    A record of how long each of many calls took, precise enough to
+ *    read the 99.9th percentile from, and small and fast enough to
+ *    keep one per operation of a container.
+ *
+ *    Like an HDR histogram, the buckets are log-linear: every value
+ *    below 128 has a bucket of its own, and each power of two above
+ *    that is split into 64 buckets, so any value is known to within
+ *    1/64 of itself. The buckets grow only as far as the largest
+ *    value recorded.
+ *
+ *    This will contain the class definitions of:
+ *        latency_histogram   : Counts of values, and their percentiles
+ *        latency_timer       : Records the nanoseconds of one scope
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <chrono>      // for std::chrono::steady_clock
+#include <cstdint>     // for uint64_t
+#include <vector>      // for std::vector
+
+class TestLatencyHistogram;   // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * LATENCY HISTOGRAM
+ * Counts of values, usually nanoseconds
+ ***********************************************/
+class latency_histogram
+{
+   friend class ::TestLatencyHistogram;
+public:
+
+   //
+   // Construct
+   //
+   latency_histogram() : numValues(0), sum(0), valueMin(0), valueMax(0)
+   {
+   }
+
+   //
+   // Insert
+   //
+   void record(uint64_t value, uint64_t count = 1)
+   {
+      if (count == 0)
+         return;
+      size_t index = indexOf(value);
+      if (index >= counts.size())
+         counts.resize(index + 1, 0);
+      counts[index] += count;
+      if (numValues == 0 || value < valueMin)
+         valueMin = value;
+      if (value > valueMax)
+         valueMax = value;
+      numValues += count;
+      sum += value * count;
+   }
+   latency_histogram & operator += (const latency_histogram & rhs);
+
+   //
+   // Access
+   //
+   uint64_t count() const noexcept { return numValues;          }
+   uint64_t total() const noexcept { return sum;                }
+   uint64_t min()   const noexcept { return valueMin;           }
+   uint64_t max()   const noexcept { return valueMax;           }
+   bool     empty() const noexcept { return numValues == 0;     }
+   double   mean()  const noexcept
+   {
+      return numValues ? (double)sum / (double)numValues : 0.0;
+   }
+   // the value that percent of the values are at or below
+   uint64_t percentile(double percent) const;
+
+   //
+   // Remove
+   //
+   void clear() noexcept
+   {
+      counts.clear();
+      numValues = sum = valueMin = valueMax = 0;
+   }
+
+private:
+
+   static const int    SUB_BITS = 7;
+   static const size_t SUB_COUNT = (size_t)1 << SUB_BITS;   // 128
+   static const size_t SUB_HALF = SUB_COUNT / 2;            // 64
+
+   // values below 128 are their own index; above, keep the top 7 bits
+   static size_t indexOf(uint64_t value)
+   {
+      if (value < SUB_COUNT)
+         return (size_t)value;
+      int shift = msb(value) - (SUB_BITS - 1);
+      return (size_t)shift * SUB_HALF + (size_t)(value >> shift);
+   }
+   // the smallest and largest values that land in a bucket
+   static uint64_t lowestOf(size_t index)
+   {
+      if (index < SUB_COUNT)
+         return index;
+      int shift = (int)(index / SUB_HALF) - 1;
+      return (uint64_t)(index % SUB_HALF + SUB_HALF) << shift;
+   }
+   static uint64_t highestOf(size_t index)
+   {
+      if (index < SUB_COUNT)
+         return index;
+      int shift = (int)(index / SUB_HALF) - 1;
+      return lowestOf(index) + (((uint64_t)1 << shift) - 1);
+   }
+   static int msb(uint64_t value)
+   {
+      int bit = 0;
+      while (value >>= 1)
+         bit++;
+      return bit;
+   }
+
+   std::vector<uint64_t> counts;   // how many values landed in each bucket
+   uint64_t numValues;             // how many values in all
+   uint64_t sum;                   // their total
+   uint64_t valueMin;              // the smallest, exactly
+   uint64_t valueMax;              // the largest, exactly
+};
+
+/************************************************
+ * LATENCY TIMER
+ * Adds the nanoseconds from construction to
+ * destruction to a histogram
+ ***********************************************/
+class latency_timer
+{
+public:
+   explicit latency_timer(latency_histogram & histogram) :
+      histogram(histogram), start(std::chrono::steady_clock::now())
+   {
+   }
+   ~latency_timer()
+   {
+      auto finish = std::chrono::steady_clock::now();
+      histogram.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>
+                       (finish - start).count());
+   }
+   latency_timer(const latency_timer &) = delete;
+   latency_timer & operator = (const latency_timer &) = delete;
+
+private:
+   latency_histogram & histogram;
+   std::chrono::steady_clock::time_point start;
+};
+
+/*********************************************
+ * LATENCY HISTOGRAM :: ADD
+ * Fold another histogram's values into this one
+ ********************************************/
+inline latency_histogram & latency_histogram :: operator += (const latency_histogram & rhs)
+{
+   if (rhs.empty())
+      return *this;
+   if (rhs.counts.size() > counts.size())
+      counts.resize(rhs.counts.size(), 0);
+   for (size_t i = 0; i < rhs.counts.size(); i++)
+      counts[i] += rhs.counts[i];
+   if (numValues == 0 || rhs.valueMin < valueMin)
+      valueMin = rhs.valueMin;
+   if (rhs.valueMax > valueMax)
+      valueMax = rhs.valueMax;
+   numValues += rhs.numValues;
+   sum += rhs.sum;
+   return *this;
+}
+
+/*********************************************
+ * LATENCY HISTOGRAM :: PERCENTILE
+ * The top of the bucket where the running count
+ * reaches percent of the values. The top of the
+ * last bucket is the exact maximum.
+ ********************************************/
+inline uint64_t latency_histogram :: percentile(double percent) const
+{
+   if (numValues == 0)
+      return 0;
+   if (percent <= 0.0)
+      return valueMin;
+
+   // at least one value, even for tiny percentages
+   uint64_t rank = (uint64_t)((percent / 100.0) * (double)numValues + 0.5);
+   if (rank < 1)
+      rank = 1;
+   if (rank > numValues)
+      rank = numValues;
+
+   uint64_t numSeen = 0;
+   for (size_t i = 0; i < counts.size(); i++)
+   {
+      numSeen += counts[i];
+      if (numSeen >= rank)
+      {
+         uint64_t value = highestOf(i);
+         return value < valueMax ? value : valueMax;
+      }
+   }
+   assert(false);
+   return valueMax;
+}
+
+}; // namespace custom
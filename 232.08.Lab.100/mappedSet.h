@@ -0,0 +1,347 @@
+/***********************************************************************
+ * Header:
+ *    Mapped Set
+ * Summary:
+ *    A read-only set whose elements live in a memory-mapped file. The
+ *    file is a small header followed by the keys, sorted, exactly as
+ *    they sit in memory, so opening it is a map and a header check:
+ *    nothing is parsed, copied, or allocated per element, and the
+ *    pages load lazily as lookups touch them.
+ *
+ *    Only trivially copyable elements can be stored this way, and the
+ *    file is only portable between machines with the same byte order
+ *    and the same layout of T.
+ *
+ *    This will contain the class definition of:
+ *        mapped_set          : A read-only set view of a mapped file
+ *        save_mapped         : Write a set where mmap_open can map it
+ *        mmap_open           : Map a file written by save_mapped()
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>     // for uint32_t and uint64_t
+#include <cstring>     // for memcmp and memcpy
+#include <fstream>     // for std::ofstream
+#include <string>      // for std::string
+#include <vector>      // for std::vector
+#include <algorithm>   // for std::lower_bound
+#include <type_traits> // for std::is_trivially_copyable
+#include "set.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>     // for open
+#include <unistd.h>    // for close
+#include <sys/mman.h>  // for mmap and munmap
+#include <sys/stat.h>  // for fstat
+#endif
+
+class TestMappedSet;   // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * MAPPED HEADER
+ * The first 32 bytes of the file. The keys start
+ * right after, which keeps them 16-byte aligned.
+ ***********************************************/
+struct mapped_header
+{
+   char     magic[8];      // "CSETMAP" and a null
+   uint32_t version;       // format version, currently 1
+   uint32_t keySize;       // sizeof(T) of the writer
+   uint64_t numElements;   // number of keys that follow
+   uint64_t reserved;      // zero
+};
+
+/************************************************
+ * MAPPED SET
+ * A sorted array of keys in a mapping. Lookups are
+ * binary searches; iterators are plain pointers.
+ ***********************************************/
+template <typename T>
+class mapped_set
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "mapped_set needs a trivially copyable T");
+   friend class ::TestMappedSet; // give unit tests access to the privates
+public:
+
+   typedef const T * iterator;
+
+   //
+   // Construct
+   //
+   mapped_set() : pMap(nullptr), numBytes(0), pKeys(nullptr), numElements(0)
+   {
+   }
+   mapped_set(const mapped_set & rhs) = delete;
+   mapped_set(mapped_set && rhs) : mapped_set()
+   {
+      swap(rhs);
+   }
+   ~mapped_set()
+   {
+      close();
+   }
+
+   //
+   // Assign
+   //
+   mapped_set & operator = (const mapped_set & rhs) = delete;
+   mapped_set & operator = (mapped_set && rhs)
+   {
+      close();
+      swap(rhs);
+      return *this;
+   }
+   void swap(mapped_set & rhs) noexcept
+   {
+      std::swap(pMap, rhs.pMap);
+      std::swap(numBytes, rhs.numBytes);
+      std::swap(pKeys, rhs.pKeys);
+      std::swap(numElements, rhs.numElements);
+   }
+
+   //
+   // Iterator
+   //
+   iterator begin() const { return pKeys; }
+   iterator end()   const { return pKeys + numElements; }
+
+   //
+   // Access
+   //
+   iterator lower_bound(const T & t) const
+   {
+      return std::lower_bound(begin(), end(), t);
+   }
+   iterator find(const T & t) const
+   {
+      iterator it = lower_bound(t);
+      return (it != end() && !(t < *it)) ? it : end();
+   }
+   bool contains(const T & t) const
+   {
+      return find(t) != end();
+   }
+
+   //
+   // Status
+   //
+   bool   is_open() const noexcept { return pMap != nullptr; }
+   bool   empty()   const noexcept { return numElements == 0; }
+   size_t size()    const noexcept { return numElements; }
+
+   //
+   // Remove
+   //
+   void close();
+
+   //
+   // File
+   //
+   bool open(const std::string & path);
+   template <class Iterator>
+   static bool write(const std::string & path, Iterator first, Iterator last, size_t num);
+
+private:
+
+   bool map(const std::string & path);
+
+   void *    pMap;          // the whole file, or nullptr when closed
+   size_t    numBytes;      // size of the mapping
+   const T * pKeys;         // the keys, just past the header
+   size_t    numElements;   // number of keys
+};
+
+/*********************************************
+ * SAVE MAPPED
+ * Write the elements of a set, in order, where
+ * mmap_open() can map them back in without
+ * parsing. Needs a trivially copyable T.
+ ********************************************/
+template <typename T, class Counters>
+bool save_mapped(const set <T, Counters> & s, const std::string & path)
+{
+   return mapped_set <T> ::write(path, s.begin(), s.end(), s.size());
+}
+
+/*********************************************
+ * MMAP OPEN
+ * A read-only view of a file written by
+ * save_mapped(). Check is_open() to see
+ * whether it worked.
+ ********************************************/
+template <typename T>
+mapped_set <T> mmap_open(const std::string & path)
+{
+   mapped_set <T> s;
+   s.open(path);
+   return s;
+}
+
+/*********************************************
+ * MAPPED SET :: OPEN
+ * Map the file and check that the header
+ * describes keys of our size that fit in it
+ ********************************************/
+template <typename T>
+bool mapped_set <T> :: open(const std::string & path)
+{
+   close();
+   if (!map(path))
+      return false;
+
+   mapped_header header;
+   bool isValid = numBytes >= sizeof(header);
+   if (isValid)
+   {
+      memcpy(&header, pMap, sizeof(header));
+      isValid = memcmp(header.magic, "CSETMAP", 8) == 0 &&
+                header.version == 1 &&
+                header.keySize == sizeof(T) &&
+                header.numElements <= (numBytes - sizeof(header)) / sizeof(T);
+   }
+   if (!isValid)
+   {
+      close();
+      return false;
+   }
+
+   pKeys = reinterpret_cast<const T *>(static_cast<const char *>(pMap) + sizeof(header));
+   numElements = (size_t)header.numElements;
+   return true;
+}
+
+/*********************************************
+ * MAPPED SET :: WRITE
+ * Write the header and then num sorted keys
+ ********************************************/
+template <typename T>
+template <class Iterator>
+bool mapped_set <T> :: write(const std::string & path, Iterator first, Iterator last, size_t num)
+{
+   std::ofstream fout(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+   if (!fout)
+      return false;
+
+   mapped_header header = {};
+   memcpy(header.magic, "CSETMAP", 8);
+   header.version = 1;
+   header.keySize = sizeof(T);
+   header.numElements = num;
+   fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+   // gather the keys a block at a time so each write is large
+   std::vector<T> block;
+   block.reserve(4096);
+   for (; first != last; ++first)
+   {
+      block.push_back(*first);
+      if (block.size() == block.capacity())
+      {
+         fout.write(reinterpret_cast<const char *>(block.data()), block.size() * sizeof(T));
+         block.clear();
+      }
+   }
+   fout.write(reinterpret_cast<const char *>(block.data()), block.size() * sizeof(T));
+   return (bool)fout.flush();
+}
+
+#ifdef _WIN32
+
+/*********************************************
+ * MAPPED SET :: MAP
+ * Windows: a read-only view of the whole file
+ ********************************************/
+template <typename T>
+bool mapped_set <T> :: map(const std::string & path)
+{
+   HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (hFile == INVALID_HANDLE_VALUE)
+      return false;
+
+   LARGE_INTEGER size;
+   HANDLE hMapping = NULL;
+   if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0)
+      hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+   if (hMapping)
+   {
+      pMap = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+      numBytes = pMap ? (size_t)size.QuadPart : 0;
+      CloseHandle(hMapping);   // the view keeps the mapping alive
+   }
+   CloseHandle(hFile);
+   return pMap != nullptr;
+}
+
+/*********************************************
+ * MAPPED SET :: CLOSE
+ ********************************************/
+template <typename T>
+void mapped_set <T> :: close()
+{
+   if (pMap)
+      UnmapViewOfFile(pMap);
+   pMap = nullptr;
+   numBytes = 0;
+   pKeys = nullptr;
+   numElements = 0;
+}
+
+#else // POSIX
+
+/*********************************************
+ * MAPPED SET :: MAP
+ * POSIX: a read-only, shared mapping of the
+ * whole file. The descriptor is not needed
+ * once the mapping exists.
+ ********************************************/
+template <typename T>
+bool mapped_set <T> :: map(const std::string & path)
+{
+   int fd = ::open(path.c_str(), O_RDONLY);
+   if (fd < 0)
+      return false;
+
+   struct stat status;
+   if (fstat(fd, &status) == 0 && status.st_size > 0)
+   {
+      void * p = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (p != MAP_FAILED)
+      {
+         pMap = p;
+         numBytes = (size_t)status.st_size;
+      }
+   }
+   ::close(fd);
+   return pMap != nullptr;
+}
+
+/*********************************************
+ * MAPPED SET :: CLOSE
+ ********************************************/
+template <typename T>
+void mapped_set <T> :: close()
+{
+   if (pMap)
+      munmap(pMap, numBytes);
+   pMap = nullptr;
+   numBytes = 0;
+   pKeys = nullptr;
+   numElements = 0;
+}
+
+#endif // _WIN32
+
+}; // namespace custom
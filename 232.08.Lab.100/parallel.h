@@ -0,0 +1,104 @@
+/***********************************************************************
+ * Header:
+ *    Parallel
+ * Summary:
+ *    The little bit of threading the containers need: run a number of
+ *    independent tasks on a handful of threads. Threads pull the next
+ *    task index from a shared counter, so a thread that finishes early
+ *    takes work that would otherwise wait behind a slow one.
+ *
+ *    This will contain the definition of:
+ *        parallel_threads    : How many threads to use by default
+ *        parallel_for        : Run tasks 0..n-1 across threads
+ *        parallel_sort       : Sort blocks in parallel, then merge them
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>     // for std::atomic
+#include <thread>     // for std::thread
+#include <vector>     // for std::vector
+#include <algorithm>  // for std::sort and std::inplace_merge
+
+namespace custom
+{
+
+/************************************************
+ * PARALLEL THREADS
+ * The requested thread count, or the hardware
+ * concurrency when the caller says zero
+ ***********************************************/
+inline size_t parallel_threads(size_t numThreads = 0)
+{
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   return numThreads == 0 ? 1 : numThreads;
+}
+
+/************************************************
+ * PARALLEL FOR
+ * Call task(i) for every i in [0, numTasks). The
+ * calling thread works too, so one thread means no
+ * threads are started at all.
+ ***********************************************/
+template <class Task>
+void parallel_for(size_t numTasks, size_t numThreads, Task task)
+{
+   numThreads = parallel_threads(numThreads);
+   if (numThreads > numTasks)
+      numThreads = numTasks;
+
+   std::atomic<size_t> iNext(0);
+   auto worker = [&]()
+   {
+      for (size_t i = iNext++; i < numTasks; i = iNext++)
+         task(i);
+   };
+
+   std::vector<std::thread> threads;
+   for (size_t t = 1; t < numThreads; t++)
+      threads.push_back(std::thread(worker));
+   worker();
+   for (auto & thread : threads)
+      thread.join();
+}
+
+/************************************************
+ * PARALLEL SORT
+ * Sort a power-of-two number of blocks, one per
+ * thread, then merge neighbors pairwise. Each round
+ * of merges runs in parallel and halves the blocks.
+ ***********************************************/
+template <class RandomIt>
+void parallel_sort(RandomIt first, RandomIt last, size_t numThreads = 0)
+{
+   numThreads = parallel_threads(numThreads);
+   size_t num = last - first;
+
+   // small inputs are not worth the threads
+   size_t numBlocks = 1;
+   while (numBlocks < numThreads && numBlocks * 4096 < num)
+      numBlocks *= 2;
+
+   std::vector<size_t> bounds(numBlocks + 1);
+   for (size_t i = 0; i <= numBlocks; i++)
+      bounds[i] = num * i / numBlocks;
+
+   parallel_for(numBlocks, numThreads, [&](size_t i)
+   {
+      std::sort(first + bounds[i], first + bounds[i + 1]);
+   });
+
+   for (size_t width = 1; width < numBlocks; width *= 2)
+      parallel_for(numBlocks / (2 * width), numThreads, [&](size_t i)
+      {
+         size_t iLow = 2 * width * i;
+         std::inplace_merge(first + bounds[iLow],
+                            first + bounds[iLow + width],
+                            first + bounds[iLow + 2 * width]);
+      });
+}
+
+}; // namespace custom
@@ -0,0 +1,215 @@
+/***********************************************************************
+ * Header:
+ *    PERF COUNTERS
+ * Summary:
+ *    Hardware event counts around a stretch of code: cycles,
+ *    instructions, L1 data and last level cache misses, branch
+ *    misses, and data TLB misses. Whether a change to the tree's
+ *    layout helped shows in misses per lookup long before it shows
+ *    in wall-clock time.
+ *
+ *    On Linux these come from perf_event_open(2), one counter per
+ *    event, user space only, following threads the benchmark starts.
+ *    An event the CPU, kernel, or perf_event_paranoid setting will
+ *    not give us is simply not valid; elsewhere none of them are.
+ *    When the kernel has to multiplex the counters, the counts are
+ *    scaled up by how long each was actually counting.
+ *
+ *    This will contain the class definition of:
+ *        PerfCounters        : Start, stop, and read the counters
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>    // for uint64_t
+#include <cstring>    // for memset
+
+#ifdef __linux__
+#include <linux/perf_event.h>   // for perf_event_attr
+#include <sys/ioctl.h>          // for ioctl
+#include <sys/syscall.h>        // for SYS_perf_event_open
+#include <unistd.h>             // for syscall, read, close
+#endif
+
+/************************************************
+ * PERF COUNTERS
+ * One counter for each hardware event
+ ***********************************************/
+class PerfCounters
+{
+public:
+
+   enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES,
+                DTLB_MISSES, NUM_EVENTS };
+
+   // the counts of one or more measurements
+   struct Reading
+   {
+      double counts[NUM_EVENTS];
+      bool   isValid[NUM_EVENTS];
+
+      Reading()
+      {
+         for (int i = 0; i < NUM_EVENTS; i++)
+         {
+            counts[i] = 0.0;
+            isValid[i] = false;
+         }
+      }
+
+      bool empty() const
+      {
+         for (int i = 0; i < NUM_EVENTS; i++)
+            if (isValid[i])
+               return false;
+         return true;
+      }
+
+      Reading & operator += (const Reading & rhs)
+      {
+         for (int i = 0; i < NUM_EVENTS; i++)
+         {
+            counts[i] += rhs.counts[i];
+            isValid[i] = isValid[i] || rhs.isValid[i];
+         }
+         return *this;
+      }
+   };
+
+   PerfCounters()
+   {
+      for (int i = 0; i < NUM_EVENTS; i++)
+         fds[i] = open((Event)i);
+   }
+   ~PerfCounters()
+   {
+#ifdef __linux__
+      for (int i = 0; i < NUM_EVENTS; i++)
+         if (fds[i] >= 0)
+            close(fds[i]);
+#endif
+   }
+   PerfCounters(const PerfCounters &) = delete;
+   PerfCounters & operator = (const PerfCounters &) = delete;
+
+   // whether any event can be counted at all
+   bool isAvailable() const
+   {
+      for (int i = 0; i < NUM_EVENTS; i++)
+         if (fds[i] >= 0)
+            return true;
+      return false;
+   }
+
+   // the short name of an event, used in reports
+   static const char * name(Event event)
+   {
+      const char * names[] = { "cycles", "instructions", "l1d_misses", "llc_misses",
+                                "branch_misses", "dtlb_misses" };
+      return names[event];
+   }
+
+   /*************************************************************
+    * START
+    * Zero the counters and let them run
+    *************************************************************/
+   void start()
+   {
+#ifdef __linux__
+      for (int i = 0; i < NUM_EVENTS; i++)
+         if (fds[i] >= 0)
+         {
+            ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+         }
+#endif
+   }
+
+   /*************************************************************
+    * STOP
+    * Hold the counters and read what they counted since start()
+    *************************************************************/
+   Reading stop()
+   {
+      Reading reading;
+#ifdef __linux__
+      for (int i = 0; i < NUM_EVENTS; i++)
+         if (fds[i] >= 0)
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      for (int i = 0; i < NUM_EVENTS; i++)
+      {
+         // value, time enabled, time running
+         uint64_t values[3] = {};
+         if (fds[i] < 0 || read(fds[i], values, sizeof(values)) != (ssize_t)sizeof(values))
+            continue;
+         if (values[2] == 0)
+            continue;   // never got onto the hardware
+         reading.counts[i] = (double)values[0] * ((double)values[1] / (double)values[2]);
+         reading.isValid[i] = true;
+      }
+#endif
+      return reading;
+   }
+
+private:
+
+   int fds[NUM_EVENTS];   // one per event, -1 when it cannot be counted
+
+   /*************************************************************
+    * OPEN
+    * A disabled counter for one event, or -1
+    *************************************************************/
+   static int open(Event event)
+   {
+#ifdef __linux__
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.disabled = 1;
+      attr.inherit = 1;          // threads started while counting
+      attr.exclude_kernel = 1;   // all that paranoid level 2 allows
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      const uint64_t readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      switch (event)
+      {
+         case CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+         case INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+         case L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | readMiss;
+            break;
+         case LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+         case BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+         case DTLB_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | readMiss;
+            break;
+         default:
+            return -1;
+      }
+      // this process, any CPU, no group
+      long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      return fd < 0 ? -1 : (int)fd;
+#else
+      (void)event;
+      return -1;
+#endif
+   }
+};
@@ -0,0 +1,424 @@
+/***********************************************************************
+ * Header:
+ *    Persistent Set
+ * Summary:
+ *    An immutable set. insert() and erase() leave the set alone and
+ *    return a new version that shares every untouched node with the
+ *    old one (path copying), so taking a snapshot is just a copy of
+ *    the root pointer and an update allocates only the nodes on the
+ *    path it changes.
+ *
+ *    The nodes cannot be BST::BNode: a BNode knows its parent, and a
+ *    shared node has one parent per version. Instead nodes are
+ *    reference counted and balanced as a treap, so the path an update
+ *    copies stays O(log n) no matter the insertion order.
+ *
+ *    This will contain the class definition of:
+ *        pset                : A persistent set
+ *        pset::iterator      : An iterator through one version
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <atomic>     // for std::atomic
+#include <vector>     // for std::vector
+#include <cstdint>    // for uint32_t
+#include <utility>    // for std::swap
+
+class TestPSet;       // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * PSET
+ * A persistent set. Every version stays valid and
+ * unchanged for as long as someone holds it.
+ ***********************************************/
+template <typename T>
+class pset
+{
+   friend class ::TestPSet; // give unit tests access to the privates
+public:
+
+   //
+   // Construct
+   //
+   pset() : root(nullptr), numElements(0)
+   {
+   }
+   pset(const pset & rhs) : root(rhs.root), numElements(rhs.numElements)
+   {
+      acquire(root);   // a snapshot is O(1)
+   }
+   pset(pset && rhs) : root(rhs.root), numElements(rhs.numElements)
+   {
+      rhs.root = nullptr;
+      rhs.numElements = 0;
+   }
+   pset(const std::initializer_list <T> & il) : root(nullptr), numElements(0)
+   {
+      for (const T & t : il)
+         *this = insert(t);
+   }
+   ~pset()
+   {
+      release(root);
+   }
+
+   //
+   // Assign
+   //
+   pset & operator = (const pset & rhs)
+   {
+      pset copy(rhs);
+      swap(copy);
+      return *this;
+   }
+   pset & operator = (pset && rhs)
+   {
+      pset moved(std::move(rhs));
+      swap(moved);
+      return *this;
+   }
+   void swap(pset & rhs) noexcept
+   {
+      std::swap(root, rhs.root);
+      std::swap(numElements, rhs.numElements);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end() const
+   {
+      return iterator();
+   }
+
+   //
+   // Access
+   //
+   iterator find(const T & t) const;
+
+   //
+   // Update, each returns a new version
+   //
+   pset insert(const T & t) const;
+   pset erase(const T & t) const;
+
+   //
+   // Status
+   //
+   bool   empty() const noexcept { return numElements == 0; }
+   size_t size()  const noexcept { return numElements;      }
+
+private:
+
+   class PNode;
+   pset(PNode * root, size_t numElements) : root(root), numElements(numElements) {}
+
+   static PNode * insert(PNode * p, const T & t);
+   static PNode * erase (PNode * p, const T & t);
+   static PNode * merge (PNode * pLess, PNode * pMore);
+   static void    acquire(PNode * p);
+   static void    release(PNode * p);
+   static uint32_t randomPriority();
+
+   PNode * root;              // root of this version, shared with others
+   size_t numElements;        // number of elements in this version
+};
+
+/*****************************************************************
+ * PSET NODE
+ * Immutable once published. The reference count is the
+ * number of parents plus versions pointing here.
+ *****************************************************************/
+template <typename T>
+class pset <T> :: PNode
+{
+public:
+   PNode(const T & t, uint32_t priority, PNode * pLeft = nullptr, PNode * pRight = nullptr) :
+      data(t), pLeft(pLeft), pRight(pRight), priority(priority), refs(1) {}
+
+   const T data;              // the element
+   PNode * pLeft;             // smaller elements
+   PNode * pRight;            // larger elements
+   const uint32_t priority;   // treap priority, a parent beats its children
+   std::atomic<size_t> refs;  // shared by this many parents and versions
+};
+
+/**************************************************
+ * PSET ITERATOR
+ * There are no parent pointers, so the iterator
+ * keeps the path of nodes still waiting to be
+ * visited. The top of the stack is the current node.
+ *************************************************/
+template <typename T>
+class pset <T> :: iterator
+{
+   friend class ::TestPSet; // give unit tests access to the privates
+   friend class custom::pset<T>;
+public:
+   iterator() {}
+
+   // equals, not equals operator
+   bool operator == (const iterator & rhs) const
+   {
+      return current() == rhs.current();
+   }
+   bool operator != (const iterator & rhs) const
+   {
+      return current() != rhs.current();
+   }
+
+   // dereference operator
+   const T & operator * () const
+   {
+      assert(!path.empty());
+      return path.back()->data;
+   }
+
+   // prefix increment
+   iterator & operator ++ ()
+   {
+      if (!path.empty())
+      {
+         PNode * p = path.back()->pRight;
+         path.pop_back();
+         pushLeft(p);
+      }
+      return *this;
+   }
+
+   // postfix increment
+   iterator operator ++ (int postfix)
+   {
+      iterator old(*this);
+      ++(*this);
+      return old;
+   }
+
+private:
+   PNode * current() const
+   {
+      return path.empty() ? nullptr : path.back();
+   }
+   void pushLeft(PNode * p)
+   {
+      for (; p; p = p->pLeft)
+         path.push_back(p);
+   }
+
+   std::vector<PNode *> path;   // ancestors we went left from, then the current node
+};
+
+/*********************************************
+ * PSET :: BEGIN
+ * The left-most node of this version
+ ********************************************/
+template <typename T>
+typename pset <T> :: iterator pset <T> :: begin() const
+{
+   iterator it;
+   it.pushLeft(root);
+   return it;
+}
+
+/*********************************************
+ * PSET :: FIND
+ * Record every node we go left from so the
+ * iterator can continue in order
+ ********************************************/
+template <typename T>
+typename pset <T> :: iterator pset <T> :: find(const T & t) const
+{
+   iterator it;
+   PNode * p = root;
+   while (p)
+   {
+      if (t < p->data)
+      {
+         it.path.push_back(p);
+         p = p->pLeft;
+      }
+      else if (p->data < t)
+         p = p->pRight;
+      else
+      {
+         it.path.push_back(p);
+         return it;
+      }
+   }
+   return end();
+}
+
+/*********************************************
+ * PSET :: INSERT
+ * A new version with t in it. If t is already
+ * here the new version is this one.
+ ********************************************/
+template <typename T>
+pset <T> pset <T> :: insert(const T & t) const
+{
+   if (find(t) != end())
+      return *this;
+   return pset(insert(root, t), numElements + 1);
+}
+
+/*********************************************
+ * PSET :: ERASE
+ * A new version without t in it
+ ********************************************/
+template <typename T>
+pset <T> pset <T> :: erase(const T & t) const
+{
+   if (find(t) == end())
+      return *this;
+   return pset(erase(root, t), numElements - 1);
+}
+
+/*********************************************
+ * PSET :: INSERT
+ * Copy the path down to where t belongs. The
+ * copies are still private to us, so a treap
+ * rotation can fix them up in place.
+ ********************************************/
+template <typename T>
+typename pset <T> :: PNode * pset <T> :: insert(PNode * p, const T & t)
+{
+   if (!p)
+      return new PNode(t, randomPriority());
+
+   if (t < p->data)
+   {
+      PNode * pLeft = insert(p->pLeft, t);
+      acquire(p->pRight);
+      PNode * pCopy = new PNode(p->data, p->priority, pLeft, p->pRight);
+      if (pLeft->priority <= pCopy->priority)
+         return pCopy;
+
+      // rotate right
+      pCopy->pLeft = pLeft->pRight;
+      pLeft->pRight = pCopy;
+      return pLeft;
+   }
+   else
+   {
+      PNode * pRight = insert(p->pRight, t);
+      acquire(p->pLeft);
+      PNode * pCopy = new PNode(p->data, p->priority, p->pLeft, pRight);
+      if (pRight->priority <= pCopy->priority)
+         return pCopy;
+
+      // rotate left
+      pCopy->pRight = pRight->pLeft;
+      pRight->pLeft = pCopy;
+      return pRight;
+   }
+}
+
+/*********************************************
+ * PSET :: ERASE
+ * Copy the path down to t, then replace t with
+ * the merge of its two children
+ ********************************************/
+template <typename T>
+typename pset <T> :: PNode * pset <T> :: erase(PNode * p, const T & t)
+{
+   assert(p);
+   if (t < p->data)
+   {
+      acquire(p->pRight);
+      return new PNode(p->data, p->priority, erase(p->pLeft, t), p->pRight);
+   }
+   if (p->data < t)
+   {
+      acquire(p->pLeft);
+      return new PNode(p->data, p->priority, p->pLeft, erase(p->pRight, t));
+   }
+   return merge(p->pLeft, p->pRight);
+}
+
+/*********************************************
+ * PSET :: MERGE
+ * Join two treaps where everything in pLess is
+ * smaller than everything in pMore, copying only
+ * the spine that changes
+ ********************************************/
+template <typename T>
+typename pset <T> :: PNode * pset <T> :: merge(PNode * pLess, PNode * pMore)
+{
+   if (!pLess || !pMore)
+   {
+      PNode * p = pLess ? pLess : pMore;
+      acquire(p);
+      return p;
+   }
+   if (pLess->priority > pMore->priority)
+   {
+      acquire(pLess->pLeft);
+      return new PNode(pLess->data, pLess->priority,
+                       pLess->pLeft, merge(pLess->pRight, pMore));
+   }
+   acquire(pMore->pRight);
+   return new PNode(pMore->data, pMore->priority,
+                    merge(pLess, pMore->pLeft), pMore->pRight);
+}
+
+/*********************************************
+ * PSET :: ACQUIRE
+ * One more parent or version shares this node
+ ********************************************/
+template <typename T>
+void pset <T> :: acquire(PNode * p)
+{
+   if (p)
+      p->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*********************************************
+ * PSET :: RELEASE
+ * Drop a reference. A node nobody shares goes away
+ * and drops its children in turn. Uses a stack, not
+ * recursion, so a long chain cannot blow the stack.
+ ********************************************/
+template <typename T>
+void pset <T> :: release(PNode * p)
+{
+   std::vector<PNode *> pending;
+   if (p)
+      pending.push_back(p);
+   while (!pending.empty())
+   {
+      p = pending.back();
+      pending.pop_back();
+      if (p->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+         continue;
+      if (p->pLeft)
+         pending.push_back(p->pLeft);
+      if (p->pRight)
+         pending.push_back(p->pRight);
+      delete p;
+   }
+}
+
+/*********************************************
+ * PSET :: RANDOM PRIORITY
+ * Per-thread xorshift, no locking needed
+ ********************************************/
+template <typename T>
+uint32_t pset <T> :: randomPriority()
+{
+   static thread_local uint32_t seed = 2463534242u;
+   seed ^= seed << 13;
+   seed ^= seed >> 17;
+   seed ^= seed << 5;
+   return seed;
+}
+
+}; // namespace custom
@@ -0,0 +1,175 @@
+/***********************************************************************
+ * Header:
+ *    Serialize
+ * Summary:
+ *    How set::serialize() and set::deserialize() put one element on a
+ *    stream and take it back off. The elements arrive in order, so a
+ *    serializer may remember the previous one: integers are written as
+ *    the varint gap from the last one, which for dense keys is a byte
+ *    each. Strings are a varint length and then the characters. Other
+ *    trivially copyable types are written as their bytes. Specialize
+ *    serializer<T> to store anything else.
+ *
+ *    This will contain the class definition of:
+ *        serializer<T>       : Write and read one element at a time
+ *        writeVarint         : Write an unsigned integer, 7 bits a byte
+ *        readVarint          : Read it back
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>     // for uint64_t
+#include <istream>     // for std::istream
+#include <ostream>     // for std::ostream
+#include <string>      // for std::string
+#include <type_traits> // for std::is_integral and std::make_unsigned
+
+namespace custom
+{
+
+/************************************************
+ * WRITE VARINT
+ * Low seven bits first, the high bit set on every
+ * byte but the last
+ ***********************************************/
+inline void writeVarint(std::ostream & out, uint64_t value)
+{
+   char buffer[10];
+   size_t num = 0;
+   while (value >= 0x80)
+   {
+      buffer[num++] = (char)((value & 0x7f) | 0x80);
+      value >>= 7;
+   }
+   buffer[num++] = (char)value;
+   out.write(buffer, num);
+}
+
+/************************************************
+ * READ VARINT
+ * False on a short or over-long encoding
+ ***********************************************/
+inline bool readVarint(std::istream & in, uint64_t & value)
+{
+   // straight from the buffer: istream::get() costs a sentry per byte
+   std::streambuf * pBuffer = in.rdbuf();
+   value = 0;
+   for (int shift = 0; shift < 64; shift += 7)
+   {
+      int c = pBuffer ? pBuffer->sbumpc() : std::istream::traits_type::eof();
+      if (c == std::istream::traits_type::eof())
+      {
+         in.setstate(std::ios::eofbit | std::ios::failbit);
+         return false;
+      }
+      value |= (uint64_t)(c & 0x7f) << shift;
+      if (!(c & 0x80))
+         return true;
+   }
+   return false;
+}
+
+/************************************************
+ * SERIALIZER
+ * Any trivially copyable type: its bytes as they
+ * are in memory
+ ***********************************************/
+template <typename T, typename Enable = void>
+class serializer
+{
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "specialize custom::serializer<T> to serialize this T");
+public:
+   void write(std::ostream & out, const T & t)
+   {
+      out.write(reinterpret_cast<const char *>(&t), sizeof(T));
+   }
+   bool read(std::istream & in, T & t)
+   {
+      return (bool)in.read(reinterpret_cast<char *>(&t), sizeof(T));
+   }
+};
+
+/************************************************
+ * SERIALIZER : INTEGERS
+ * The first value zigzag encoded so a negative one
+ * stays short, then each gap from the previous as
+ * an unsigned varint
+ ***********************************************/
+template <typename T>
+class serializer <T, typename std::enable_if<std::is_integral<T>::value &&
+                                             !std::is_same<T, bool>::value>::type>
+{
+   typedef typename std::make_unsigned<T>::type U;
+public:
+   serializer() : prev(0), isFirst(true) {}
+
+   void write(std::ostream & out, const T & t)
+   {
+      if (isFirst)
+      {
+         int64_t value = (int64_t)t;
+         writeVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+         isFirst = false;
+      }
+      else
+         writeVarint(out, (U)((U)t - (U)prev));
+      prev = t;
+   }
+   bool read(std::istream & in, T & t)
+   {
+      uint64_t value;
+      if (!readVarint(in, value))
+         return false;
+      if (isFirst)
+      {
+         t = (T)(int64_t)((value >> 1) ^ (~(value & 1) + 1));
+         isFirst = false;
+      }
+      else
+         t = (T)(U)((U)prev + (U)value);
+      prev = t;
+      return true;
+   }
+
+private:
+   T prev;          // the element before this one
+   bool isFirst;    // nothing written or read yet
+};
+
+/************************************************
+ * SERIALIZER : STRINGS
+ * The length as a varint, then the characters
+ ***********************************************/
+template <>
+class serializer <std::string>
+{
+public:
+   void write(std::ostream & out, const std::string & t)
+   {
+      writeVarint(out, t.size());
+      out.write(t.data(), t.size());
+   }
+   bool read(std::istream & in, std::string & t)
+   {
+      uint64_t size;
+      if (!readVarint(in, size))
+         return false;
+      // grow as the bytes arrive so a corrupt length cannot allocate gigabytes
+      t.clear();
+      while (size > 0)
+      {
+         size_t num = size < 65536 ? (size_t)size : 65536;
+         size_t numOld = t.size();
+         t.resize(numOld + num);
+         if (!in.read(&t[numOld], num))
+            return false;
+         size -= num;
+      }
+      return true;
+   }
+};
+
+}; // namespace custom
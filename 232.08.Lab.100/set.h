@@ -21,49 +21,95 @@
 #include <cassert>
 #include <iostream>
 #include "bst.h"
-#include <memory>     // for std::allocator
+#include "parallel.h"
+#include "serialize.h"
+#include "hashIndex.h"
+#include "latencyHistogram.h"
+#include "trace.h"
+#include <memory>     // for std::allocator, std::shared_ptr, and std::unique_ptr
 #include <functional> // for std::less
+#include <vector>     // for std::vector
+#include <algorithm>  // for std::unique and std::sort
 
 class TestSet;        // forward declaration for unit tests
 
+// with SET_LATENCY defined, a set times its own calls
+#ifdef SET_LATENCY
+#define SET_LATENCY_SCOPE(op) custom::latency_timer latencyTimer(latencies[op])
+#else
+#define SET_LATENCY_SCOPE(op)
+#endif
+
 namespace custom
 {
 
 /************************************************
  * SET
- * A class that represents a Set
+ * A class that represents a Set. Counters, by
+ * default no_counters, is the policy that counts
+ * its calls; see setCounters.h.
  ***********************************************/
-template <typename T>
+template <typename T, class Counters>
 class set
 {
    friend class ::TestSet; // give unit tests access to the privates
+   template <typename U, class C, class Predicate>
+   friend size_t erase_if(set<U, C> & s, Predicate pred);
 public:
    
    // 
    // Construct
    //
-   set() 
+   set() : copyOnWrite(false)
    { 
    }
-   set(const set &  rhs)
+   set(const set &  rhs) : copyOnWrite(rhs.copyOnWrite)
    {
-      bst = rhs.bst;
-   }
-   set(set && rhs) 
+      if (rhs.copyOnWrite)
+         share(rhs);
+      else
+         bst = rhs.bst;
+      if (rhs.pIndex)
+         buildIndex();
+   }
+   set(set && rhs) : copyOnWrite(rhs.copyOnWrite)
    {
       bst = std::move(rhs.bst);
+      pShared = std::move(rhs.pShared);
+      pIndex = std::move(rhs.pIndex);
    }
-   set(const std::initializer_list <T> & il) 
+   set(const std::initializer_list <T> & il) : copyOnWrite(false)
    {
-      bst = il;
+      assignUnique(il.begin(), il.end(), il.size());
    }
    template <class Iterator>
-   set(Iterator first, Iterator last) 
+   set(Iterator first, Iterator last) : copyOnWrite(false)
    {
       for (auto it = first; it != last; ++it)
-            bst.insert(*it, true); // insert unique elements
+            bst.counters().onInsert(bst.insert(*it, true).second); // insert unique elements
+   }
+   // bulk load: sort and dedup the range on numThreads threads
+   // (0 for one per core), then build a balanced tree bottom-up
+   template <class Iterator>
+   set(Iterator first, Iterator last, size_t numThreads) : copyOnWrite(false)
+   {
+      std::vector<T> values(first, last);
+      custom::parallel_sort(values.begin(), values.end(), numThreads);
+      size_t numOffered = values.size();
+      values.erase(std::unique(values.begin(), values.end()), values.end());
+      bst.assignBalanced(values.size(), numThreads, [&values](size_t i)
+      {
+         return new BNode(std::move(values[i]));
+      });
+      bst.counters().onAllocate(values.size());
+      bst.counters().onInsert(true,  values.size());
+      bst.counters().onInsert(false, numOffered - values.size());
+   }
+   ~set() 
+   { 
+      release();
+      bst.clear(); 
    }
-   ~set() { bst.clear(); }
 
    //
    // Assign
@@ -71,24 +117,151 @@ public:
 
    set & operator = (const set & rhs)
    {
-      bst = rhs.bst;
+      if (this == &rhs)
+         return *this;
+      SET_LATENCY_SCOPE(LATENCY_ASSIGN);
+      release();
+      copyOnWrite = rhs.copyOnWrite;   // modes follow the source, as in the copy constructor
+      if (rhs.copyOnWrite)
+      {
+         bst.clear();
+         share(rhs);
+      }
+      else
+         bst = rhs.bst;
+      if (rhs.pIndex)
+         buildIndex();
+      else
+         pIndex.reset();
       return *this;
    }
    set & operator = (set && rhs)
    {
+      release();
       bst = std::move(rhs.bst);
+      pShared = std::move(rhs.pShared);
+      pIndex = std::move(rhs.pIndex);
+      copyOnWrite = rhs.copyOnWrite;
       return *this;
    }
    set & operator = (const std::initializer_list <T> & il)
    {
-      bst = il;
+      release();
+      assignUnique(il.begin(), il.end(), il.size());
+      if (pIndex)
+         buildIndex();
+      publish();
       return *this;
    }
    void swap(set& rhs) noexcept
    {
       bst.swap(rhs.bst);
+      pShared.swap(rhs.pShared);
+      pIndex.swap(rhs.pIndex);
+      std::swap(copyOnWrite, rhs.copyOnWrite);
+   }
+
+   //
+   // Copy on write: copies of this set share its nodes
+   // until one of them is changed. A copy, made by the copy
+   // constructor or by assignment, takes this mode and the
+   // hash index mode from its source. The set that changes
+   // first is the one that clones, so a write to a shared
+   // set invalidates every iterator it handed out before:
+   // they point into the nodes the other copies still own.
+   // While the mode is on the nodes sit in a shared owner from
+   // the start, so a copy only reads its source and any number
+   // of threads may copy the same const set at once.
+   //
+   void copy_on_write(bool enable)
+   {
+      copyOnWrite = enable;
+      if (!enable && pShared && pShared.use_count() == 1)
+      {
+         pShared->root = nullptr;
+         pShared->numElements = 0;
+         pShared.reset();
+      }
+      publish();
+   }
+   bool copy_on_write() const noexcept
+   {
+      return copyOnWrite;
+   }
+
+   //
+   // Hash index: a table from each key to its node, kept in step
+   // with every insert and erase, makes find() and contains() O(1)
+   // instead of a descent. Order still comes from the tree. Costs
+   // about 12 to 24 bytes per element and a probe per insert.
+   // Needs std::hash<T> and operator ==.
+   //
+   void hash_indexed(bool enable)
+   {
+      static_assert(custom::is_hashable<T>::value, "hash_indexed needs a std::hash<T>");
+      if (!enable)
+         pIndex.reset();
+      else if (!pIndex)
+         buildIndex();
+   }
+   bool hash_indexed() const noexcept
+   {
+      return (bool)pIndex;
+   }
+
+   //
+   // Trace: log every insert, erase, find, contains, and clear of
+   // one key to the writer, until trace(nullptr). A batch logs one
+   // event per key it was given, and a range or erase_if one erase
+   // per element it removed, so a replay does the same work one key
+   // at a time. The writer is not owned, and copies of the set are
+   // not traced.
+   //
+   void trace(custom::trace_writer * pWriter) noexcept
+   {
+      pTrace = pWriter;
+   }
+   custom::trace_writer * trace() const noexcept
+   {
+      return pTrace;
+   }
+
+   //
+   // Counters: with set_counters as the policy, the finds, inserts,
+   // and erases made on this set and the comparisons, allocations,
+   // and recolorings its tree made for them. They belong to this
+   // set object: copies start from zero, and moves and swaps leave
+   // them where they are.
+   //
+   const Counters & counters() const noexcept
+   {
+      return bst.counters();
+   }
+   void counters_reset()
+   {
+      bst.Counters::reset();
    }
 
+#ifdef SET_LATENCY
+   //
+   // Latency: every insert, erase, find or contains, and copy-assign
+   // adds its nanoseconds to a histogram. A batch, range, or erase_if
+   // call is one sample however many keys it covers. Like the
+   // counters, the histograms are kept even by the const lookups. The histograms belong to this set
+   // object, so copies, moves, and swaps leave them where they are.
+   //
+   enum LatencyOp { LATENCY_INSERT, LATENCY_ERASE, LATENCY_FIND, LATENCY_ASSIGN, LATENCY_NUM };
+   const custom::latency_histogram & latency(LatencyOp op) const
+   {
+      return latencies[op];
+   }
+   void latency_clear()
+   {
+      for (auto & histogram : latencies)
+         histogram.clear();
+   }
+#endif
+
    //
    // Iterator
    //
@@ -108,7 +281,146 @@ public:
    //
    iterator find(const T& t) 
    { 
-      return iterator(bst.find(t));
+      SET_LATENCY_SCOPE(LATENCY_FIND);
+      if (pTrace)
+         pTrace->write(custom::TRACE_FIND, t);
+      iterator it = findNode(t);
+      bst.counters().onFind(it != end());
+      return it;
+   }
+   bool contains(const T& t) const
+   {
+      SET_LATENCY_SCOPE(LATENCY_FIND);
+      if (pTrace)
+         pTrace->write(custom::TRACE_CONTAINS, t);
+      bool isFound;
+      if (pIndex)
+         isFound = pIndex->find(t) != nullptr;
+      else
+      {
+         auto it = bst.lower_bound(t);
+         isFound = it != bst.end() && !bst.isLess(t, *it);
+      }
+      bst.counters().onFind(isFound);
+      return isFound;
+   }
+   iterator lower_bound(const T& t) const
+   {
+      return iterator(bst.lower_bound(t));
+   }
+   // find every key in [first, last), writing one iterator per key to
+   // out. The descents are interleaved so their cache misses overlap;
+   // this pays off once the set no longer fits in cache. With a hash
+   // index each key is one probe instead, as in find().
+   template <class KeyIterator, class OutIterator>
+   OutIterator find_batch(KeyIterator first, KeyIterator last, OutIterator out) const
+   {
+      SET_LATENCY_SCOPE(LATENCY_FIND);
+      if (pIndex)
+      {
+         for (; first != last; ++first)
+         {
+            if (pTrace)
+               pTrace->write(custom::TRACE_FIND, *first);
+            BNode * p = pIndex->find(*first);
+            bst.counters().onFind(p != nullptr);
+            *out++ = p ? iterator(typename custom::BST<T, Counters>::iterator(p)) : end();
+         }
+         return out;
+      }
+      if (pTrace)
+         for (KeyIterator it = first; it != last; ++it)
+            pTrace->write(custom::TRACE_FIND, *it);
+      typename custom::BST<T, Counters>::iterator itEnd = bst.end();
+      bst.findBatch(first, last, [this, &out, &itEnd](const typename custom::BST<T, Counters>::iterator & it)
+      {
+         bst.counters().onFind(it != itEnd);
+         *out++ = iterator(it);
+      });
+      return out;
+   }
+   // as find_batch, writing whether each key is here
+   template <class KeyIterator, class OutIterator>
+   OutIterator contains_batch(KeyIterator first, KeyIterator last, OutIterator out) const
+   {
+      SET_LATENCY_SCOPE(LATENCY_FIND);
+      if (pIndex)
+      {
+         for (; first != last; ++first)
+         {
+            if (pTrace)
+               pTrace->write(custom::TRACE_CONTAINS, *first);
+            bool isFound = pIndex->find(*first) != nullptr;
+            bst.counters().onFind(isFound);
+            *out++ = isFound;
+         }
+         return out;
+      }
+      if (pTrace)
+         for (KeyIterator it = first; it != last; ++it)
+            pTrace->write(custom::TRACE_CONTAINS, *it);
+      typename custom::BST<T, Counters>::iterator itEnd = bst.end();
+      bst.findBatch(first, last, [this, &out, &itEnd](const typename custom::BST<T, Counters>::iterator & it)
+      {
+         bst.counters().onFind(it != itEnd);
+         *out++ = (it != itEnd);
+      });
+      return out;
+   }
+
+   //
+   // Parallel
+   //
+   // split the set into in-order [first, last) ranges, one per
+   // subtree hanging below the top levels of the tree. The result
+   // is random access, so a C++17 caller can hand it straight to
+   // std::for_each(std::execution::par, ...)
+   std::vector<std::pair<iterator, iterator>> chunks(size_t numChunks) const
+   {
+      size_t depthLimit = 0;
+      while (((size_t)1 << depthLimit) < numChunks)
+         depthLimit++;
+
+      // the nodes above depthLimit, in order, are the chunk boundaries
+      std::vector<iterator> bounds;
+      bounds.push_back(begin());
+      std::vector<std::pair<BNode *, size_t>> stack;
+      BNode * p = bst.root;
+      size_t depth = 0;
+      while (true)
+      {
+         for (; p && depth < depthLimit; p = p->pLeft, depth++)
+            stack.push_back(std::make_pair(p, depth));
+         if (stack.empty())
+            break;
+         p = stack.back().first;
+         depth = stack.back().second;
+         stack.pop_back();
+         bounds.push_back(iterator(typename custom::BST<T, Counters>::iterator(p)));
+         p = p->pRight;
+         depth++;
+      }
+      bounds.push_back(end());
+
+      std::vector<std::pair<iterator, iterator>> ranges;
+      for (size_t i = 0; i + 1 < bounds.size(); i++)
+         if (bounds[i] != bounds[i + 1])
+            ranges.push_back(std::make_pair(bounds[i], bounds[i + 1]));
+      return ranges;
+   }
+   // call f on every element, chunks spread over numThreads
+   // threads (0 for one per core). f must be safe to call
+   // from several threads at once.
+   template <class Function>
+   void parallel_for_each(Function f, size_t numThreads = 0) const
+   {
+      numThreads = custom::parallel_threads(numThreads);
+      std::vector<std::pair<iterator, iterator>> ranges = chunks(numThreads * 4);
+      custom::parallel_for(ranges.size(), numThreads, [&](size_t i)
+      {
+         for (iterator it = ranges[i].first; it != ranges[i].second; ++it)
+            f(*it);
+      });
    }
 
    //
@@ -122,6 +434,57 @@ public:
    { 
       return bst.size();     
    }
+   // the shape of the tree and what its nodes cost; nodes shared
+   // with a copy-on-write copy are counted in each
+   custom::tree_stats stats() const
+   {
+      return bst.stats();
+   }
+
+   //
+   // File
+   //
+   // write the elements to a stream: a varint count, then each
+   // element in order through custom::serializer<T>
+   void serialize(std::ostream & out) const
+   {
+      custom::serializer<T> writer;
+      custom::writeVarint(out, size());
+      for (auto it = begin(); it != end(); ++it)
+         writer.write(out, *it);
+   }
+   // replace the elements with what serialize() wrote. They arrive
+   // sorted, so the tree is linked in O(n) instead of by n inserts.
+   // A short or out-of-order stream leaves the set empty and gives false.
+   bool deserialize(std::istream & in)
+   {
+      clear();
+      uint64_t num;
+      if (!custom::readVarint(in, num))
+         return false;
+
+      // do not trust the count with a huge reservation
+      std::vector<T> values;
+      values.reserve(num < 65536 ? (size_t)num : 65536);
+      custom::serializer<T> reader;
+      for (uint64_t i = 0; i < num; i++)
+      {
+         T t;
+         if (!reader.read(in, t) || (!values.empty() && !(values.back() < t)))
+            return false;
+         values.push_back(std::move(t));
+      }
+
+      bst.assignBalanced(values.size(), 1, [&values](size_t i)
+      {
+         return new BNode(std::move(values[i]));
+      });
+      bst.counters().onAllocate(values.size());
+      if (pIndex)
+         buildIndex();
+      publish();
+      return true;
+   }
 
    //
    // Insert
@@ -129,28 +492,143 @@ public:
    // copy insert
    std::pair<iterator, bool> insert(const T& t)
    {
+      SET_LATENCY_SCOPE(LATENCY_INSERT);
+      if (pTrace)
+         pTrace->write(custom::TRACE_INSERT, t);
+      BNode * pFound = pIndex ? pIndex->find(t) : nullptr;
+      if (pFound)
+      {
+         bst.counters().onInsert(false);
+         return std::make_pair(iterator(typename custom::BST<T, Counters>::iterator(pFound)), false);
+      }
+      detach();
       std::pair<iterator, bool> p = bst.insert(t, true);
+      bst.counters().onInsert(p.second);
+      indexInsert(p.first.it, p.second);
+      publish();
       return p;
    }
    // move insert
    std::pair<iterator, bool> insert(T&& t)
    {
+      SET_LATENCY_SCOPE(LATENCY_INSERT);
+      if (pTrace)
+         pTrace->write(custom::TRACE_INSERT, t);
+      BNode * pFound = pIndex ? pIndex->find(t) : nullptr;
+      if (pFound)
+      {
+         bst.counters().onInsert(false);
+         return std::make_pair(iterator(typename custom::BST<T, Counters>::iterator(pFound)), false);
+      }
+       detach();
        std::pair<iterator, bool> p = bst.insert(std::move(t), true);
+      bst.counters().onInsert(p.second);
+      indexInsert(p.first.it, p.second);
+      publish();
       return p;
    }
    // insert all the elements in a given initializer list
    void insert(const std::initializer_list <T>& il)
    {
-       for(T i : il)
-           insert(i);
+      for (const T & t : il)
+         insert(t);
    }
-   // insert a range of elements
+   // insert a range of elements, moving them from move iterators
    template <class Iterator>
    void insert(Iterator first, Iterator last)
    {
-       // use iterator to insert each element
-        for(iterator it = first; first != last; ++first)
-            insert(*first);
+      for (; first != last; ++first)
+         insert(*first);
+   }
+   // insert a batch in one pass: sort and dedup it, then merge it
+   // with the nodes already here and relink them all balanced. A
+   // batch under a quarter of the size, too small to pay for touching
+   // every node, is inserted one element at a time instead.
+   template <class Iterator>
+   void insert_batch(Iterator first, Iterator last)
+   {
+      SET_LATENCY_SCOPE(LATENCY_INSERT);
+      detach();
+      std::vector<T> values(first, last);
+      if (pTrace)
+         for (const T & value : values)
+            pTrace->write(custom::TRACE_INSERT, value);
+      std::sort(values.begin(), values.end());
+      size_t numOffered = values.size();
+      values.erase(std::unique(values.begin(), values.end()), values.end());
+      bst.counters().onInsert(false, numOffered - values.size());
+
+      // measured: relinking costs a few times less per node than
+      // a descent costs per insert
+      if (values.size() * 4 < bst.size())
+      {
+         for (auto & value : values)
+         {
+            auto p = bst.insert(std::move(value), true);
+            bst.counters().onInsert(p.second);
+            indexInsert(p.first, p.second);
+         }
+         publish();
+         return;
+      }
+
+      // walk the tree beside the batch to find what is new. The new
+      // nodes are owned here until the tree has linked them, so a
+      // throwing copy or allocation on the way does not leak them
+      std::vector<std::unique_ptr<BNode>> added;
+      added.reserve(values.size());
+      auto it = bst.begin();
+      for (auto & value : values)
+      {
+         while (it != bst.end() && bst.isLess(*it, value))
+            ++it;
+         if (it == bst.end() || bst.isLess(value, *it))
+            added.push_back(std::unique_ptr<BNode>(new BNode(std::move(value))));
+      }
+
+      // merge the new nodes in among the old, in order. Everything that
+      // allocates happens before the tree gives up its nodes
+      std::vector<BNode *> nodes;
+      nodes.reserve(bst.size() + added.size());
+      std::vector<bool> isOld;                       // which of the nodes were here
+      isOld.reserve(bst.size() + added.size());
+      if (pIndex)
+         pIndex->reserve(bst.size() + added.size());   // so indexing below cannot allocate
+      std::vector<BNode *> existing;
+      bst.flatten(existing);
+      auto itAdded = added.begin();
+      for (BNode * pExisting : existing)
+      {
+         for (; itAdded != added.end() && bst.isLess((*itAdded)->data, pExisting->data); ++itAdded)
+         {
+            nodes.push_back(itAdded->get());
+            isOld.push_back(false);
+         }
+         nodes.push_back(pExisting);
+         isOld.push_back(true);
+      }
+      for (; itAdded != added.end(); ++itAdded)
+      {
+         nodes.push_back(itAdded->get());
+         isOld.push_back(false);
+      }
+
+      bst.assignBalanced(nodes.size(), 1, [&nodes](size_t i) { return nodes[i]; },
+                         [&isOld](size_t i) { return isOld[i]; });
+      for (auto & pAdded : added)
+      {
+         BNode * p = pAdded.release();   // the tree owns it now
+         if (pIndex)
+            pIndex->insert(p);
+      }
+      bst.counters().onAllocate(added.size());
+      bst.counters().onInsert(true,  added.size());
+      bst.counters().onInsert(false, values.size() - added.size());
+      publish();
+   }
+   void insert_batch(const std::initializer_list <T> & il)
+   {
+      insert_batch(il.begin(), il.end());
    }
 
 
@@ -160,36 +638,246 @@ public:
    // remove every element using BST clear.
    void clear() noexcept 
    {
+       if (pTrace)
+          pTrace->write(custom::TRACE_CLEAR);
+       release();
        bst.clear();
+       if (pIndex)
+          pIndex->clear();
    }
    // erase a single element
    iterator erase(iterator &it)
    {
-      return iterator(bst.erase(it.it));
+      SET_LATENCY_SCOPE(LATENCY_ERASE);
+      if (pTrace && it != end())
+         pTrace->write(custom::TRACE_ERASE, *it);
+      return eraseAt(it);
    }
    // erase a given element
    size_t erase(const T & t) 
    {
-      iterator it = find(t);
+      SET_LATENCY_SCOPE(LATENCY_ERASE);
+      if (pTrace)
+         pTrace->write(custom::TRACE_ERASE, t);
+      iterator it = findNode(t);
       // check if it's in there
       if (it == end())
           return 0; // no elemenets removed
       // erase it
-      erase(it);
+      eraseAt(it);
       return 1;
    }
    // erase elements in a given range
    iterator erase(iterator &itBegin, iterator &itEnd)
    {
+       SET_LATENCY_SCOPE(LATENCY_ERASE);
+       detach(&itBegin.it, &itEnd.it);
        // go through each element and erase it
        while (itBegin != itEnd)
-           itBegin = erase(itBegin);
+       {
+           if (pTrace)
+              pTrace->write(custom::TRACE_ERASE, *itBegin);
+           itBegin = eraseAt(itBegin);
+       }
       return itEnd;
    }
+   // erase every element in [lo, hi) at once, returning how many
+   size_t erase_range(const T & lo, const T & hi)
+   {
+      SET_LATENCY_SCOPE(LATENCY_ERASE);
+      detach();
+      if (pIndex || pTrace)
+         for (auto it = bst.lower_bound(lo); it != bst.end() && *it < hi; ++it)
+         {
+            if (pTrace)
+               pTrace->write(custom::TRACE_ERASE, *it);
+            if (pIndex)
+               pIndex->erase(*it);
+         }
+      size_t numErased = bst.eraseRange(lo, hi);
+      bst.counters().onErase(numErased);
+      publish();
+      return numErased;
+   }
 
 private:
-   
-   custom::BST <T> bst;
+
+   typedef typename custom::BST<T, Counters>::BNode BNode;
+
+   /*************************************************
+    * SHARE
+    * Point at the nodes of a copy-on-write set. They
+    * are already in its shared owner, which frees
+    * them when the last copy lets go, so the source
+    * is only read.
+    *************************************************/
+   void share(const set & rhs)
+   {
+      assert(rhs.pShared || !rhs.bst.root);
+      pShared         = rhs.pShared;
+      bst.root        = rhs.bst.root;
+      bst.numElements = rhs.bst.numElements;
+   }
+
+   /*************************************************
+    * ASSIGN UNIQUE
+    * Replace the tree with the distinct elements of
+    * [first, last), numOffered of them, on the nodes
+    * that are here where there are enough
+    *************************************************/
+   template <class Iterator>
+   void assignUnique(Iterator first, Iterator last, size_t numOffered)
+   {
+      size_t numPlaced = bst.assignEach(first, last, true);
+      bst.counters().onInsert(true,  numPlaced);
+      bst.counters().onInsert(false, numOffered - numPlaced);
+   }
+
+   /*************************************************
+    * RELEASE
+    * Stop sharing without copying anything
+    *************************************************/
+   void release() noexcept
+   {
+      if (!pShared)
+         return;
+      bst.root = nullptr;
+      bst.numElements = 0;
+      pShared.reset();
+   }
+
+   /*************************************************
+    * DETACH
+    * About to change: get a private tree. If nobody
+    * else shares the nodes we just take them back, or
+    * keep writing through the owner in copy-on-write
+    * mode, otherwise clone them. Iterators into the
+    * shared nodes are moved to the matching cloned node.
+    *************************************************/
+   void detach(typename custom::BST<T, Counters>::iterator * pTrack1 = nullptr,
+               typename custom::BST<T, Counters>::iterator * pTrack2 = nullptr)
+   {
+      if (!pShared)
+         return;
+
+      if (pShared.use_count() == 1)
+      {
+         if (copyOnWrite)
+            return;
+         pShared->root = nullptr;
+         pShared->numElements = 0;
+      }
+      else
+      {
+         custom::BST<T, Counters> clone(*pShared);
+         relocate(pTrack1, clone.root);
+         relocate(pTrack2, clone.root);
+         bst.root = nullptr;
+         bst.numElements = 0;
+         bst.swap(clone);
+         bst.counters().onAllocate(clone.counters().allocations());
+         if (pIndex)
+            buildIndex();
+      }
+      pShared.reset();
+   }
+
+   /*************************************************
+    * PUBLISH
+    * Done changing: in copy-on-write mode, leave the
+    * nodes in an owner of our own so the next copy
+    * has nothing to write. An owner still shared with
+    * copies already holds exactly our nodes.
+    *************************************************/
+   void publish()
+   {
+      if (!pShared && copyOnWrite && bst.root)
+         pShared = std::make_shared<custom::BST<T, Counters>>();
+      if (pShared && pShared.use_count() == 1)
+      {
+         pShared->root        = bst.root;
+         pShared->numElements = bst.numElements;
+      }
+   }
+
+   /*************************************************
+    * FIND NODE and ERASE AT
+    * What find() and erase() do, for the calls that
+    * build on them without being timed twice
+    *************************************************/
+   iterator findNode(const T & t)
+   {
+      if (pIndex)
+      {
+         BNode * p = pIndex->find(t);
+         return p ? iterator(typename custom::BST<T, Counters>::iterator(p)) : end();
+      }
+      return iterator(bst.find(t));
+   }
+   iterator eraseAt(iterator & it)
+   {
+      detach(&it.it);
+      if (it == end())
+         return end();
+      if (pIndex)
+         pIndex->erase(*it.it);
+      bst.counters().onErase();
+      iterator itNext(bst.erase(it.it));
+      publish();
+      return itNext;
+   }
+
+   /*************************************************
+    * BUILD INDEX
+    * A fresh hash index over the nodes of this tree
+    *************************************************/
+   void buildIndex()
+   {
+      pIndex.reset(new custom::hash_index<T, BNode>());
+      pIndex->reserve(bst.size());
+      for (auto it = bst.begin(); it != bst.end(); ++it)
+         pIndex->insert(it.pNode);
+   }
+
+   /*************************************************
+    * INDEX INSERT
+    * Index the node an insert just linked, if any
+    *************************************************/
+   void indexInsert(const typename custom::BST<T, Counters>::iterator & it, bool isNew)
+   {
+      if (pIndex && isNew)
+         pIndex->insert(it.pNode);
+   }
+
+   /*************************************************
+    * RELOCATE
+    * Find the node in a clone that sits in the same
+    * place as the given node in the original
+    *************************************************/
+   static void relocate(typename custom::BST<T, Counters>::iterator * pTrack, BNode * pCloneRoot)
+   {
+      if (!pTrack || !pTrack->pNode)
+         return;
+
+      // record the turns from the root down to the node
+      std::vector<bool> wentLeft;
+      for (BNode * p = pTrack->pNode; p->pParent; p = p->pParent)
+         wentLeft.push_back(p->pParent->pLeft == p);
+
+      BNode * p = pCloneRoot;
+      for (auto it = wentLeft.rbegin(); it != wentLeft.rend(); ++it)
+         p = *it ? p->pLeft : p->pRight;
+      pTrack->pNode = p;
+   }
+
+   custom::BST<T, Counters> bst;
+   std::shared_ptr<custom::BST<T, Counters>> pShared;    // owner of the nodes in copy-on-write mode
+   bool copyOnWrite;                                // copies share instead of clone
+   std::unique_ptr<custom::hash_index<T, BNode>> pIndex; // key to node, when hash indexed
+   custom::trace_writer * pTrace = nullptr;              // where calls are logged, if anywhere
+#ifdef SET_LATENCY
+   mutable custom::latency_histogram latencies[LATENCY_NUM];   // nanoseconds of each kind of call
+#endif
 };
 
 
@@ -197,11 +885,11 @@ private:
  * SET ITERATOR
  * An iterator through Set
  *************************************************/
-template <typename T>
-class set <T> :: iterator
+template <typename T, class Counters>
+class set <T, Counters> :: iterator
 {
    friend class ::TestSet; // give unit tests access to the privates
-   friend class custom::set<T>;
+   friend class custom::set<T, Counters>;
 
 public:
    // constructors, destructors, and assignment operator
@@ -209,7 +897,7 @@ public:
    {
        it.pNode = nullptr;
    }
-   iterator(const typename custom::BST<T>::iterator& itRHS) 
+   iterator(const typename custom::BST<T, Counters>::iterator& itRHS) 
    {
        it = itRHS;
    }
@@ -279,10 +967,43 @@ public:
    
 private:
 
-   typename custom::BST<T>::iterator it;
+   typename custom::BST<T, Counters>::iterator it;
 };
 
 
+/***********************************************
+ * ERASE IF
+ * Remove every element matching pred, returning
+ * how many. One in-order pass decides; a large
+ * removal rebuilds the tree balanced instead of
+ * erasing node by node.
+ ***********************************************/
+template <typename T, class Counters, class Predicate>
+size_t erase_if(set<T, Counters> & s, Predicate pred)
+{
+#ifdef SET_LATENCY
+   custom::latency_timer latencyTimer(s.latencies[set<T, Counters>::LATENCY_ERASE]);
+#endif
+   s.detach();
+   size_t numErased;
+   if (!s.pIndex && !s.pTrace)
+      numErased = s.bst.eraseIf(pred);
+   else
+      numErased = s.bst.eraseIf([&s, &pred](const T & t)
+      {
+         bool isDoomed = pred(t);
+         if (isDoomed && s.pTrace)
+            s.pTrace->write(custom::TRACE_ERASE, t);
+         if (isDoomed && s.pIndex)
+            s.pIndex->erase(t);
+         return isDoomed;
+      });
+   s.bst.counters().onErase(numErased);
+   s.publish();
+   return numErased;
+}
+
+
 }; // namespace custom
 
 
@@ -0,0 +1,125 @@
+/***********************************************************************
+ * Header:
+ *    Set Counters
+ * Summary:
+ *    What a set is asked to do and what its tree does to answer, counted
+ *    for each set object whatever its key type. The counting is a policy:
+ *
+ *       custom::set<int>                         counts nothing
+ *       custom::set<int, custom::set_counters>   counts everything
+ *
+ *    no_counters has the same hooks and readers as set_counters, each
+ *    doing nothing or returning 0, so it compiles away, the tree gains
+ *    no bytes, and code that reads counters need not know which policy
+ *    a set has.
+ *
+ *    The counts are plain integers, not atomics: like set itself, one
+ *    set_counters belongs to one thread at a time.
+ *
+ *    This will contain the class definitions of:
+ *        no_counters         : Count nothing (the default)
+ *        set_counters        : Count every call and what it cost
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>    // for uint64_t
+#include <cstddef>    // for size_t
+
+namespace custom
+{
+
+/************************************************
+ * NO COUNTERS
+ * The policy that counts nothing
+ ***********************************************/
+struct no_counters
+{
+   static const bool isEnabled = false;
+
+   // the hooks the set and its tree call
+   void onFind(bool, size_t = 1) const {}
+   void onInsert(bool, size_t = 1) const {}
+   void onErase(size_t = 1) const {}
+   void onCompare(size_t = 1) const {}
+   void onAllocate(size_t = 1) const {}
+   void onRecolor(size_t = 1) const {}
+   void onRotate(size_t = 1) const {}
+
+   // what a reader sees
+   uint64_t finds()       const { return 0; }
+   uint64_t hits()        const { return 0; }
+   uint64_t misses()      const { return 0; }
+   uint64_t inserts()     const { return 0; }
+   uint64_t duplicates()  const { return 0; }
+   uint64_t erases()      const { return 0; }
+   uint64_t comparisons() const { return 0; }
+   uint64_t allocations() const { return 0; }
+   uint64_t recolorings() const { return 0; }
+   uint64_t rotations()   const { return 0; }
+   void reset() {}
+};
+
+/************************************************
+ * SET COUNTERS
+ * The policy that counts. The hooks are const and
+ * the counts mutable so a const lookup is counted.
+ ***********************************************/
+struct set_counters
+{
+   static const bool isEnabled = true;
+
+   set_counters() : numFinds(0), numHits(0), numInserts(0), numDuplicates(0),
+      numErases(0), numComparisons(0), numAllocations(0), numRecolorings(0),
+      numRotations(0)
+   {
+   }
+
+   // the hooks the set and its tree call
+   void onFind(bool isHit, size_t num = 1) const
+   {
+      numFinds += num;
+      numHits += isHit ? num : 0;
+   }
+   void onInsert(bool isNew, size_t num = 1) const
+   {
+      numInserts += num;
+      numDuplicates += isNew ? 0 : num;
+   }
+   void onErase(size_t num = 1)      const { numErases += num;      }
+   void onCompare(size_t num = 1)    const { numComparisons += num; }
+   void onAllocate(size_t num = 1)   const { numAllocations += num; }
+   void onRecolor(size_t num = 1)    const { numRecolorings += num; }
+   void onRotate(size_t num = 1)     const { numRotations += num;   }
+
+   // what a reader sees
+   uint64_t finds()       const { return numFinds;             }
+   uint64_t hits()        const { return numHits;              }
+   uint64_t misses()      const { return numFinds - numHits;   }
+   uint64_t inserts()     const { return numInserts;           }
+   uint64_t duplicates()  const { return numDuplicates;        }
+   uint64_t erases()      const { return numErases;            }
+   uint64_t comparisons() const { return numComparisons;       }
+   uint64_t allocations() const { return numAllocations;       }
+   uint64_t recolorings() const { return numRecolorings;       }
+   uint64_t rotations()   const { return numRotations;         }
+   void reset()
+   {
+      *this = set_counters();
+   }
+
+private:
+   mutable uint64_t numFinds;        // find, contains, and each key of a batch
+   mutable uint64_t numHits;         // of those, the ones that found the key
+   mutable uint64_t numInserts;      // elements offered to insert
+   mutable uint64_t numDuplicates;   // of those, the ones already here
+   mutable uint64_t numErases;       // elements erased, not counting clear()
+   mutable uint64_t numComparisons;  // operator < and == in the tree's descents
+   mutable uint64_t numAllocations;  // nodes allocated
+   mutable uint64_t numRecolorings;  // nodes whose color changed
+   mutable uint64_t numRotations;    // rotations to rebalance
+};
+
+}; // namespace custom
@@ -0,0 +1,328 @@
+/***********************************************************************
+ * Header:
+ *    Sharded Set
+ * Summary:
+ *    A set that spreads its elements over several independently locked
+ *    custom::set shards so many threads can insert at once.
+ *
+ *    Insert, erase and contains lock one shard. find() costs far more:
+ *    it locks every one of the N shards in turn and runs a lower_bound
+ *    on each so the iterator it returns can walk on in order. Once
+ *    those locks drop, that iterator (like one from begin()) is not
+ *    synchronized; a writer on any shard may invalidate it. Use
+ *    contains() when only the answer is needed.
+ *
+ *    This will contain the class definition of:
+ *        spinlock                  : A test-and-test-and-set lock
+ *        sharded_set               : A hash-partitioned concurrent set
+ *        sharded_set::iterator     : An ordered iterator merging the shards
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <atomic>     // for std::atomic
+#include <mutex>      // for std::mutex and std::lock_guard
+#include <thread>     // for std::this_thread::yield
+#include <functional> // for std::hash
+#include "set.h"
+
+class TestShardedSet; // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * SPINLOCK
+ * A minimal lock for very short critical sections.
+ * Spins on a plain load so waiting threads do not
+ * keep stealing the cache line from the owner.
+ ***********************************************/
+class spinlock
+{
+public:
+   spinlock() : locked(false) {}
+   spinlock(const spinlock &) = delete;
+   spinlock & operator = (const spinlock &) = delete;
+
+   void lock() noexcept
+   {
+      while (locked.exchange(true, std::memory_order_acquire))
+         while (locked.load(std::memory_order_relaxed))
+            std::this_thread::yield();
+   }
+   bool try_lock() noexcept
+   {
+      return !locked.load(std::memory_order_relaxed) &&
+             !locked.exchange(true, std::memory_order_acquire);
+   }
+   void unlock() noexcept
+   {
+      locked.store(false, std::memory_order_release);
+   }
+
+private:
+   std::atomic<bool> locked;
+};
+
+/************************************************
+ * SHARDED SET
+ * A set partitioned by hash over N custom::set
+ * shards, each guarded by its own lock. Insert, erase
+ * and contains only lock the one shard owning the key;
+ * find locks every shard in turn to place its iterator.
+ * Iteration merges the shards back into sorted order;
+ * it is not synchronized, so writers must be quiet
+ * while a thread walks the set.
+ ***********************************************/
+template <typename T, size_t N = 16, class Lock = std::mutex>
+class sharded_set
+{
+   friend class ::TestShardedSet; // give unit tests access to the privates
+   static_assert(N > 0, "a sharded_set needs at least one shard");
+public:
+
+   //
+   // Construct
+   //
+   sharded_set() : numElements(0)
+   {
+   }
+   sharded_set(const std::initializer_list <T> & il) : numElements(0)
+   {
+      for (const T & t : il)
+         insert(t);
+   }
+   sharded_set(const sharded_set &) = delete;
+   sharded_set & operator = (const sharded_set &) = delete;
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end() const
+   {
+      return iterator();
+   }
+
+   //
+   // Access
+   //
+   iterator find(const T & t);
+   bool contains(const T & t)
+   {
+      Shard & shard = shards[shardOf(t)];
+      std::lock_guard<Lock> guard(shard.lock);
+      return shard.data.find(t) != shard.data.end();
+   }
+
+   //
+   // Insert
+   //
+   bool insert(const T & t)
+   {
+      Shard & shard = shards[shardOf(t)];
+      std::lock_guard<Lock> guard(shard.lock);
+      bool inserted = shard.data.insert(t).second;
+      if (inserted)
+         numElements.fetch_add(1, std::memory_order_relaxed);
+      return inserted;
+   }
+   bool insert(T && t)
+   {
+      Shard & shard = shards[shardOf(t)];
+      std::lock_guard<Lock> guard(shard.lock);
+      bool inserted = shard.data.insert(std::move(t)).second;
+      if (inserted)
+         numElements.fetch_add(1, std::memory_order_relaxed);
+      return inserted;
+   }
+
+   //
+   // Remove
+   //
+   size_t erase(const T & t)
+   {
+      Shard & shard = shards[shardOf(t)];
+      std::lock_guard<Lock> guard(shard.lock);
+      size_t numErased = shard.data.erase(t);
+      numElements.fetch_sub(numErased, std::memory_order_relaxed);
+      return numErased;
+   }
+   void clear()
+   {
+      for (size_t i = 0; i < N; i++)
+      {
+         std::lock_guard<Lock> guard(shards[i].lock);
+         numElements.fetch_sub(shards[i].data.size(), std::memory_order_relaxed);
+         shards[i].data.clear();
+      }
+   }
+
+   //
+   // Status
+   //
+   bool   empty() const noexcept
+   {
+      return size() == 0;
+   }
+   size_t size() const noexcept
+   {
+      return numElements.load(std::memory_order_relaxed);
+   }
+   static constexpr size_t numShards() noexcept
+   {
+      return N;
+   }
+
+private:
+
+   // a full cache line of filler follows each shard so two writers
+   // working on neighboring shards do not false-share. This is padding
+   // rather than alignas: a sharded_set made with new is not promised
+   // an over-aligned address before C++17
+   static const size_t CACHE_LINE = 64;
+   struct Shard
+   {
+      Lock lock;
+      custom::set <T> data;
+      char filler[CACHE_LINE];
+   };
+
+   // std::hash is the identity for integers, so mix the bits
+   // before taking the modulus or sequential keys cluster
+   static size_t shardOf(const T & t)
+   {
+      size_t h = std::hash<T>()(t);
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return h % N;
+   }
+
+   Shard shards[N];                   // the partitions
+   std::atomic<size_t> numElements;   // total across all the shards
+};
+
+
+/**************************************************
+ * SHARDED SET ITERATOR
+ * An N-way merge over the shards. Each shard keeps
+ * its own cursor and the smallest head is current.
+ *************************************************/
+template <typename T, size_t N, class Lock>
+class sharded_set <T, N, Lock> :: iterator
+{
+   friend class ::TestShardedSet; // give unit tests access to the privates
+   friend class custom::sharded_set<T, N, Lock>;
+
+public:
+   // the default iterator is end()
+   iterator() : iCurrent(N)
+   {
+   }
+
+   // equals, not equals operator
+   bool operator == (const iterator & rhs) const
+   {
+      if (iCurrent == N || rhs.iCurrent == N)
+         return iCurrent == rhs.iCurrent;
+      return iCurrent == rhs.iCurrent && cur[iCurrent] == rhs.cur[iCurrent];
+   }
+   bool operator != (const iterator & rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   // dereference operator: read-only, changing it would break the order
+   const T & operator * () const
+   {
+      assert(iCurrent < N);
+      return *cur[iCurrent];
+   }
+
+   // prefix increment
+   iterator & operator ++ ()
+   {
+      if (iCurrent < N)
+      {
+         ++cur[iCurrent];
+         selectSmallest();
+      }
+      return *this;
+   }
+
+   // postfix increment
+   iterator operator ++ (int postfix)
+   {
+      iterator old(*this);
+      ++(*this);
+      return old;
+   }
+
+private:
+
+   // point iCurrent at the shard whose head is the smallest
+   void selectSmallest()
+   {
+      iCurrent = N;
+      for (size_t i = 0; i < N; i++)
+         if (cur[i] != last[i] && (iCurrent == N || *cur[i] < *cur[iCurrent]))
+            iCurrent = i;
+   }
+
+   typename custom::set<T>::iterator cur[N];    // head of each shard
+   typename custom::set<T>::iterator last[N];   // end of each shard
+   size_t iCurrent;                             // shard holding the current element, N at end
+};
+
+/**************************************************
+ * SHARDED SET :: BEGIN
+ * Start the merge at the front of every shard
+ *************************************************/
+template <typename T, size_t N, class Lock>
+typename sharded_set <T, N, Lock> :: iterator sharded_set <T, N, Lock> :: begin() const
+{
+   iterator it;
+   for (size_t i = 0; i < N; i++)
+   {
+      it.cur[i]  = shards[i].data.begin();
+      it.last[i] = shards[i].data.end();
+   }
+   it.selectSmallest();
+   return it;
+}
+
+/**************************************************
+ * SHARDED SET :: FIND
+ * Look the key up in its own shard, then position
+ * every other shard at its first larger element so
+ * iteration can continue in order from here
+ *************************************************/
+template <typename T, size_t N, class Lock>
+typename sharded_set <T, N, Lock> :: iterator sharded_set <T, N, Lock> :: find(const T & t)
+{
+   size_t iShard = shardOf(t);
+   typename custom::set<T>::iterator itFound;
+   {
+      std::lock_guard<Lock> guard(shards[iShard].lock);
+      itFound = shards[iShard].data.find(t);
+      if (itFound == shards[iShard].data.end())
+         return end();
+   }
+
+   iterator it;
+   for (size_t i = 0; i < N; i++)
+   {
+      std::lock_guard<Lock> guard(shards[i].lock);
+      it.cur[i]  = (i == iShard) ? itFound : shards[i].data.lower_bound(t);
+      it.last[i] = shards[i].data.end();
+   }
+   it.iCurrent = iShard;
+   return it;
+}
+
+}; // namespace custom
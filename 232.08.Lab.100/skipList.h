@@ -0,0 +1,520 @@
+/***********************************************************************
+ * Header:
+ *    Concurrent Skip List Set
+ * Summary:
+ *    A lock-free ordered set. Every level of the skip list is a
+ *    linked list whose next pointers carry a "deleted" mark in their
+ *    low bit (Harris, Herlihy & Shavit). Removal first marks a node,
+ *    then any thread that walks past unlinks it with a CAS. Unlinked
+ *    nodes are handed to the epoch_domain for safe reclamation.
+ *
+ *    This will contain the class definition of:
+ *        concurrent_skiplist_set           : A lock-free set
+ *        concurrent_skiplist_set::iterator : An iterator through the set
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <atomic>     // for std::atomic
+#include <cstddef>    // for size_t
+#include <cstdint>    // for uintptr_t
+#include <new>        // for placement new
+#include <utility>    // for std::forward
+#include "epoch.h"
+
+class TestSkipList;   // forward declaration for unit tests
+
+namespace custom
+{
+
+/************************************************
+ * CONCURRENT SKIPLIST SET
+ * Insert, erase and find may be called from any
+ * number of threads without a lock
+ ***********************************************/
+template <typename T>
+class concurrent_skiplist_set
+{
+   friend class ::TestSkipList; // give unit tests access to the privates
+public:
+
+   //
+   // Construct
+   //
+   concurrent_skiplist_set() : numElements(0)
+   {
+      for (int level = 0; level < MAX_LEVEL; level++)
+         head[level].store(0);
+   }
+   concurrent_skiplist_set(const std::initializer_list <T> & il) : concurrent_skiplist_set()
+   {
+      for (const T & t : il)
+         insert(t);
+   }
+   concurrent_skiplist_set(const concurrent_skiplist_set &) = delete;
+   concurrent_skiplist_set & operator = (const concurrent_skiplist_set &) = delete;
+   ~concurrent_skiplist_set();
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end() const
+   {
+      return iterator();
+   }
+
+   //
+   // Access
+   //
+   iterator find(const T & t) const;
+   bool contains(const T & t) const
+   {
+      epoch_guard guard;
+      return search(t) != nullptr;
+   }
+
+   //
+   // Insert
+   //
+   std::pair<iterator, bool> insert(const T &  t) { return emplace(t);            }
+   std::pair<iterator, bool> insert(      T && t) { return emplace(std::move(t)); }
+
+   //
+   // Remove
+   //
+   size_t erase(const T & t);
+   void clear();
+
+   //
+   // Status
+   //
+   bool   empty() const noexcept { return size() == 0;          }
+   size_t size()  const noexcept { return numElements.load();   }
+
+private:
+
+   static const int MAX_LEVEL = 24;   // plenty for 2^24 elements and then some
+   typedef std::atomic<uintptr_t> Link;
+
+   // a next pointer with the deleted mark in its low bit
+   struct Node;
+   static Node *   pointer(uintptr_t link) { return (Node *)(link & ~(uintptr_t)1); }
+   static bool     isMarked(uintptr_t link) { return (link & 1) != 0;             }
+   static uintptr_t mark(uintptr_t link)    { return link | 1;                    }
+
+   template <class U>
+   std::pair<iterator, bool> emplace(U && t);
+   bool   find(const T & t, Link ** preds, Node ** succs, bool pastEqual = false);
+   Node * search(const T & t) const;
+   Node * first() const;
+   bool   remove(Node * pVictim);
+   void   release(Node * pNode);
+   static int  randomLevel();
+   static void destroy(void * p);
+
+   Link head[MAX_LEVEL];              // next pointers of the head sentinel
+   std::atomic<size_t> numElements;   // number of unmarked elements
+};
+
+/*****************************************************************
+ * SKIPLIST NODE
+ * A node and its tower of next pointers share one allocation.
+ * The tower lives directly after the node.
+ *****************************************************************/
+template <typename T>
+struct concurrent_skiplist_set <T> :: Node
+{
+   template <class U>
+   Node(U && t, int h) : data(std::forward<U>(t)), height(h),
+      refs(2), next(reinterpret_cast<Link *>(this + 1))
+   {
+      for (int level = 0; level < h; level++)
+         new (next + level) Link(0);
+   }
+
+   // allocate the node and its tower together
+   template <class U>
+   static Node * create(U && t, int height)
+   {
+      void * p = ::operator new(sizeof(Node) + height * sizeof(Link));
+      return new (p) Node(std::forward<U>(t), height);
+   }
+
+   T data;                  // the element
+   int height;              // number of levels this node is linked in
+   std::atomic<int> refs;   // inserter still linking + element present
+   Link * next;             // tower of next pointers, height long
+};
+
+/**************************************************
+ * SKIPLIST ITERATOR
+ * Walks level 0, skipping marked nodes. The iterator
+ * pins the epoch so the node it sits on stays alive,
+ * so it must not be handed to another thread.
+ *************************************************/
+template <typename T>
+class concurrent_skiplist_set <T> :: iterator
+{
+   friend class ::TestSkipList; // give unit tests access to the privates
+   friend class custom::concurrent_skiplist_set<T>;
+public:
+   iterator(Node * pNode = nullptr) : pNode(pNode) {}
+
+   // equals, not equals operator
+   bool operator == (const iterator & rhs) const { return pNode == rhs.pNode; }
+   bool operator != (const iterator & rhs) const { return pNode != rhs.pNode; }
+
+   // dereference operator: read-only, changing it would break the order
+   const T & operator * () const
+   {
+      assert(pNode);
+      return pNode->data;
+   }
+
+   // prefix increment
+   iterator & operator ++ ()
+   {
+      if (pNode)
+      {
+         pNode = pointer(pNode->next[0].load());
+         while (pNode && isMarked(pNode->next[0].load()))
+            pNode = pointer(pNode->next[0].load());
+      }
+      return *this;
+   }
+
+   // postfix increment
+   iterator operator ++ (int postfix)
+   {
+      iterator old(*this);
+      ++(*this);
+      return old;
+   }
+
+private:
+   epoch_guard guard;   // keeps pNode from being reclaimed
+   Node * pNode;
+};
+
+/*********************************************
+ * SKIPLIST :: DESTRUCTOR
+ * No other thread may be using the set now
+ ********************************************/
+template <typename T>
+concurrent_skiplist_set <T> :: ~concurrent_skiplist_set()
+{
+   Node * p = pointer(head[0].load());
+   while (p)
+   {
+      Node * pNext = pointer(p->next[0].load());
+      destroy(p);
+      p = pNext;
+   }
+}
+
+/*********************************************
+ * SKIPLIST :: BEGIN
+ * The first unmarked node on the bottom level
+ ********************************************/
+template <typename T>
+typename concurrent_skiplist_set <T> :: iterator concurrent_skiplist_set <T> :: begin() const
+{
+   iterator it;   // pin before looking so the node cannot go away
+   it.pNode = first();
+   return it;
+}
+
+/*********************************************
+ * SKIPLIST :: FIRST
+ * The first unmarked node; the caller holds a guard
+ ********************************************/
+template <typename T>
+typename concurrent_skiplist_set <T> :: Node * concurrent_skiplist_set <T> :: first() const
+{
+   Node * p = pointer(head[0].load());
+   while (p && isMarked(p->next[0].load()))
+      p = pointer(p->next[0].load());
+   return p;
+}
+
+/*********************************************
+ * SKIPLIST :: FIND
+ * Return an iterator to the element, or end()
+ ********************************************/
+template <typename T>
+typename concurrent_skiplist_set <T> :: iterator concurrent_skiplist_set <T> :: find(const T & t) const
+{
+   iterator it;   // pin before searching so the node cannot go away
+   it.pNode = search(t);
+   return it;
+}
+
+/*********************************************
+ * SKIPLIST :: SEARCH
+ * Wait-free lookup: step over marked nodes
+ * without helping to unlink them
+ ********************************************/
+template <typename T>
+typename concurrent_skiplist_set <T> :: Node * concurrent_skiplist_set <T> :: search(const T & t) const
+{
+   const Link * pred = head;
+   Node * curr = nullptr;
+   for (int level = MAX_LEVEL - 1; level >= 0; level--)
+   {
+      curr = pointer(pred[level].load());
+      while (curr)
+      {
+         uintptr_t succ = curr->next[level].load();
+         if (isMarked(succ))
+            curr = pointer(succ);          // deleted, look past it
+         else if (curr->data < t)
+         {
+            pred = curr->next;
+            curr = pointer(succ);
+         }
+         else
+            break;
+      }
+   }
+   if (curr && !(t < curr->data) && !isMarked(curr->next[0].load()))
+      return curr;
+   return nullptr;
+}
+
+/*********************************************
+ * SKIPLIST :: FIND PREDECESSORS
+ * Fill preds/succs with the nodes on either side
+ * of t at every level, unlinking any marked node
+ * along the way. With pastEqual the walk also goes
+ * past nodes equal to t so a marked t gets unlinked
+ * even when a newer copy sits in front of it.
+ * Returns true if an unmarked t is at succs[0].
+ ********************************************/
+template <typename T>
+bool concurrent_skiplist_set <T> :: find(const T & t, Link ** preds, Node ** succs, bool pastEqual)
+{
+retry:
+   Link * pred = head;
+   for (int level = MAX_LEVEL - 1; level >= 0; level--)
+   {
+      Node * curr = pointer(pred[level].load());
+      while (curr)
+      {
+         uintptr_t succ = curr->next[level].load();
+         while (isMarked(succ))
+         {
+            // curr is deleted: swing pred past it or start over
+            uintptr_t expected = (uintptr_t)curr;
+            if (!pred[level].compare_exchange_strong(expected, (uintptr_t)pointer(succ)))
+               goto retry;
+            curr = pointer(succ);
+            if (!curr)
+               break;
+            succ = curr->next[level].load();
+         }
+         if (!curr)
+            break;
+
+         if (curr->data < t || (pastEqual && !(t < curr->data)))
+         {
+            pred = curr->next;
+            curr = pointer(succ);
+         }
+         else
+            break;
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+   }
+   return succs[0] && !(t < succs[0]->data);
+}
+
+/*********************************************
+ * SKIPLIST :: EMPLACE
+ * Link a new node in at level 0 (the linearization
+ * point) and then into the rest of its tower
+ ********************************************/
+template <typename T>
+template <class U>
+std::pair<typename concurrent_skiplist_set <T> :: iterator, bool>
+concurrent_skiplist_set <T> :: emplace(U && t)
+{
+   Link * preds[MAX_LEVEL];
+   Node * succs[MAX_LEVEL];
+   iterator it;
+   Node * pNew = nullptr;
+
+   // level 0
+   while (true)
+   {
+      // once t has been moved into the node, search with the node's copy
+      if (find(pNew ? pNew->data : t, preds, succs))
+      {
+         if (pNew)
+            destroy(pNew);   // never published
+         it.pNode = succs[0];
+         return std::pair<iterator, bool>(it, false);
+      }
+      if (!pNew)
+         pNew = Node::create(std::forward<U>(t), randomLevel());
+      for (int level = 0; level < pNew->height; level++)
+         pNew->next[level].store((uintptr_t)succs[level]);
+
+      uintptr_t expected = (uintptr_t)succs[0];
+      if (preds[0][0].compare_exchange_strong(expected, (uintptr_t)pNew))
+         break;
+   }
+   numElements.fetch_add(1);
+   it.pNode = pNew;
+
+   // the rest of the tower, giving up if someone erases us meanwhile
+   for (int level = 1; level < pNew->height; level++)
+   {
+      while (true)
+      {
+         uintptr_t link = pNew->next[level].load();
+         if (isMarked(link))
+            goto linked;
+         if (pointer(link) != succs[level] &&
+             !pNew->next[level].compare_exchange_strong(link, (uintptr_t)succs[level]))
+            continue;
+
+         uintptr_t expected = (uintptr_t)succs[level];
+         if (preds[level][level].compare_exchange_strong(expected, (uintptr_t)pNew))
+            break;
+
+         find(pNew->data, preds, succs);
+         if (succs[0] != pNew)
+            goto linked;
+      }
+   }
+linked:
+   // an eraser may have finished while we were still linking
+   if (isMarked(pNew->next[0].load()))
+      find(pNew->data, preds, succs, true /*pastEqual*/);
+   release(pNew);
+   return std::pair<iterator, bool>(it, true);
+}
+
+/*********************************************
+ * SKIPLIST :: ERASE
+ * Mark the tower from the top down. Whoever marks
+ * level 0 owns the removal and unlinks the node.
+ ********************************************/
+template <typename T>
+size_t concurrent_skiplist_set <T> :: erase(const T & t)
+{
+   Link * preds[MAX_LEVEL];
+   Node * succs[MAX_LEVEL];
+   epoch_guard guard;
+
+   if (!find(t, preds, succs))
+      return 0;
+   return remove(succs[0]) ? 1 : 0;
+}
+
+/*********************************************
+ * SKIPLIST :: CLEAR
+ * Erase the first element until there is none.
+ * Each one is erased under its own guard, never
+ * one held across them all, so the epoch keeps
+ * advancing and the nodes are reclaimed as the
+ * list empties.
+ ********************************************/
+template <typename T>
+void concurrent_skiplist_set <T> :: clear()
+{
+   while (true)
+   {
+      epoch_guard guard;
+      Node * pFirst = first();
+      if (!pFirst)
+         return;
+      remove(pFirst);
+   }
+}
+
+/*********************************************
+ * SKIPLIST :: REMOVE
+ * Mark the tower of a node found under the
+ * caller's guard, unlink it, and give it up.
+ * False if another thread erased it first.
+ ********************************************/
+template <typename T>
+bool concurrent_skiplist_set <T> :: remove(Node * pVictim)
+{
+   for (int level = pVictim->height - 1; level > 0; level--)
+   {
+      uintptr_t link = pVictim->next[level].load();
+      while (!isMarked(link))
+         pVictim->next[level].compare_exchange_weak(link, mark(link));
+   }
+
+   uintptr_t link = pVictim->next[0].load();
+   while (true)
+   {
+      if (isMarked(link))
+         return false;   // another thread erased it first
+      if (pVictim->next[0].compare_exchange_strong(link, mark(link)))
+         break;
+   }
+   numElements.fetch_sub(1);
+
+   Link * preds[MAX_LEVEL];
+   Node * succs[MAX_LEVEL];
+   find(pVictim->data, preds, succs, true /*pastEqual*/);
+   release(pVictim);
+   return true;
+}
+
+/*********************************************
+ * SKIPLIST :: RELEASE
+ * The inserter and the eraser each drop one
+ * reference once they are done unlinking. The
+ * last one out retires the node.
+ ********************************************/
+template <typename T>
+void concurrent_skiplist_set <T> :: release(Node * pNode)
+{
+   if (pNode->refs.fetch_sub(1) == 1)
+      epoch_domain::instance().retire(pNode, &destroy);
+}
+
+/*********************************************
+ * SKIPLIST :: DESTROY
+ * Free a node and its tower
+ ********************************************/
+template <typename T>
+void concurrent_skiplist_set <T> :: destroy(void * p)
+{
+   Node * pNode = static_cast<Node *>(p);
+   for (int level = 0; level < pNode->height; level++)
+      pNode->next[level].~Link();
+   pNode->~Node();
+   ::operator delete(p);
+}
+
+/*********************************************
+ * SKIPLIST :: RANDOM LEVEL
+ * Geometric with p = 1/2, per-thread xorshift so
+ * threads do not contend on a shared generator
+ ********************************************/
+template <typename T>
+int concurrent_skiplist_set <T> :: randomLevel()
+{
+   static thread_local uint64_t seed = 0x9E3779B97F4A7C15ULL ^ (uintptr_t)&seed;
+   seed ^= seed << 13;
+   seed ^= seed >> 7;
+   seed ^= seed << 17;
+   int level = 1;
+   for (uint64_t bits = seed; (bits & 1) && level < MAX_LEVEL; bits >>= 1)
+      level++;
+   return level;
+}
+
+}; // namespace custom
@@ -5,11 +5,23 @@
  *    Br. Helfrich
  * Summary:
  *    A mock class designed to measure its usage: a spy!
+ *
+ *    Each thread counts into its own block of 64-bit counters, so Spy
+ *    keys can be used by parallel and concurrent sets without racing
+ *    and by long benchmarks without overflowing. A read adds up every
+ *    block; a block outlives its thread so nothing counted is lost.
+ *    Spy::Snapshot counts from the moment it is made, which lets one
+ *    measurement run beside another without a reset() between them.
  ************************************************************************/
 
 #pragma once
 
 #include <cassert>
+#include <atomic>     // for std::atomic
+#include <cstdint>    // for uint64_t
+#include <memory>     // for std::unique_ptr
+#include <mutex>      // for std::mutex and std::lock_guard
+#include <vector>     // for std::vector
 
 enum { ALLOC,      // allocations, number of times NEW is called
        DELETE,     // deletions, number of times DELETE is called
@@ -35,14 +47,14 @@ public:
    int * p;
    
    // default constructor: allocate a spot and assign to zero
-   Spy() : p(nullptr) { counters[DEFAULT]++; }
+   Spy() : p(nullptr) { mark(DEFAULT); }
    
    // non-default constructor: allocate a spot and assign to the value
    Spy(int value) : p(nullptr)
    {
       allocate();
       *p = value;
-      counters[NONDEFAULT]++;
+      mark(NONDEFAULT);
    }
    
    // copy constructor: make a new copy
@@ -53,7 +65,7 @@ public:
          allocate();
          *p = rhs.get();
       }
-      counters[COPY]++;
+      mark(COPY);
    }
    
    // move constructor: steal the data from the RHS
@@ -66,7 +78,7 @@ public:
       }
       else
          p = nullptr;
-      counters[COPY_MOVE]++;
+      mark(COPY_MOVE);
    }
    
    // delete - remove the instance
@@ -74,7 +86,7 @@ public:
    {
       if (!empty())
          unallocate();
-      counters[DESTRUCTOR]++;
+      mark(DESTRUCTOR);
    }
 
    // copy assignment operator
@@ -88,7 +100,7 @@ public:
       }
       else if (!empty())
          unallocate();
-      counters[ASSIGN]++;
+      mark(ASSIGN);
       return *this;
    }
    
@@ -99,7 +111,7 @@ public:
          unallocate();
       p = rhs.p;
       rhs.p = nullptr;
-      counters[ASSIGN_MOVE]++;
+      mark(ASSIGN_MOVE);
       return *this;
    }
    
@@ -126,7 +138,7 @@ public:
    // compare the values
    bool operator==(const Spy & rhs) const
    {
-      counters[EQUALS]++;
+      mark(EQUALS);
       if (rhs.empty() && empty())
          return true;
       if (!rhs.empty() && !empty())
@@ -137,7 +149,7 @@ public:
    // a null value is assumed to be the smallest value
    bool operator<(const Spy & rhs) const
    {
-      counters[LESSTHAN]++;
+      mark(LESSTHAN);
       if (rhs.empty() && empty())
          return false;
       if (!rhs.empty() && !empty())
@@ -148,35 +160,119 @@ public:
          return false;
    }
    
-   // reset the counters for a new test
+   // reset the counters for a new test. Every thread's counters
+   // are zeroed, so no other thread may be using a Spy meanwhile.
    static void reset()
+   {
+      Registry & registry = getRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for (auto & pBlock : registry.blocks)
+         for (int i = 0; i < NUM_MARKERS; i++)
+            pBlock->counts[i].store(0, std::memory_order_relaxed);
+   }
+
+   // one marker added up over every thread
+   static uint64_t count(int marker)
+   {
+      uint64_t totals[NUM_MARKERS];
+      countAll(totals);
+      return totals[marker];
+   }
+   // every marker at once, from one pass over the threads
+   static void countAll(uint64_t totals[NUM_MARKERS])
    {
       for (int i = 0; i < NUM_MARKERS; i++)
-         counters[i] = 0;
-   }
-   
-   static int numAlloc()       { return counters[ALLOC];      }
-   static int numDelete()      { return counters[DELETE];     }
-   static int numDefault()     { return counters[DEFAULT];    }
-   static int numNondefault()  { return counters[NONDEFAULT]; }
-   static int numCopy()        { return counters[COPY];       }
-   static int numCopyMove()    { return counters[COPY_MOVE];  }
-   static int numDestructor()  { return counters[DESTRUCTOR]; }
-   static int numAssign()      { return counters[ASSIGN];     }
-   static int numAssignMove()  { return counters[ASSIGN_MOVE];}
-   static int numEquals()      { return counters[EQUALS];     }
-   static int numLessthan()    { return counters[LESSTHAN];   }
-   
-   // keep track of how it is used
-   static int counters[NUM_MARKERS];
+         totals[i] = 0;
+      Registry & registry = getRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for (auto & pBlock : registry.blocks)
+         for (int i = 0; i < NUM_MARKERS; i++)
+            totals[i] += pBlock->counts[i].load(std::memory_order_relaxed);
+   }
+   
+   static uint64_t numAlloc()       { return count(ALLOC);      }
+   static uint64_t numDelete()      { return count(DELETE);     }
+   static uint64_t numDefault()     { return count(DEFAULT);    }
+   static uint64_t numNondefault()  { return count(NONDEFAULT); }
+   static uint64_t numCopy()        { return count(COPY);       }
+   static uint64_t numCopyMove()    { return count(COPY_MOVE);  }
+   static uint64_t numDestructor()  { return count(DESTRUCTOR); }
+   static uint64_t numAssign()      { return count(ASSIGN);     }
+   static uint64_t numAssignMove()  { return count(ASSIGN_MOVE);}
+   static uint64_t numEquals()      { return count(EQUALS);     }
+   static uint64_t numLessthan()    { return count(LESSTHAN);   }
+
+   class Snapshot;
+
 private:
+
+   // one thread's counters. Only that thread writes them, so a
+   // relaxed load and store count without a locked instruction;
+   // they are atomic only so another thread may read them.
+   struct Block
+   {
+      Block() : isInUse(true)
+      {
+         for (int i = 0; i < NUM_MARKERS; i++)
+            counts[i].store(0, std::memory_order_relaxed);
+      }
+      std::atomic<uint64_t> counts[NUM_MARKERS];
+      bool isInUse;                              // a live thread owns it
+   };
+
+   // every block ever handed out; a thread that ends gives its
+   // block back, counts and all, for the next thread to take
+   struct Registry
+   {
+      std::mutex mutex;
+      std::vector<std::unique_ptr<Block>> blocks;
+   };
+   static Registry & getRegistry()
+   {
+      static Registry registry;
+      return registry;
+   }
+
+   // a thread's claim on a block, from its first count to its end
+   struct Owner
+   {
+      Owner() : pBlock(nullptr)
+      {
+         Registry & registry = getRegistry();
+         std::lock_guard<std::mutex> lock(registry.mutex);
+         for (auto & p : registry.blocks)
+            if (!p->isInUse)
+            {
+               pBlock = p.get();
+               pBlock->isInUse = true;
+               return;
+            }
+         registry.blocks.push_back(std::unique_ptr<Block>(new Block));
+         pBlock = registry.blocks.back().get();
+      }
+      ~Owner()
+      {
+         Registry & registry = getRegistry();
+         std::lock_guard<std::mutex> lock(registry.mutex);
+         pBlock->isInUse = false;
+      }
+      Block * pBlock;
+   };
+
+   // count one use on this thread
+   static void mark(int marker)
+   {
+      thread_local Owner owner;
+      std::atomic<uint64_t> & counter = owner.pBlock->counts[marker];
+      counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   }
    
    // allocate a new buffer
    void allocate()
    {
       assert(p == nullptr);
       p = new int;
-      counters[ALLOC]++;
+      mark(ALLOC);
    }
    
    // free the buffer
@@ -185,7 +281,45 @@ private:
       assert(p != nullptr);
       delete p;
       p = nullptr;
-      counters[DELETE]++;
+      mark(DELETE);
    }
    
 };
+
+/*************************************************************
+ * SPY SNAPSHOT
+ * The uses of Spy, on every thread, since it was made or
+ * last restarted. Snapshots do not disturb each other or
+ * the totals, so they can nest and overlap.
+ *************************************************************/
+class Spy::Snapshot
+{
+public:
+   Snapshot()
+   {
+      restart();
+   }
+   void restart()
+   {
+      Spy::countAll(start);
+   }
+
+   // one marker since the start
+   uint64_t count(int marker) const
+   {
+      return Spy::count(marker) - start[marker];
+   }
+   // every use of any kind since the start
+   uint64_t total() const
+   {
+      uint64_t now[NUM_MARKERS];
+      Spy::countAll(now);
+      uint64_t sum = 0;
+      for (int i = 0; i < NUM_MARKERS; i++)
+         sum += now[i] - start[i];
+      return sum;
+   }
+
+private:
+   uint64_t start[NUM_MARKERS];   // the totals when it started
+};
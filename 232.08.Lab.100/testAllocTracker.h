@@ -0,0 +1,222 @@
+/***********************************************************************
+ * Header:
+ *    TEST ALLOC TRACKER
+ * Summary:
+ *    Unit tests for alloc_tracker and alloc_scope
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "allocTracker.h"
+#include "unitTest.h"
+
+#include <memory>      // for std::unique_ptr
+#include <thread>      // for std::thread
+
+/***********************************************
+ * TEST ALLOC TRACKER
+ * Unit tests for counting operator new
+ ***********************************************/
+class TestAllocTracker : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Tracker
+      test_tracker_hooked();
+      test_tracker_sizeClass();
+
+      // Scope
+      test_scope_empty();
+      test_scope_newDelete();
+      test_scope_histogram();
+      test_scope_peak();
+      test_scope_nested();
+      test_scope_threads();
+      test_add_merge();
+
+      report("AllocTracker");
+   }
+
+   /***************************************
+    * TRACKER
+    ***************************************/
+
+   // the test driver includes allocHooks.h, so every new comes here
+   void test_tracker_hooked()
+   {  // setup
+      // exercise
+      std::unique_ptr<int> p(new int(1));
+      // verify
+      assertUnit(custom::alloc_tracker::isHooked());
+      assertUnit(custom::alloc_tracker::totals().numAllocs > 0);
+   }  // teardown
+
+   // a size falls in the smallest power of two that holds it
+   void test_tracker_sizeClass()
+   {  // setup
+      // exercise
+      // verify
+      assertUnit(custom::alloc_stats::sizeClass(0) == 0);
+      assertUnit(custom::alloc_stats::sizeClass(1) == 0);
+      assertUnit(custom::alloc_stats::sizeClass(2) == 1);
+      assertUnit(custom::alloc_stats::sizeClass(3) == 2);
+      assertUnit(custom::alloc_stats::sizeClass(32) == 5);
+      assertUnit(custom::alloc_stats::sizeClass(33) == 6);
+      assertUnit(custom::alloc_stats::sizeClassMax(6) == 64);
+      assertUnit(custom::alloc_stats::sizeClass((size_t)-1) == custom::ALLOC_SIZE_CLASSES - 1);
+   }  // teardown
+
+   /***************************************
+    * SCOPE
+    ***************************************/
+
+   // nothing allocated, nothing counted
+   void test_scope_empty()
+   {  // setup
+      custom::alloc_scope scope;
+      // exercise
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.empty());
+      assertUnit(stats.bytesAllocated == 0);
+      assertUnit(stats.bytesPeak == 0);
+      assertUnit(stats.bytesLive() == 0);
+   }  // teardown
+
+   // one new and one delete, of the size asked for
+   void test_scope_newDelete()
+   {  // setup
+      custom::alloc_scope scope;
+      // exercise
+      int * p = new int[10];
+      custom::alloc_stats statsNew = scope.stats();
+      delete [] p;
+      custom::alloc_stats statsDelete = scope.stats();
+      // verify
+      assertUnit(statsNew.numAllocs == 1);
+      assertUnit(statsNew.numFrees == 0);
+      assertUnit(statsNew.bytesAllocated == 10 * sizeof(int));
+      assertUnit(statsNew.bytesLive() == 10 * sizeof(int));
+      assertUnit(statsDelete.numAllocs == 1);
+      assertUnit(statsDelete.numFrees == 1);
+      assertUnit(statsDelete.bytesFreed == 10 * sizeof(int));
+      assertUnit(statsDelete.bytesLive() == 0);
+   }  // teardown
+
+   // each allocation lands in its size class
+   void test_scope_histogram()
+   {  // setup
+      custom::alloc_scope scope;
+      // exercise
+      delete [] new char[8];
+      delete [] new char[9];
+      delete [] new char[16];
+      delete [] new char[1000];
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.numAllocs == 4);
+      assertUnit(stats.sizeCounts[3] == 1);    // 8
+      assertUnit(stats.sizeCounts[4] == 2);    // 9 and 16
+      assertUnit(stats.sizeCounts[10] == 1);   // 1000
+      uint64_t numCounted = 0;
+      for (size_t i = 0; i < custom::ALLOC_SIZE_CLASSES; i++)
+         numCounted += stats.sizeCounts[i];
+      assertUnit(numCounted == 4);
+   }  // teardown
+
+   // the peak is the most live at once, not the most allocated
+   void test_scope_peak()
+   {  // setup
+      custom::alloc_scope scope;
+      // exercise
+      char * pBig = new char[1000];
+      char * pSmall = new char[100];
+      delete [] pBig;
+      delete [] pSmall;
+      pSmall = new char[100];
+      delete [] pSmall;
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.bytesAllocated == 1200);
+      assertUnit(stats.bytesPeak == 1100);
+      assertUnit(stats.bytesLive() == 0);
+   }  // teardown
+
+   // an outer scope sees what an inner one saw, and more
+   void test_scope_nested()
+   {  // setup
+      custom::alloc_scope scopeOuter;
+      std::unique_ptr<int> pOuter(new int(1));
+      custom::alloc_stats statsInner;
+      // exercise
+      {
+         custom::alloc_scope scopeInner;
+         std::unique_ptr<int> pInner(new int(2));
+         statsInner = scopeInner.stats();
+      }
+      custom::alloc_stats statsOuter = scopeOuter.stats();
+      // verify
+      assertUnit(statsInner.numAllocs == 1);
+      assertUnit(statsInner.numFrees == 0);
+      assertUnit(statsOuter.numAllocs == 2);
+      assertUnit(statsOuter.numFrees == 1);
+      assertUnit(statsOuter.bytesLive() == sizeof(int));
+   }  // teardown
+
+   // allocations on another thread count too
+   void test_scope_threads()
+   {  // setup
+      std::unique_ptr<std::thread> pThread(new std::thread([]() {}));
+      pThread->join();
+      custom::alloc_scope scope;
+      const int num = 1000;
+      // exercise
+      std::thread worker([]()
+      {
+         for (int i = 0; i < num; i++)
+            delete new int(i);
+      });
+      worker.join();
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.numAllocs >= (uint64_t)num);
+      assertUnit(stats.numFrees >= (uint64_t)num);
+      assertUnit(stats.sizeCounts[custom::alloc_stats::sizeClass(sizeof(int))] >= (uint64_t)num);
+   }  // teardown
+
+   // adding stretches adds the counts and keeps the higher peak
+   void test_add_merge()
+   {  // setup
+      custom::alloc_stats lhs = {};
+      custom::alloc_stats rhs = {};
+      lhs.numAllocs = 2;
+      lhs.bytesAllocated = 64;
+      lhs.bytesPeak = 64;
+      lhs.sizeCounts[5] = 2;
+      rhs.numAllocs = 1;
+      rhs.numFrees = 3;
+      rhs.bytesAllocated = 100;
+      rhs.bytesFreed = 164;
+      rhs.bytesPeak = 100;
+      rhs.sizeCounts[7] = 1;
+      // exercise
+      lhs += rhs;
+      // verify
+      assertUnit(lhs.numAllocs == 3);
+      assertUnit(lhs.numFrees == 3);
+      assertUnit(lhs.bytesAllocated == 164);
+      assertUnit(lhs.bytesLive() == 0);
+      assertUnit(lhs.bytesPeak == 100);
+      assertUnit(lhs.sizeCounts[5] == 2);
+      assertUnit(lhs.sizeCounts[7] == 1);
+   }  // teardown
+};
+
+#endif // DEBUG
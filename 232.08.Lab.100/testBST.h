@@ -107,6 +107,18 @@ public:
       test_size_empty();
       test_size_standard();
 
+      // Stats
+      test_stats_empty();
+      test_stats_standard();
+      test_stats_chain();
+      test_assign_chain();
+      test_stats_balancedBuild();
+      test_stats_redRed();
+      test_stats_blackHeight();
+      test_stats_outOfOrder();
+      test_stats_badParent();
+      test_stats_rootHasParent();
+
       report("BST");
    }
    
@@ -519,6 +531,226 @@ public:
       teardownStandardFixture(bst);
    }
 
+   /***************************************
+    * STATS
+    *    BST::stats()
+    ***************************************/
+
+   // nothing: a valid tree of height 0
+   void test_stats_empty()
+   {  // setup
+      custom::BST <Spy> bst;
+      Spy::reset();
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(stats.numNodes == 0);
+      assertUnit(stats.height == 0);
+      assertUnit(stats.depthMax == 0);
+      assertUnit(stats.depthAverage == 0.0);
+      assertUnit(stats.depthCounts.empty());
+      assertUnit(stats.bytesNodes == 0);
+      assertUnit(stats.isValid);
+      assertUnit(stats.isRedBlack);
+      assertUnit(stats.blackHeight == 0);
+      assertUnit(Spy::numLessthan() == 0);
+      assertEmptyFixture(bst);
+   }  // teardown
+
+   // the standard fixture is full and all black
+   void test_stats_standard()
+   {  // setup
+      //                (50)
+      //          +-------+-------+
+      //        (30)            (70)
+      //     +----+----+     +----+----+
+      //   (20)       (40) (60)       (80)
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      Spy::reset();
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(stats.numNodes == 7);
+      assertUnit(stats.height == 3);
+      assertUnit(stats.depthMax == 2);
+      assertUnit(stats.depthAverage == 10.0 / 7.0);
+      assertUnit(stats.depthCounts == std::vector<size_t>({ 1, 2, 4 }));
+      assertUnit(stats.bytesNode >= sizeof(custom::BST<Spy>::BNode));
+      assertUnit(stats.bytesNodes == 7 * stats.bytesNode);
+      assertUnit(stats.isValid);
+      assertUnit(stats.isRedBlack);
+      assertUnit(stats.blackHeight == 3);
+      assertUnit(Spy::numLessthan() == 6);   // each node after the first, in order
+      assertUnit(Spy::numCopy() == 0);
+      assertStandardFixture(bst);
+      // teardown
+      teardownStandardFixture(bst);
+   }
+
+   // a long chain is walked without recursion
+   void test_stats_chain()
+   {  // setup
+      const size_t num = 100000;
+      custom::BST <int> bst;
+      custom::BST <int>::BNode * pTail = nullptr;
+      for (size_t i = 0; i < num; i++)
+      {
+         custom::BST <int>::BNode * p = new custom::BST <int>::BNode((int)i);
+         if (pTail)
+            pTail->addRight(p);
+         else
+            bst.root = p;
+         pTail = p;
+      }
+      bst.numElements = num;
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(stats.numNodes == num);
+      assertUnit(stats.height == num);
+      assertUnit(stats.depthMax == num - 1);
+      assertUnit(stats.depthAverage == (double)(num - 1) / 2.0);
+      assertUnit(stats.isValid);
+      assertUnit(!stats.isRedBlack);
+      assertUnit(stats.blackHeight == 0);
+   }  // teardown
+
+   // a long chain is copied without recursion
+   void test_assign_chain()
+   {  // setup
+      const size_t num = 1000000;
+      custom::BST <int> bstSrc;
+      custom::BST <int>::BNode * pTail = nullptr;
+      for (size_t i = 0; i < num; i++)
+      {
+         custom::BST <int>::BNode * p = new custom::BST <int>::BNode((int)i);
+         if (pTail)
+            pTail->addRight(p);
+         else
+            bstSrc.root = p;
+         pTail = p;
+      }
+      bstSrc.numElements = num;
+      custom::BST <int> bstDest{ 5, 3, 8 };
+      // exercise
+      bstDest = bstSrc;
+      // verify
+      custom::tree_stats stats = bstDest.stats();
+      assertUnit(bstDest.size() == num);
+      assertUnit(stats.numNodes == num);
+      assertUnit(stats.height == num);
+      assertUnit(stats.isValid);
+      assertUnit(*bstDest.begin() == 0);
+   }  // teardown
+
+   // a tree built balanced is colored as a red-black tree
+   void test_stats_balancedBuild()
+   {  // setup
+      custom::BST <int> bst;
+      std::vector<int> values;
+      for (int i = 0; i < 1000; i++)
+         values.push_back(i);
+      // exercise
+      bst.assignBalanced(values.size(), 1, [&values](size_t i)
+      {
+         return new custom::BST <int>::BNode(values[i]);
+      });
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(stats.numNodes == 1000);
+      assertUnit(stats.height == 10);
+      assertUnit(stats.isValid);
+      assertUnit(stats.isRedBlack);
+      assertUnit(stats.blackHeight == 9);
+   }  // teardown
+
+   // a red node may not have a red child
+   void test_stats_redRed()
+   {  // setup
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      bst.root->pLeft->isRed = true;
+      bst.root->pLeft->pLeft->isRed = true;
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(stats.isValid);
+      assertUnit(!stats.isRedBlack);
+      // teardown
+      teardownStandardFixture(bst);
+   }
+
+   // every path crosses as many black nodes
+   void test_stats_blackHeight()
+   {  // setup
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      bst.root->pRight->isRed = true;
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(stats.isValid);
+      assertUnit(!stats.isRedBlack);
+      assertUnit(stats.blackHeight == 0);
+      // teardown
+      teardownStandardFixture(bst);
+   }
+
+   // the values out of order
+   void test_stats_outOfOrder()
+   {  // setup
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      bst.root->pLeft->pRight->data = Spy(55);   // 40 becomes 55, left of 50
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(!stats.isValid);
+      assertUnit(stats.numNodes == 7);
+      // teardown
+      teardownStandardFixture(bst);
+   }
+
+   // a child that does not point back is not followed
+   void test_stats_badParent()
+   {  // setup
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      custom::BST <Spy>::BNode * p30 = bst.root->pLeft;
+      p30->pParent = p30->pLeft;
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(!stats.isValid);
+      assertUnit(stats.numNodes == 4);   // 50, 70, 60, 80
+      // teardown
+      p30->pParent = bst.root;
+      teardownStandardFixture(bst);
+   }
+
+   // a root that claims a parent is reported, and the walk stays in the tree
+   void test_stats_rootHasParent()
+   {  // setup
+      custom::BST <Spy> bst;
+      setupStandardFixture(bst);
+      custom::BST <Spy>::BNode above(Spy(90));
+      custom::BST <Spy>::BNode beside(Spy(95));
+      above.pLeft = bst.root;
+      above.pRight = &beside;
+      beside.pParent = &above;
+      bst.root->pParent = &above;
+      // exercise
+      custom::tree_stats stats = bst.stats();
+      // verify
+      assertUnit(!stats.isValid);
+      assertUnit(stats.numNodes == 7);   // neither 90 nor 95
+      assertUnit(stats.height == 3);
+      // teardown
+      bst.root->pParent = nullptr;
+      teardownStandardFixture(bst);
+   }
+
    /***************************************
     * Assignment
     *    BST::operator=(const BST &)
@@ -1032,13 +1264,13 @@ public:
       // exercise
       bstDest = ilSrc;
       // verify
-      assertUnit(Spy::numCopy() == 7);
-      assertUnit(Spy::numAlloc() == 7);
+      assertUnit(Spy::numCopy() == 6);        // copy     [30][70][20][40][60][80]
+      assertUnit(Spy::numAlloc() == 6);       // allocate [30][70][20][40][60][80]
       assertUnit(Spy::numDefault() == 0);
-      assertUnit(Spy::numDelete() == 1);
+      assertUnit(Spy::numDelete() == 0);      // the (99) node is reused
       assertUnit(Spy::numNondefault() == 0);
       assertUnit(Spy::numCopyMove() == 0);
-      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssign() == 1);      // assign   [99] <- [50]
       assertUnit(Spy::numAssignMove() == 0);
       assertUnit(Spy::numEquals() == 0);
       assertUnit(Spy::numLessthan() == 10);
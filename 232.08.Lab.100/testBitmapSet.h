@@ -0,0 +1,376 @@
+/***********************************************************************
+ * Header:
+ *    TEST BITMAP SET
+ * Summary:
+ *    Unit tests for bitmap_set
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "bitmapSet.h"
+#include "unitTest.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+/***********************************************
+ * TEST BITMAP SET
+ * Unit tests for the roaring-style bitmap set
+ ***********************************************/
+class TestBitmapSet : public UnitTest
+{
+   typedef custom::bitmap_set::Container Container;
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_standard();
+
+      // Insert
+      test_insert_duplicate();
+      test_insert_arrayBecomesBitmap();
+      test_insert_intoRun();
+
+      // Erase
+      test_erase_missing();
+      test_erase_bitmapBecomesArray();
+      test_erase_lastInChunk();
+      test_erase_iterator();
+
+      // Access
+      test_lowerBound_acrossChunks();
+      test_iterate_extremes();
+
+      // Runs
+      test_runOptimize_consecutive();
+      test_runOptimize_sparse();
+
+      // Set algebra
+      test_union_mixed();
+      test_intersection_mixed();
+      test_intersection_disjoint();
+
+      report("BitmapSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // nothing in it
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::bitmap_set s;
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.size() == 0);
+      assertUnit(s.begin() == s.end());
+      assertUnit(s.keys.empty());
+   }  // teardown
+
+   // the standard fixture fits in one ARRAY container
+   void test_construct_standard()
+   {  // setup
+      // exercise
+      custom::bitmap_set s{ 50, 30, 70, 20, 40, 60, 80 };
+      // verify
+      assertUnit(s.size() == 7);
+      assertUnit(contents(s) == std::vector<uint32_t>({ 20, 30, 40, 50, 60, 70, 80 }));
+      assertUnit(s.keys.size() == 1);
+      assertUnit(s.containers[0].type == Container::ARRAY);
+      assertUnit(s.contains(40));
+      assertUnit(!s.contains(45));
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // a second insert finds the first
+   void test_insert_duplicate()
+   {  // setup
+      custom::bitmap_set s{ 50, 30, 70 };
+      // exercise
+      auto result = s.insert(30);
+      // verify
+      assertUnit(!result.second);
+      assertUnit(result.first != s.end());
+      if (result.first != s.end())
+         assertUnit(*result.first == 30);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // the 4097th value in a chunk turns its ARRAY into a BITMAP
+   void test_insert_arrayBecomesBitmap()
+   {  // setup
+      custom::bitmap_set s;
+      for (uint32_t i = 0; i < 4096; i++)
+         s.insert(i * 2);
+      assertUnit(s.containers[0].type == Container::ARRAY);
+      // exercise
+      auto result = s.insert(9999);
+      // verify
+      assertUnit(result.second);
+      assertUnit(*result.first == 9999);
+      assertUnit(s.containers[0].type == Container::BITMAP);
+      assertUnit(s.containers[0].cardinality == 4097);
+      assertUnit(s.size() == 4097);
+      assertUnit(s.contains(8190));
+      assertUnit(s.contains(9999));
+      assertUnit(!s.contains(8191));
+   }  // teardown
+
+   // changing a RUN container expands it first
+   void test_insert_intoRun()
+   {  // setup
+      custom::bitmap_set s;
+      for (uint32_t i = 100; i < 200; i++)
+         s.insert(i);
+      s.run_optimize();
+      assertUnit(s.containers[0].type == Container::RUN);
+      // exercise
+      s.insert(150);
+      assertUnit(s.containers[0].type == Container::RUN);
+      s.insert(300);
+      // verify
+      assertUnit(s.containers[0].type == Container::ARRAY);
+      assertUnit(s.size() == 101);
+      assertUnit(s.contains(199));
+      assertUnit(s.contains(300));
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // nothing to erase
+   void test_erase_missing()
+   {  // setup
+      custom::bitmap_set s{ 50, 30, 70 };
+      // exercise
+      size_t num = s.erase(40) + s.erase(70 + 65536);
+      // verify
+      assertUnit(num == 0);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // a BITMAP that drops to 4096 values goes back to an ARRAY
+   void test_erase_bitmapBecomesArray()
+   {  // setup
+      custom::bitmap_set s;
+      for (uint32_t i = 0; i < 4097; i++)
+         s.insert(i);
+      assertUnit(s.containers[0].type == Container::BITMAP);
+      // exercise
+      size_t num = s.erase(0);
+      // verify
+      assertUnit(num == 1);
+      assertUnit(s.containers[0].type == Container::ARRAY);
+      assertUnit(s.containers[0].values.size() == 4096);
+      assertUnit(s.containers[0].words.empty());
+      assertUnit(*s.begin() == 1);
+   }  // teardown
+
+   // the chunk goes away with its last value
+   void test_erase_lastInChunk()
+   {  // setup
+      custom::bitmap_set s{ 5, 70000, 200000 };
+      // exercise
+      s.erase(70000);
+      // verify
+      assertUnit(s.keys == std::vector<uint16_t>({ 0, 3 }));
+      assertUnit(s.containers.size() == 2);
+      assertUnit(contents(s) == std::vector<uint32_t>({ 5, 200000 }));
+   }  // teardown
+
+   // erasing through an iterator gives the next one
+   void test_erase_iterator()
+   {  // setup
+      custom::bitmap_set s{ 50, 30, 70, 20 };
+      auto it = s.find(30);
+      // exercise
+      auto itNext = s.erase(it);
+      // verify
+      assertUnit(itNext != s.end());
+      if (itNext != s.end())
+         assertUnit(*itNext == 50);
+      assertUnit(contents(s) == std::vector<uint32_t>({ 20, 50, 70 }));
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // lower bound finds the next key, in this chunk or a later one
+   void test_lowerBound_acrossChunks()
+   {  // setup
+      custom::bitmap_set s{ 10, 65530, 65536 * 5 + 7 };
+      // exercise
+      auto it1 = s.lower_bound(11);
+      auto it2 = s.lower_bound(65531);
+      auto it3 = s.lower_bound(65536 * 5 + 8);
+      // verify
+      assertUnit(it1 != s.end() && *it1 == 65530);
+      assertUnit(it2 != s.end() && *it2 == 65536 * 5 + 7);
+      assertUnit(it3 == s.end());
+      assertUnit(s.find(65536 * 5 + 7) != s.end());
+      assertUnit(s.find(65536 * 4 + 7) == s.end());
+   }  // teardown
+
+   // the edges of the key space, in every kind of container
+   void test_iterate_extremes()
+   {  // setup
+      std::vector<uint32_t> v{ 0, 1, 65535, 65536, 0xfffffffe, 0xffffffff };
+      custom::bitmap_set sArray(v.begin(), v.end());
+      custom::bitmap_set sBitmap(v.begin(), v.end());
+      custom::bitmap_set sRun(v.begin(), v.end());
+      // exercise
+      for (auto & container : sBitmap.containers)
+         container.toBitmap();
+      for (auto & container : sRun.containers)
+         container.toRun();
+      // verify
+      assertUnit(contents(sArray) == v);
+      assertUnit(contents(sBitmap) == v);
+      assertUnit(contents(sRun) == v);
+      assertUnit(sBitmap.contains(0xffffffff));
+      assertUnit(sRun.contains(0xffffffff));
+      assertUnit(!sRun.contains(2));
+   }  // teardown
+
+   /***************************************
+    * RUNS
+    ***************************************/
+
+   // long stretches shrink to a few runs
+   void test_runOptimize_consecutive()
+   {  // setup
+      custom::bitmap_set s;
+      for (uint32_t i = 1000; i < 50000; i++)
+         s.insert(i);
+      for (uint32_t i = 60000; i < 60010; i++)
+         s.insert(i);
+      size_t memoryBefore = s.memory();
+      // exercise
+      s.run_optimize();
+      // verify
+      assertUnit(s.containers[0].type == Container::RUN);
+      assertUnit(s.containers[0].values == std::vector<uint16_t>({ 1000, 48999, 60000, 9 }));
+      assertUnit(s.memory() < memoryBefore / 20);
+      assertUnit(s.contains(1000) && s.contains(49999) && s.contains(60009));
+      assertUnit(!s.contains(999) && !s.contains(50000) && !s.contains(60010));
+      assertUnit(s.size() == 49010);
+      auto it = s.lower_bound(50000);
+      assertUnit(it != s.end() && *it == 60000);
+   }  // teardown
+
+   // scattered values stay where they are
+   void test_runOptimize_sparse()
+   {  // setup
+      custom::bitmap_set s{ 1, 3, 5, 7 };
+      // exercise
+      s.run_optimize();
+      // verify
+      assertUnit(s.containers[0].type == Container::ARRAY);
+   }  // teardown
+
+   /***************************************
+    * SET ALGEBRA
+    ***************************************/
+
+   // every pair of container types, checked against std::set_union
+   void test_union_mixed()
+   {  // setup
+      std::vector<uint32_t> lhs = mixed(3);
+      std::vector<uint32_t> rhs = mixed(5);
+      custom::bitmap_set sLhs(lhs.begin(), lhs.end());
+      custom::bitmap_set sRhs(rhs.begin(), rhs.end());
+      sLhs.run_optimize();
+      std::vector<uint32_t> expected;
+      std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+      // exercise
+      custom::bitmap_set s = sLhs | sRhs;
+      // verify
+      assertUnit(s.size() == expected.size());
+      assertUnit(contents(s) == expected);
+      sLhs |= sRhs;
+      assertUnit(contents(sLhs) == expected);
+   }  // teardown
+
+   // every pair of container types, checked against std::set_intersection
+   void test_intersection_mixed()
+   {  // setup
+      std::vector<uint32_t> lhs = mixed(3);
+      std::vector<uint32_t> rhs = mixed(5);
+      custom::bitmap_set sLhs(lhs.begin(), lhs.end());
+      custom::bitmap_set sRhs(rhs.begin(), rhs.end());
+      sRhs.run_optimize();
+      std::vector<uint32_t> expected;
+      std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(expected));
+      // exercise
+      custom::bitmap_set s = sLhs & sRhs;
+      // verify
+      assertUnit(s.size() == expected.size());
+      assertUnit(contents(s) == expected);
+      sLhs &= sRhs;
+      assertUnit(contents(sLhs) == expected);
+   }  // teardown
+
+   // no chunk in common, nothing left
+   void test_intersection_disjoint()
+   {  // setup
+      custom::bitmap_set sLhs{ 1, 2, 3 };
+      custom::bitmap_set sRhs{ 65536 + 1, 65536 + 2 };
+      // exercise
+      custom::bitmap_set s = sLhs & sRhs;
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.keys.empty());
+   }  // teardown
+
+   /*************************************************************
+    * MIXED
+    * Sorted keys over six chunks, each with its own stride and
+    * limit, so the chunks come out as sparse ARRAYs, BITMAPs and
+    * consecutive stretches in different places for different steps
+    *************************************************************/
+   static std::vector<uint32_t> mixed(uint32_t step)
+   {
+      std::vector<uint32_t> v;
+      for (uint32_t chunk = 0; chunk < 6; chunk++)
+      {
+         uint32_t stride = 1u << ((chunk * step) % 5);
+         uint32_t limit = chunk % 2 ? 65536 : 30000;
+         for (uint32_t low = chunk * 100; low < limit; low += stride)
+            v.push_back(chunk * 65536 + low);
+         if (chunk == 4)
+            for (uint32_t low = limit; low < 65536; low += 500)
+               v.push_back(chunk * 65536 + low);
+      }
+      return v;
+   }
+
+   /*************************************************************
+    * CONTENTS
+    * Everything in the set, in order
+    *************************************************************/
+   static std::vector<uint32_t> contents(const custom::bitmap_set & s)
+   {
+      std::vector<uint32_t> v;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         v.push_back(*it);
+      return v;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,509 @@
+/***********************************************************************
+ * Header:
+ *    TEST COMPLEXITY
+ * Summary:
+ *    Hold every set and BST operation to an asymptotic budget, counted
+ *    in Spy comparisons, copies, and allocations at n = 64 ... 8192.
+ *    A change that makes find() linear passes every fixture test but
+ *    fails here.
+ *
+ *    The tree does not rebalance, so the logarithmic budgets are for
+ *    keys arriving in random order: a random BST averages about
+ *    1.39 log2(n) levels, and find() compares twice per level.
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "set.h"
+#include "bst.h"
+#include "spy.h"
+#include "complexity.h"
+#include "unitTest.h"
+
+#include <algorithm>   // for std::shuffle
+#include <random>      // for std::mt19937
+#include <vector>
+
+/***********************************************
+ * TEST COMPLEXITY
+ * Unit tests for complexity and the budgets of
+ * set and BST
+ ***********************************************/
+class TestComplexity : public UnitTest
+{
+   typedef custom::complexity         complexity;
+   typedef custom::complexity::Sample Sample;
+   typedef custom::complexity::Budget Budget;
+public:
+   void run()
+   {
+      reset();
+
+      // Harness
+      test_fit_constant();
+      test_fit_logarithmic();
+      test_fit_linear();
+      test_fit_linearithmic();
+      test_fit_quadratic();
+      test_withinBudget_over();
+
+      // Set lookups
+      test_set_find_random();
+      test_set_find_sorted();
+      test_set_findMissing_random();
+      test_set_lowerBound_random();
+
+      // Set changes
+      test_set_insert_random();
+      test_set_insert_duplicate();
+      test_set_erase_random();
+      test_set_clear();
+
+      // Set whole-tree operations
+      test_set_iterate();
+      test_set_copy();
+      test_set_move();
+
+      // BST
+      test_bst_insert_random();
+      test_bst_copyAssign();
+
+      report("Complexity");
+   }
+
+   /***************************************
+    * HARNESS
+    ***************************************/
+
+   // a cost that never changes
+   void test_fit_constant()
+   {  // setup
+      std::vector<Sample> samples = complexity::sample(64, 8192, [](size_t) { return 3; });
+      // exercise
+      complexity::Order order = complexity::fit(samples);
+      // verify
+      assertUnit(samples.size() == 8);
+      assertUnit(samples.front().n == 64);
+      assertUnit(samples.back().n == 8192);
+      assertUnit(order == complexity::CONSTANT);
+   }  // teardown
+
+   // log2(n), even less a constant
+   void test_fit_logarithmic()
+   {  // setup
+      std::vector<Sample> samples = complexity::sample(64, 8192, [](size_t n)
+      {
+         return 2.0 * std::log2((double)n) - 5.0;
+      });
+      // exercise
+      complexity::Order order = complexity::fit(samples);
+      // verify
+      assertUnit(order == complexity::LOGARITHMIC);
+   }  // teardown
+
+   // n, and n/2 is the same order
+   void test_fit_linear()
+   {  // setup
+      std::vector<Sample> samples = complexity::sample(64, 8192, [](size_t n) { return n / 2; });
+      // exercise
+      complexity::Order order = complexity::fit(samples);
+      // verify
+      assertUnit(order == complexity::LINEAR);
+   }  // teardown
+
+   // n log n is not mistaken for n
+   void test_fit_linearithmic()
+   {  // setup
+      std::vector<Sample> samples = complexity::sample(64, 8192, [](size_t n)
+      {
+         return (double)n * std::log2((double)n);
+      });
+      // exercise
+      complexity::Order order = complexity::fit(samples);
+      // verify
+      assertUnit(order == complexity::LINEARITHMIC);
+   }  // teardown
+
+   // n^2 fits nothing smaller
+   void test_fit_quadratic()
+   {  // setup
+      std::vector<Sample> samples = complexity::sample(64, 8192, [](size_t n) { return n * n; });
+      // exercise
+      complexity::Order order = complexity::fit(samples);
+      // verify
+      assertUnit(order == complexity::QUADRATIC);
+      assertUnit(complexity::name(order) == "O(n^2)");
+   }  // teardown
+
+   // the sample furthest over the budget is reported
+   void test_withinBudget_over()
+   {  // setup
+      std::vector<Sample> samples = { { 64, 10.0 }, { 128, 30.0 }, { 256, 20.0 } };
+      Budget budget = { complexity::CONSTANT, 1.0, 9.0 };
+      Sample over = { 0, 0.0 };
+      // exercise
+      bool isWithin = complexity::withinBudget(samples, budget, &over);
+      // verify
+      assertUnit(!isWithin);
+      assertUnit(over.n == 128);
+      assertUnit(over.cost == 30.0);
+      assertUnit(complexity::withinBudget(samples, Budget{ complexity::LINEAR, 1.0, 0.0 }));
+   }  // teardown
+
+   /***************************************
+    * SET LOOKUPS
+    ***************************************/
+
+   // every key once: O(log n) comparisons each
+   void test_set_find_random()
+   {  // setup
+      Budget budget = { complexity::LOGARITHMIC, 4.0, 2.0 };
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         custom::set<Spy> s;
+         for (int key : keys)
+            s.insert(Spy(key));
+         std::vector<Spy> probes(keys.begin(), keys.end());
+         Spy::reset();
+         for (const Spy & probe : probes)
+            s.find(probe);
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LOGARITHMIC);
+   }  // teardown
+
+   // sorted keys build a chain, so find() is O(n): this pins that
+   // down so it cannot get worse
+   void test_set_find_sorted()
+   {  // setup
+      Budget budget = { complexity::LINEAR, 1.0, 2.0 };
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX_CHAIN, [](size_t n)
+      {
+         custom::set<Spy> s;
+         for (size_t i = 0; i < n; i++)
+            s.insert(Spy((int)i));
+         std::vector<Spy> probes;
+         for (size_t i = 0; i < n; i++)
+            probes.push_back(Spy((int)i));
+         Spy::reset();
+         for (const Spy & probe : probes)
+            s.find(probe);
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LINEAR);
+   }  // teardown
+
+   // a miss walks to a leaf: still O(log n)
+   void test_set_findMissing_random()
+   {  // setup
+      Budget budget = { complexity::LOGARITHMIC, 4.0, 2.0 };
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         custom::set<Spy> s;
+         for (int key : keys)
+            s.insert(Spy(2 * key));
+         std::vector<Spy> probes;
+         for (int key : keys)
+            probes.push_back(Spy(2 * key + 1));
+         Spy::reset();
+         for (const Spy & probe : probes)
+            s.find(probe);
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LOGARITHMIC);
+   }  // teardown
+
+   // lower_bound() compares once a level
+   void test_set_lowerBound_random()
+   {  // setup
+      Budget budget = { complexity::LOGARITHMIC, 2.0, 2.0 };
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         custom::set<Spy> s;
+         for (int key : keys)
+            s.insert(Spy(key));
+         std::vector<Spy> probes(keys.begin(), keys.end());
+         Spy::reset();
+         for (const Spy & probe : probes)
+            s.lower_bound(probe);
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LOGARITHMIC);
+   }  // teardown
+
+   /***************************************
+    * SET CHANGES
+    ***************************************/
+
+   // O(log n) comparisons, and exactly one copy and allocation a key
+   void test_set_insert_random()
+   {  // setup
+      Budget budget = { complexity::LOGARITHMIC, 4.0, 2.0 };
+      Budget once   = { complexity::CONSTANT, 1.0, 0.0 };
+      std::vector<Sample> copies;
+      std::vector<Sample> allocs;
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [&](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         std::vector<Spy> values(keys.begin(), keys.end());
+         custom::set<Spy> s;
+         Spy::reset();
+         for (const Spy & value : values)
+            s.insert(value);
+         copies.push_back(Sample{ n, (double)Spy::numCopy() / n });
+         allocs.push_back(Sample{ n, (double)Spy::numAlloc() / n });
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LOGARITHMIC);
+      assertUnit(complexity::withinBudget(copies, once));
+      assertUnit(complexity::withinBudget(allocs, once));
+   }  // teardown
+
+   // a key already there costs the search and nothing else
+   void test_set_insert_duplicate()
+   {  // setup
+      Budget budget = { complexity::LOGARITHMIC, 4.0, 2.0 };
+      Budget none   = { complexity::CONSTANT, 0.0, 0.0 };
+      std::vector<Sample> copies;
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [&](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         std::vector<Spy> values(keys.begin(), keys.end());
+         custom::set<Spy> s;
+         for (const Spy & value : values)
+            s.insert(value);
+         Spy::reset();
+         for (const Spy & value : values)
+            s.insert(value);
+         copies.push_back(Sample{ n, (double)(Spy::numCopy() + Spy::numAlloc()) });
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::withinBudget(copies, none));
+   }  // teardown
+
+   // O(log n) comparisons; nodes are relinked, never copied
+   void test_set_erase_random()
+   {  // setup
+      Budget budget = { complexity::LOGARITHMIC, 4.0, 2.0 };
+      Budget none   = { complexity::CONSTANT, 0.0, 0.0 };
+      std::vector<Sample> copies;
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [&](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         custom::set<Spy> s;
+         for (int key : keys)
+            s.insert(Spy(key));
+         std::vector<Spy> probes(keys.rbegin(), keys.rend());
+         Spy::reset();
+         for (const Spy & probe : probes)
+            s.erase(probe);
+         copies.push_back(Sample{ n, (double)(Spy::numCopy() + Spy::numAssign() +
+                                              Spy::numCopyMove() + Spy::numAssignMove()) });
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::withinBudget(copies, none));
+   }  // teardown
+
+   // one destructor a key and no comparisons
+   void test_set_clear()
+   {  // setup
+      Budget budget = { complexity::LINEAR, 1.0, 0.0 };
+      std::vector<Sample> compares;
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [&](size_t n)
+      {
+         custom::set<Spy> s = build(n);
+         Spy::reset();
+         s.clear();
+         compares.push_back(Sample{ n, (double)numCompare() });
+         return (double)Spy::numDestructor();
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LINEAR);
+      assertUnit(complexity::fit(compares) == complexity::CONSTANT);
+      assertUnit(compares.back().cost == 0.0);
+   }  // teardown
+
+   /***************************************
+    * SET WHOLE-TREE OPERATIONS
+    ***************************************/
+
+   // walking the set never compares or copies a key
+   void test_set_iterate()
+   {  // setup
+      Budget none = { complexity::CONSTANT, 0.0, 0.0 };
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [](size_t n)
+      {
+         custom::set<Spy> s = build(n);
+         Spy::reset();
+         size_t numVisited = 0;
+         for (auto it = s.begin(); it != s.end(); ++it)
+            numVisited++;
+         assert(numVisited == n);
+         return numCompare() + Spy::numCopy();
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, none));
+   }  // teardown
+
+   // one copy a key and no comparisons: the shape is cloned, not rebuilt
+   void test_set_copy()
+   {  // setup
+      Budget budget = { complexity::LINEAR, 1.0, 0.0 };
+      std::vector<Sample> compares;
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [&](size_t n)
+      {
+         custom::set<Spy> s = build(n);
+         Spy::reset();
+         custom::set<Spy> sCopy(s);
+         compares.push_back(Sample{ n, (double)numCompare() });
+         return (double)Spy::numCopy();
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LINEAR);
+      assertUnit(compares.back().cost == 0.0);
+   }  // teardown
+
+   // moving touches no key at any size
+   void test_set_move()
+   {  // setup
+      Budget none = { complexity::CONSTANT, 0.0, 0.0 };
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [](size_t n)
+      {
+         custom::set<Spy> s = build(n);
+         Spy::reset();
+         custom::set<Spy> sMoved(std::move(s));
+         return numTouched();
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, none));
+   }  // teardown
+
+   /***************************************
+    * BST
+    ***************************************/
+
+   // the same O(log n) search as the set, without uniqueness checks
+   void test_bst_insert_random()
+   {  // setup
+      Budget budget = { complexity::LOGARITHMIC, 2.0, 2.0 };
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         std::vector<Spy> values(keys.begin(), keys.end());
+         custom::BST<Spy> bst;
+         Spy::reset();
+         for (const Spy & value : values)
+            bst.insert(value);
+         return (double)numCompare() / n;
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LOGARITHMIC);
+   }  // teardown
+
+   // assigning over a tree of the same size is linear and compares nothing
+   void test_bst_copyAssign()
+   {  // setup
+      Budget budget = { complexity::LINEAR, 1.0, 0.0 };
+      std::vector<Sample> compares;
+      // exercise
+      std::vector<Sample> samples = complexity::sample(N_MIN, N_MAX, [&](size_t n)
+      {
+         std::vector<int> keys = shuffled(n);
+         custom::BST<Spy> bstSrc;
+         custom::BST<Spy> bstDest;
+         for (int key : keys)
+         {
+            bstSrc.insert(Spy(key));
+            bstDest.insert(Spy(key + 1));
+         }
+         Spy::reset();
+         bstDest = bstSrc;
+         compares.push_back(Sample{ n, (double)numCompare() });
+         return (double)(Spy::numCopy() + Spy::numAssign());
+      });
+      // verify
+      assertUnit(complexity::withinBudget(samples, budget));
+      assertUnit(complexity::fit(samples) == complexity::LINEAR);
+      assertUnit(compares.back().cost == 0.0);
+   }  // teardown
+
+private:
+
+   static const size_t N_MIN = 64;
+   static const size_t N_MAX = 8192;
+   static const size_t N_MAX_CHAIN = 2048;   // sorted input is O(n^2) to build
+
+   // 0 ... n-1 in a fixed random order
+   static std::vector<int> shuffled(size_t n)
+   {
+      std::vector<int> keys(n);
+      for (size_t i = 0; i < n; i++)
+         keys[i] = (int)i;
+      std::mt19937 generator(2463534242u);
+      std::shuffle(keys.begin(), keys.end(), generator);
+      return keys;
+   }
+
+   // a set of n keys inserted in random order
+   static custom::set<Spy> build(size_t n)
+   {
+      custom::set<Spy> s;
+      for (int key : shuffled(n))
+         s.insert(Spy(key));
+      return s;
+   }
+
+   static uint64_t numCompare()
+   {
+      return Spy::numEquals() + Spy::numLessthan();
+   }
+
+   // every use of a Spy counted, of any kind
+   static uint64_t numTouched()
+   {
+      uint64_t totals[NUM_MARKERS];
+      Spy::countAll(totals);
+      uint64_t num = 0;
+      for (int i = 0; i < NUM_MARKERS; i++)
+         num += totals[i];
+      return num;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,279 @@
+/***********************************************************************
+ * Header:
+ *    TEST COMPRESSED SET
+ * Summary:
+ *    Unit tests for compressed_int_set and compressed_string_set
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "compressedSet.h"
+#include "set.h"
+#include "unitTest.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************
+ * TEST COMPRESSED SET
+ * Unit tests for the compressed read-mostly sets
+ ***********************************************/
+class TestCompressedSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Integers
+      test_int_empty();
+      test_int_standard();
+      test_int_unsorted();
+      test_int_negative();
+      test_int_extremes();
+      test_int_lowerBoundBlocks();
+      test_int_denseIsSmall();
+
+      // Strings
+      test_string_empty();
+      test_string_standard();
+      test_string_sharedPrefix();
+      test_string_lowerBoundBlocks();
+      test_string_prefixIsSmall();
+
+      report("CompressedSet");
+   }
+
+   /***************************************
+    * INTEGERS
+    ***************************************/
+
+   // nothing to store, nothing to find
+   void test_int_empty()
+   {  // setup
+      std::vector<int> v;
+      // exercise
+      custom::compressed_int_set<int> s(v.begin(), v.end());
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.size() == 0);
+      assertUnit(s.begin() == s.end());
+      assertUnit(s.find(50) == s.end());
+      assertUnit(s.lower_bound(50) == s.end());
+      assertUnit(s.firsts.empty());
+      assertUnit(s.bits.empty());
+   }  // teardown
+
+   // built from a custom::set, one block of gaps of ten
+   void test_int_standard()
+   {  // setup
+      custom::set<int> sSrc{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      custom::compressed_int_set<int> s(sSrc.begin(), sSrc.end());
+      // verify
+      assertUnit(s.size() == 7);
+      assertUnit(contents(s) == std::vector<int>({ 20, 30, 40, 50, 60, 70, 80 }));
+      assertUnit(s.firsts.size() == 1);
+      assertUnit(s.widths.size() == 1 && s.widths[0] == 4);
+      assertUnit(s.bits.size() == 1);   // six gaps of four bits
+      assertUnit(s.contains(40));
+      assertUnit(!s.contains(45));
+      auto it = s.find(80);
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == 80);
+   }  // teardown
+
+   // any order in, sorted and without duplicates out
+   void test_int_unsorted()
+   {  // setup
+      std::vector<unsigned> v{ 9, 3, 7, 3, 1, 9 };
+      // exercise
+      custom::compressed_int_set<unsigned> s(v.begin(), v.end());
+      // verify
+      assertUnit(contents(s) == std::vector<unsigned>({ 1, 3, 7, 9 }));
+   }  // teardown
+
+   // negative numbers sort before positive ones
+   void test_int_negative()
+   {  // setup
+      std::vector<int64_t> v{ -1000, -3, 0, 5, 1000000 };
+      // exercise
+      custom::compressed_int_set<int64_t> s(v.begin(), v.end());
+      // verify
+      assertUnit(contents(s) == v);
+      auto it = s.lower_bound(-4);
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == -3);
+      assertUnit(s.contains(-1000));
+      assertUnit(!s.contains(-999));
+   }  // teardown
+
+   // a gap as wide as the type still round trips
+   void test_int_extremes()
+   {  // setup
+      std::vector<uint64_t> v{ 0, 1, 0xFFFFFFFFFFFFFFFFULL };
+      // exercise
+      custom::compressed_int_set<uint64_t> s(v.begin(), v.end());
+      // verify
+      assertUnit(contents(s) == v);
+      assertUnit(s.widths[0] == 64);
+      assertUnit(s.contains(0xFFFFFFFFFFFFFFFFULL));
+      assertUnit(!s.contains(2));
+   }  // teardown
+
+   // lookups that land on, before, and between block boundaries
+   void test_int_lowerBoundBlocks()
+   {  // setup
+      std::vector<int> v;
+      for (int i = 0; i < 1000; i++)
+         v.push_back(i * 3);
+      custom::compressed_int_set<int> s(v.begin(), v.end());
+      // exercise
+      bool isCorrect = true;
+      for (int key = -2; key < 3002; key++)
+      {
+         auto it = s.lower_bound(key);
+         int expected = (key + 2) / 3 * 3;
+         if (key < 0)
+            isCorrect = isCorrect && it == s.begin();
+         else if (expected > 2997)
+            isCorrect = isCorrect && it == s.end();
+         else
+            isCorrect = isCorrect && it != s.end() && *it == expected;
+         isCorrect = isCorrect && s.contains(key) == (key >= 0 && key % 3 == 0 && key < 3000);
+      }
+      // verify
+      assertUnit(isCorrect);
+      assertUnit(s.firsts.size() == 8);
+      assertUnit(contents(s) == v);
+   }  // teardown
+
+   // dense ids take a few bits apiece instead of a node apiece
+   void test_int_denseIsSmall()
+   {  // setup
+      std::vector<uint64_t> v;
+      for (uint64_t i = 0; i < 10000; i++)
+         v.push_back(1000000000000ULL + i * 5);
+      // exercise
+      custom::compressed_int_set<uint64_t> s(v.begin(), v.end());
+      // verify
+      assertUnit(s.memory() < v.size() * 2);
+      assertUnit(contents(s) == v);
+   }  // teardown
+
+   /***************************************
+    * STRINGS
+    ***************************************/
+
+   // nothing to store, nothing to find
+   void test_string_empty()
+   {  // setup
+      std::vector<std::string> v;
+      // exercise
+      custom::compressed_string_set s(v.begin(), v.end());
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+      assertUnit(s.find("a") == s.end());
+      assertUnit(s.bytes.empty());
+   }  // teardown
+
+   // built from a custom::set, including the empty string
+   void test_string_standard()
+   {  // setup
+      custom::set<std::string> sSrc{ "mango", "", "apple", "kiwi", "banana" };
+      // exercise
+      custom::compressed_string_set s(sSrc.begin(), sSrc.end());
+      // verify
+      assertUnit(s.size() == 5);
+      assertUnit(contents(s) == std::vector<std::string>({ "", "apple", "banana", "kiwi", "mango" }));
+      assertUnit(s.contains(""));
+      assertUnit(s.contains("kiwi"));
+      assertUnit(!s.contains("kiw"));
+      assertUnit(!s.contains("zebra"));
+      auto it = s.lower_bound("c");
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == "kiwi");
+   }  // teardown
+
+   // a string that is a prefix of the next one, and one that shares all of it
+   void test_string_sharedPrefix()
+   {  // setup
+      std::vector<std::string> v{ "http://a/", "http://a/b", "http://a/b/c", "http://a/c" };
+      // exercise
+      custom::compressed_string_set s(v.begin(), v.end());
+      // verify
+      assertUnit(contents(s) == v);
+      // "http://a/" whole, then 9 shared + "b", 10 shared + "/c", 9 shared + "c"
+      assertUnit(s.bytes.size() == 10 + 3 + 4 + 3);
+      assertUnit(!s.contains("http://a/b/"));
+   }  // teardown
+
+   // lookups that land on, before, and between block boundaries
+   void test_string_lowerBoundBlocks()
+   {  // setup
+      std::vector<std::string> v;
+      for (int i = 0; i < 200; i++)
+         v.push_back("key" + std::to_string(2000 + i * 2));
+      custom::compressed_string_set s(v.begin(), v.end());
+      // exercise
+      bool isCorrect = true;
+      for (int i = 1998; i < 2402; i++)
+      {
+         std::string key = "key" + std::to_string(i);
+         auto it = s.lower_bound(key);
+         int expected = (i + 1) / 2 * 2;
+         if (i < 2000)
+            isCorrect = isCorrect && it == s.begin();
+         else if (expected >= 2400)
+            isCorrect = isCorrect && it == s.end();
+         else
+            isCorrect = isCorrect && it != s.end() && *it == "key" + std::to_string(expected);
+         isCorrect = isCorrect && s.contains(key) == (i >= 2000 && i < 2400 && i % 2 == 0);
+      }
+      // verify
+      assertUnit(isCorrect);
+      assertUnit(s.offsets.size() == 13);
+      assertUnit(contents(s) == v);
+   }  // teardown
+
+   // URLs lose most of their bytes to the shared prefix
+   void test_string_prefixIsSmall()
+   {  // setup
+      std::vector<std::string> v;
+      size_t numChars = 0;
+      for (int i = 0; i < 1000; i++)
+      {
+         v.push_back("https://www.example.com/catalog/items/" + std::to_string(100000 + i));
+         numChars += v.back().size();
+      }
+      // exercise
+      custom::compressed_string_set s(v.begin(), v.end());
+      // verify
+      assertUnit(s.memory() * 4 < numChars);
+      assertUnit(contents(s) == v);
+   }  // teardown
+
+   /*************************************************************
+    * CONTENTS
+    * Everything in the set, in order
+    *************************************************************/
+   template <class Set>
+   static auto contents(const Set & s) -> std::vector<typename std::decay<decltype(*s.begin())>::type>
+   {
+      std::vector<typename std::decay<decltype(*s.begin())>::type> v;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         v.push_back(*it);
+      return v;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,263 @@
+/***********************************************************************
+ * Header:
+ *    TEST LATENCY HISTOGRAM
+ * Summary:
+ *    Unit tests for latency_histogram
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "latencyHistogram.h"
+#include "unitTest.h"
+
+#include <cstdint>
+
+/***********************************************
+ * TEST LATENCY HISTOGRAM
+ * Unit tests for the log-linear latency histogram
+ ***********************************************/
+class TestLatencyHistogram : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+
+      // Buckets
+      test_index_smallExact();
+      test_index_continuous();
+      test_index_precision();
+
+      // Record
+      test_record_stats();
+      test_record_count();
+      test_record_largest();
+
+      // Percentile
+      test_percentile_uniform();
+      test_percentile_tail();
+      test_percentile_extremes();
+
+      // Merge
+      test_add_merge();
+
+      // Timer
+      test_timer_records();
+
+      report("LatencyHistogram");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // nothing recorded
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::latency_histogram h;
+      // verify
+      assertUnit(h.empty());
+      assertUnit(h.count() == 0);
+      assertUnit(h.mean() == 0.0);
+      assertUnit(h.percentile(99.0) == 0);
+      assertUnit(h.counts.empty());
+   }  // teardown
+
+   /***************************************
+    * BUCKETS
+    ***************************************/
+
+   // below 128 every value has a bucket to itself
+   void test_index_smallExact()
+   {  // setup
+      // exercise
+      // verify
+      for (uint64_t value = 0; value < 128; value++)
+      {
+         size_t index = custom::latency_histogram::indexOf(value);
+         assertUnit(index == value);
+         assertUnit(custom::latency_histogram::lowestOf(index) == value);
+         assertUnit(custom::latency_histogram::highestOf(index) == value);
+      }
+   }  // teardown
+
+   // each bucket starts one past where the last one ended
+   void test_index_continuous()
+   {  // setup
+      // exercise
+      // verify
+      for (size_t index = 1; index < 64 * 40; index++)
+         assertUnit(custom::latency_histogram::lowestOf(index) ==
+                    custom::latency_histogram::highestOf(index - 1) + 1);
+      assertUnit(custom::latency_histogram::indexOf(128) == 128);
+      assertUnit(custom::latency_histogram::indexOf(255) == 191);
+      assertUnit(custom::latency_histogram::indexOf(256) == 192);
+   }  // teardown
+
+   // any value is within 1/64 of where its bucket starts
+   void test_index_precision()
+   {  // setup
+      uint64_t values[] = { 129, 1000, 123456, 999999999, 1ULL << 40, UINT64_MAX };
+      // exercise
+      // verify
+      for (uint64_t value : values)
+      {
+         size_t index = custom::latency_histogram::indexOf(value);
+         uint64_t lowest = custom::latency_histogram::lowestOf(index);
+         uint64_t highest = custom::latency_histogram::highestOf(index);
+         assertUnit(lowest <= value && value <= highest);
+         assertUnit((highest - lowest) <= lowest / 64);
+      }
+   }  // teardown
+
+   /***************************************
+    * RECORD
+    ***************************************/
+
+   // min, max, and mean are exact
+   void test_record_stats()
+   {  // setup
+      custom::latency_histogram h;
+      // exercise
+      h.record(100);
+      h.record(300);
+      h.record(5000);
+      // verify
+      assertUnit(h.count() == 3);
+      assertUnit(h.min() == 100);
+      assertUnit(h.max() == 5000);
+      assertUnit(h.total() == 5400);
+      assertUnit(h.mean() == 1800.0);
+   }  // teardown
+
+   // a value many times over, and zero times
+   void test_record_count()
+   {  // setup
+      custom::latency_histogram h;
+      // exercise
+      h.record(40, 10);
+      h.record(7, 0);
+      // verify
+      assertUnit(h.count() == 10);
+      assertUnit(h.min() == 40);
+      assertUnit(h.total() == 400);
+      assertUnit(h.counts.size() == 41);
+   }  // teardown
+
+   // the buckets only grow as far as they must
+   void test_record_largest()
+   {  // setup
+      custom::latency_histogram h;
+      // exercise
+      h.record(UINT64_MAX);
+      // verify
+      assertUnit(h.count() == 1);
+      assertUnit(h.max() == UINT64_MAX);
+      assertUnit(h.counts.size() == custom::latency_histogram::indexOf(UINT64_MAX) + 1);
+      assertUnit(h.percentile(50.0) == UINT64_MAX);
+   }  // teardown
+
+   /***************************************
+    * PERCENTILE
+    ***************************************/
+
+   // 1 ... 100: the exact buckets give exact answers
+   void test_percentile_uniform()
+   {  // setup
+      custom::latency_histogram h;
+      for (uint64_t value = 1; value <= 100; value++)
+         h.record(value);
+      // exercise
+      // verify
+      assertUnit(h.percentile(50.0) == 50);
+      assertUnit(h.percentile(90.0) == 90);
+      assertUnit(h.percentile(99.0) == 99);
+      assertUnit(h.percentile(100.0) == 100);
+   }  // teardown
+
+   // one slow call in a thousand shows at p99.9 and not at p99
+   void test_percentile_tail()
+   {  // setup
+      custom::latency_histogram h;
+      h.record(100, 998);
+      h.record(1000000, 2);
+      // exercise
+      uint64_t p99 = h.percentile(99.0);
+      uint64_t p999 = h.percentile(99.9);
+      // verify
+      assertUnit(p99 == 100);
+      assertUnit(p999 >= 1000000 && p999 <= 1000000 + 1000000 / 64);
+      assertUnit(h.percentile(100.0) == 1000000);
+   }  // teardown
+
+   // 0 is the minimum and no percentile passes the maximum
+   void test_percentile_extremes()
+   {  // setup
+      custom::latency_histogram h;
+      h.record(1000);
+      h.record(2000);
+      // exercise
+      // verify
+      assertUnit(h.percentile(0.0) == 1000);
+      assertUnit(h.percentile(0.001) <= 1000 + 1000 / 64);
+      assertUnit(h.percentile(100.0) == 2000);
+      assertUnit(h.percentile(150.0) == 2000);
+   }  // teardown
+
+   /***************************************
+    * MERGE
+    ***************************************/
+
+   // two histograms make the one both sets of values would
+   void test_add_merge()
+   {  // setup
+      custom::latency_histogram h1;
+      custom::latency_histogram h2;
+      custom::latency_histogram hBoth;
+      h1.record(10);
+      h1.record(500);
+      h2.record(3);
+      h2.record(80000);
+      for (uint64_t value : { 10, 500, 3, 80000 })
+         hBoth.record(value);
+      // exercise
+      h1 += h2;
+      // verify
+      assertUnit(h1.count() == 4);
+      assertUnit(h1.min() == 3);
+      assertUnit(h1.max() == 80000);
+      assertUnit(h1.total() == hBoth.total());
+      assertUnit(h1.counts == hBoth.counts);
+      assertUnit(h2.count() == 2);
+   }  // teardown
+
+   /***************************************
+    * TIMER
+    ***************************************/
+
+   // one value per scope
+   void test_timer_records()
+   {  // setup
+      custom::latency_histogram h;
+      // exercise
+      {
+         custom::latency_timer timer(h);
+      }
+      {
+         custom::latency_timer timer(h);
+      }
+      // verify
+      assertUnit(h.count() == 2);
+      assertUnit(h.max() < 1000000000);   // well under a second
+   }  // teardown
+};
+
+#endif // DEBUG
@@ -0,0 +1,215 @@
+/***********************************************************************
+ * Header:
+ *    TEST MAPPED SET
+ * Summary:
+ *    Unit tests for save_mapped() and mapped_set
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "mappedSet.h"
+#include "set.h"
+#include "unitTest.h"
+
+#include <cstdio>      // for std::remove
+#include <fstream>
+#include <vector>
+
+/***********************************************
+ * TEST MAPPED SET
+ * Unit tests for the memory-mapped set
+ ***********************************************/
+class TestMappedSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructMove_standard();
+
+      // File
+      test_open_empty();
+      test_open_standard();
+      test_open_missing();
+      test_open_wrongKeySize();
+      test_open_truncated();
+
+      // Access
+      test_find_standard();
+      test_lowerBound_standard();
+
+      report("MappedSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, nothing mapped
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::mapped_set<int> s;
+      // verify
+      assertUnit(s.pMap == nullptr);
+      assertUnit(s.numElements == 0);
+      assertUnit(!s.is_open());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // a move hands over the mapping
+   void test_constructMove_standard()
+   {  // setup
+      saveStandard();
+      custom::mapped_set<int> sSrc = custom::mmap_open<int>(PATH);
+      const void * pMap = sSrc.pMap;
+      // exercise
+      custom::mapped_set<int> sDest(std::move(sSrc));
+      // verify
+      assertUnit(sDest.pMap == pMap);
+      assertUnit(sDest.size() == 7);
+      assertUnit(sSrc.pMap == nullptr);
+      assertUnit(sSrc.size() == 0);
+      // teardown
+      sDest.close();
+      std::remove(PATH);
+   }
+
+   /***************************************
+    * OPEN
+    ***************************************/
+
+   // an empty set is just the header
+   void test_open_empty()
+   {  // setup
+      custom::set<int> sSave;
+      assertUnit(custom::save_mapped(sSave, PATH));
+      // exercise
+      custom::mapped_set<int> s = custom::mmap_open<int>(PATH);
+      // verify
+      assertUnit(s.is_open());
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+      // teardown
+      s.close();
+      std::remove(PATH);
+   }
+
+   // the keys come back in order, straight out of the mapping
+   void test_open_standard()
+   {  // setup
+      saveStandard();
+      // exercise
+      custom::mapped_set<int> s = custom::mmap_open<int>(PATH);
+      // verify
+      assertUnit(s.is_open());
+      assertUnit(s.size() == 7);
+      assertUnit(std::vector<int>(s.begin(), s.end()) ==
+                 std::vector<int>({ 20, 30, 40, 50, 60, 70, 80 }));
+      assertUnit((const char *)s.pKeys == (const char *)s.pMap + sizeof(custom::mapped_header));
+      // teardown
+      s.close();
+      std::remove(PATH);
+   }
+
+   // no file, no set
+   void test_open_missing()
+   {  // setup
+      std::remove(PATH);
+      // exercise
+      custom::mapped_set<int> s = custom::mmap_open<int>(PATH);
+      // verify
+      assertUnit(!s.is_open());
+      assertUnit(s.empty());
+   }  // teardown
+
+   // a file of ints is not a file of doubles
+   void test_open_wrongKeySize()
+   {  // setup
+      saveStandard();
+      // exercise
+      custom::mapped_set<double> s = custom::mmap_open<double>(PATH);
+      // verify
+      assertUnit(!s.is_open());
+      assertUnit(s.empty());
+      // teardown
+      std::remove(PATH);
+   }
+
+   // a header promising more keys than the file holds is rejected
+   void test_open_truncated()
+   {  // setup
+      {
+         std::vector<int> v{ 1, 2, 3, 4 };
+         custom::mapped_set<int>::write(PATH, v.begin(), v.end(), 100);
+      }
+      // exercise
+      custom::mapped_set<int> s = custom::mmap_open<int>(PATH);
+      // verify
+      assertUnit(!s.is_open());
+      // teardown
+      std::remove(PATH);
+   }
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // find hits and misses
+   void test_find_standard()
+   {  // setup
+      saveStandard();
+      custom::mapped_set<int> s = custom::mmap_open<int>(PATH);
+      // exercise
+      auto it40 = s.find(40);
+      auto it45 = s.find(45);
+      // verify
+      assertUnit(it40 != s.end());
+      if (it40 != s.end())
+         assertUnit(*it40 == 40);
+      assertUnit(it45 == s.end());
+      assertUnit(s.contains(80));
+      assertUnit(!s.contains(10));
+      // teardown
+      s.close();
+      std::remove(PATH);
+   }
+
+   // lower bound lands on the next key up
+   void test_lowerBound_standard()
+   {  // setup
+      saveStandard();
+      custom::mapped_set<int> s = custom::mmap_open<int>(PATH);
+      // exercise
+      auto it = s.lower_bound(45);
+      // verify
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == 50);
+      assertUnit(s.lower_bound(81) == s.end());
+      // teardown
+      s.close();
+      std::remove(PATH);
+   }
+
+   /*************************************************************
+    * SAVE STANDARD
+    * Write the standard fixture to PATH
+    *************************************************************/
+   void saveStandard()
+   {
+      custom::set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      assertUnit(custom::save_mapped(s, PATH));
+   }
+
+   static constexpr const char * PATH = "testMappedSet.tmp";
+};
+
+#endif // DEBUG
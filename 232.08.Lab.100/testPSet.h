@@ -0,0 +1,272 @@
+/***********************************************************************
+ * Header:
+ *    TEST PSET
+ * Summary:
+ *    Unit tests for pset
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "pset.h"
+#include "unitTest.h"
+#include "spy.h"
+
+#include <vector>
+#include <set>
+
+/***********************************************
+ * TEST PSET
+ * Unit tests for the persistent set
+ ***********************************************/
+class TestPSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructInit_standard();
+      test_constructCopy_shares();
+
+      // Iterator
+      test_iterator_ordered();
+
+      // Access
+      test_find_standard();
+      test_find_missing();
+
+      // Update
+      test_insert_oldVersionUnchanged();
+      test_insert_sharesUntouched();
+      test_insert_duplicate();
+      test_erase_oldVersionUnchanged();
+      test_erase_missing();
+      test_erase_all();
+
+      report("PSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, no nodes
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::pset<int> s;
+      // verify
+      assertUnit(s.root == nullptr);
+      assertUnit(s.numElements == 0);
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // initializer list
+   void test_constructInit_standard()
+   {  // setup
+      // exercise
+      custom::pset<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // verify
+      assertUnit(s.size() == 7);
+      assertUnit(s.root != nullptr);
+      if (s.root)
+         assertUnit(s.root->refs == 1);
+   }  // teardown
+
+   // a snapshot is the same root with one more reference, nothing copied
+   void test_constructCopy_shares()
+   {  // setup
+      custom::pset<Spy> sSrc{ Spy(50), Spy(30), Spy(70), Spy(20) };
+      Spy::reset();
+      // exercise
+      {
+         custom::pset<Spy> sDest(sSrc);
+         // verify
+         assertUnit(sDest.root == sSrc.root);
+         assertUnit(sDest.size() == 4);
+         if (sSrc.root)
+            assertUnit(sSrc.root->refs == 2);
+      }
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      if (sSrc.root)
+         assertUnit(sSrc.root->refs == 1);
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // in-order walk without parent pointers
+   void test_iterator_ordered()
+   {  // setup
+      custom::pset<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      std::vector<int> v = contents(s);
+      // verify
+      assertUnit(v == std::vector<int>({ 20, 30, 40, 50, 60, 70, 80 }));
+   }  // teardown
+
+   /***************************************
+    * FIND
+    ***************************************/
+
+   // find continues in order from the element
+   void test_find_standard()
+   {  // setup
+      custom::pset<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      std::vector<int> v;
+      // exercise
+      auto it = s.find(40);
+      // verify
+      assertUnit(it != s.end());
+      for (; it != s.end(); ++it)
+         v.push_back(*it);
+      assertUnit(v == std::vector<int>({ 40, 50, 60, 70, 80 }));
+   }  // teardown
+
+   // find something that is not there
+   void test_find_missing()
+   {  // setup
+      custom::pset<int> s{ 50, 30, 70 };
+      // exercise
+      auto it = s.find(42);
+      // verify
+      assertUnit(it == s.end());
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // the old version does not see the new element
+   void test_insert_oldVersionUnchanged()
+   {  // setup
+      custom::pset<int> sOld{ 50, 30, 70 };
+      // exercise
+      custom::pset<int> sNew = sOld.insert(40);
+      // verify
+      assertUnit(contents(sOld) == std::vector<int>({ 30, 50, 70 }));
+      assertUnit(contents(sNew) == std::vector<int>({ 30, 40, 50, 70 }));
+      assertUnit(sOld.size() == 3);
+      assertUnit(sNew.size() == 4);
+   }  // teardown
+
+   // an insert copies only the path, so most nodes stay shared
+   void test_insert_sharesUntouched()
+   {  // setup
+      custom::pset<Spy> sOld;
+      for (int i = 0; i < 64; i++)
+         sOld = sOld.insert(Spy(i * 2));
+      Spy::reset();
+      // exercise
+      custom::pset<Spy> sNew = sOld.insert(Spy(33));
+      // verify
+      assertUnit(sNew.size() == 65);
+      assertUnit(Spy::numCopy() < 64);      // only the path, not the tree
+      assertUnit(Spy::numCopy() == Spy::numAlloc() - 1);
+      assertUnit(countShared(sOld, sNew) > 32);
+   }  // teardown
+
+   // inserting what is already there gives the same version back
+   void test_insert_duplicate()
+   {  // setup
+      custom::pset<int> sOld{ 50, 30, 70 };
+      // exercise
+      custom::pset<int> sNew = sOld.insert(30);
+      // verify
+      assertUnit(sNew.root == sOld.root);
+      assertUnit(sNew.size() == 3);
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // the old version still has the element
+   void test_erase_oldVersionUnchanged()
+   {  // setup
+      custom::pset<int> sOld{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      custom::pset<int> sNew = sOld.erase(50);
+      // verify
+      assertUnit(contents(sOld) == std::vector<int>({ 20, 30, 40, 50, 60, 70, 80 }));
+      assertUnit(contents(sNew) == std::vector<int>({ 20, 30, 40, 60, 70, 80 }));
+      assertUnit(sNew.size() == 6);
+   }  // teardown
+
+   // erasing something missing gives the same version back
+   void test_erase_missing()
+   {  // setup
+      custom::pset<int> sOld{ 50, 30, 70 };
+      // exercise
+      custom::pset<int> sNew = sOld.erase(42);
+      // verify
+      assertUnit(sNew.root == sOld.root);
+      assertUnit(sNew.size() == 3);
+   }  // teardown
+
+   // erase everything, one version at a time, and free it all
+   void test_erase_all()
+   {  // setup
+      Spy::reset();
+      {
+         custom::pset<Spy> s{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40) };
+         custom::pset<Spy> sSnapshot(s);
+         // exercise
+         for (int i : { 20, 30, 40, 50, 70 })
+            s = s.erase(Spy(i));
+         // verify
+         assertUnit(s.empty());
+         assertUnit(s.root == nullptr);
+         assertUnit(sSnapshot.size() == 5);
+      }
+      // teardown
+      assertUnit(Spy::numAlloc() == Spy::numDelete());
+   }
+
+   /*************************************************************
+    * CONTENTS
+    * The elements of a version, in order
+    *************************************************************/
+   template <class T>
+   std::vector<T> contents(const custom::pset<T> & s)
+   {
+      std::vector<T> v;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         v.push_back(*it);
+      return v;
+   }
+
+   /*************************************************************
+    * COUNT SHARED
+    * Number of nodes of one version that another version also uses
+    *************************************************************/
+   template <class T>
+   size_t countShared(const custom::pset<T> & sLhs, const custom::pset<T> & sRhs)
+   {
+      std::set<const void *> nodes;
+      collect<T>(sLhs.root, nodes);
+      size_t numLhs = nodes.size();
+      collect<T>(sRhs.root, nodes);
+      return numLhs + sRhs.size() - nodes.size();
+   }
+   template <class T>
+   void collect(typename custom::pset<T>::PNode * p, std::set<const void *> & nodes)
+   {
+      if (!p)
+         return;
+      nodes.insert(p);
+      collect<T>(p->pLeft, nodes);
+      collect<T>(p->pRight, nodes);
+   }
+};
+
+#endif // DEBUG
@@ -2,7 +2,9 @@
  * Header:
  *    Test
  * Summary:
- *    Driver to test set.h
+ *    Driver to test set.h. Built with SET_LATENCY ("make test" builds
+ *    it both ways), it tests the set that times its own calls instead,
+ *    running only the suite that can tell the difference.
  * Author
  *    Br. Helfrich
  ************************************************************************/
@@ -17,7 +19,18 @@
 #include "testSet.h"        // for the set unit tests
 #include "testBST.h"        // for the BST unit tests
 #include "testSpy.h"        // for the spy unit tests
-int Spy::counters[] = {};
+#include "testShardedSet.h" // for the sharded set unit tests
+#include "testSkipList.h"   // for the skip list unit tests
+#include "testPSet.h"       // for the persistent set unit tests
+#include "testMappedSet.h"  // for the mapped set unit tests
+#include "testCompressedSet.h" // for the compressed set unit tests
+#include "testBitmapSet.h"  // for the bitmap set unit tests
+#include "testComplexity.h" // for the asymptotic budgets of set and BST
+#include "testLatencyHistogram.h" // for the latency histogram unit tests
+#include "testTrace.h"      // for the trace capture unit tests
+#include "testAllocTracker.h" // for the allocation tracker unit tests
+
+#include "allocHooks.h"      // count every allocation the tests make
 
 /**********************************************************************
  * MAIN
@@ -26,10 +39,25 @@ int Spy::counters[] = {};
 int main()
 {
 #ifdef DEBUG
+#ifdef SET_LATENCY
+   // the set with latency histograms, latency tests included
+   TestSet().run();
+#else
    // unit tests
    TestSpy().run();
    TestBST().run();
    TestSet().run();
+   TestShardedSet().run();
+   TestSkipList().run();
+   TestPSet().run();
+   TestMappedSet().run();
+   TestCompressedSet().run();
+   TestBitmapSet().run();
+   TestComplexity().run();
+   TestLatencyHistogram().run();
+   TestTrace().run();
+   TestAllocTracker().run();
+#endif // SET_LATENCY
 #endif // DEBUG
    
    return 0;
@@ -14,12 +14,18 @@
 
 #include "set.h"
 #include "unitTest.h"
+#include "spy.h"
+#include "allocTracker.h"
 #include <set>
 #include <vector>
+#include <iterator>   // for std::make_move_iterator
 
 #include <iostream>
 #include <cassert>
 #include <memory>
+#include <atomic>
+#include <sstream>
+#include <string>
 
 class TestSet : public UnitTest
 {
@@ -42,6 +48,10 @@ public:
       test_constructRange_empty();
       test_constructRange_one();
       test_constructRange_standard();
+      test_constructParallel_empty();
+      test_constructParallel_standard();
+      test_constructParallel_large();
+      test_constructParallel_spy();
       test_destructor_empty();
       test_destructor_standard();
 
@@ -87,6 +97,12 @@ public:
       test_find_standardBegin();
       test_find_standardLast();
       test_find_standardMissing();
+      test_findBatch_empty();
+      test_findBatch_standard();
+      test_findBatch_manyKeys();
+      test_containsBatch_standard();
+      test_findBatch_indexed();
+      test_containsBatch_indexed();
 
       // Insert
       test_insert_empty();
@@ -104,6 +120,10 @@ public:
       test_insertInit_standardInsertNone();
       test_insertInit_standardInsertDuplicates();
       test_insertInit_manyInsertMany();
+      test_insertBatch_emptyInsertMany();
+      test_insertBatch_standardInsertDuplicates();
+      test_insertBatch_manyInsertMany();
+      test_insertBatch_largeInsertFew();
 
       // Remove
       test_clear_empty();
@@ -124,6 +144,14 @@ public:
       test_eraseRange_standardMany();
       test_eraseRange_oneChild();
       test_eraseRange_twoChildren();
+      test_eraseKeys_standardNone();
+      test_eraseKeys_standardMiddle();
+      test_eraseKeys_standardAll();
+      test_eraseKeys_largeWindow();
+      test_eraseIf_standardNone();
+      test_eraseIf_standardAll();
+      test_eraseIf_largeFew();
+      test_eraseIf_largeMany();
 
 
       // Status
@@ -131,6 +159,98 @@ public:
       test_empty_standard();
       test_size_empty();
       test_size_standard();
+      test_stats_batch();
+      test_stats_sorted();
+
+      // Counters
+      test_counters_disabled();
+      test_counters_find();
+      test_counters_insert();
+      test_counters_erase();
+      test_counters_batch();
+      test_counters_batchRecolors();
+      test_counters_batchCompares();
+      test_counters_copy();
+
+      // Serialize
+      test_serialize_empty();
+      test_serialize_standard();
+      test_serialize_denseIsSmall();
+      test_serialize_negative();
+      test_serialize_strings();
+      test_deserialize_truncated();
+      test_deserialize_outOfOrder();
+
+      // Hash index
+      test_hashIndexed_enableStandard();
+      test_hashIndexed_disable();
+      test_hashIndexed_insertErase();
+      test_hashIndexed_insertDuplicate();
+      test_hashIndexed_insertBatch();
+      test_hashIndexed_eraseRange();
+      test_hashIndexed_eraseIf();
+      test_hashIndexed_copy();
+      test_hashIndexed_copyOnWriteDetach();
+
+#ifdef SET_LATENCY
+      // Latency
+      test_latency_insert();
+      test_latency_eraseOnce();
+      test_latency_find();
+      test_latency_batch();
+      test_latency_copyAssign();
+      test_latency_stayWithObject();
+#endif // SET_LATENCY
+
+      // Copy on write
+      test_cow_copyShares();
+      test_cow_copyAllocatesNothing();
+      test_cow_assignShares();
+      test_cow_insertDetaches();
+      test_cow_eraseIteratorDetaches();
+      test_cow_eraseRangeDetaches();
+      test_cow_clearDetaches();
+      test_cow_soleOwnerTakesBack();
+      test_cow_disabledClones();
+      test_cow_copyTakesModes();
+      test_cow_assignTakesModes();
+      test_cow_assignDropsModes();
+      test_cow_writeInvalidatesIterators();
+      test_cow_enableMakesOwner();
+      test_cow_disableTakesBack();
+      test_cow_copyOnlyReads();
+      test_cow_copyConcurrent();
+
+      // Parallel
+      test_chunks_empty();
+      test_chunks_one();
+      test_chunks_standard();
+      test_parallelForEach_empty();
+      test_parallelForEach_standard();
+
+      // Allocations
+      test_allocs_insert();
+      test_allocs_insertDuplicate();
+      test_allocs_find();
+      test_allocs_erase();
+      test_allocs_copy();
+      test_allocs_copyOnWrite();
+      test_allocs_destroy();
+
+      // Budgets
+      test_budget_insertCopy();
+      test_budget_insertMove();
+      test_budget_insertDuplicate();
+      test_budget_insertInitializer();
+      test_budget_insertRangeMove();
+      test_budget_constructRangeMove();
+      test_budget_constructInitializer();
+      test_budget_assignInitializerSame();
+      test_budget_assignInitializerShorter();
+      test_budget_assignInitializerLonger();
+      test_budget_assignCopy();
+      test_budget_copyMove();
+      test_budget_findErase();
 
       report("Set");
    }
@@ -387,6 +507,83 @@ public:
       teardownStandardFixture(s);
    }
 
+   /***************************************
+    * CONSTRUCTOR PARALLEL
+    ***************************************/
+
+   // bulk load nothing
+   void test_constructParallel_empty()
+   {  // setup
+      std::vector<int> v;
+      // exercise
+      custom::set <int> s(v.begin(), v.end(), 4);
+      // verify
+      assertUnit(s.bst.numElements == 0);
+      assertUnit(s.bst.root == nullptr);
+   }  // teardown
+
+   // bulk load shuffled values with duplicates into the standard shape
+   void test_constructParallel_standard()
+   {  // setup
+      std::vector<int> v{ 80, 20, 50, 40, 70, 30, 60, 20, 50, 80 };
+      // exercise
+      custom::set <int> s(v.begin(), v.end(), 4);
+      // verify
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      assertStandardFixture(s);
+      if (s.bst.root && s.bst.root->pLeft && s.bst.root->pRight)
+      {
+         assertUnit(s.bst.root->isRed == false);
+         assertUnit(s.bst.root->pLeft->isRed == false);
+         assertUnit(s.bst.root->pRight->isRed == false);
+         assertUnit(s.bst.root->pLeft->pLeft->isRed == true);
+         assertUnit(s.bst.root->pRight->pRight->isRed == true);
+      }
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // bulk load enough to use every thread; the result is in order and balanced
+   void test_constructParallel_large()
+   {  // setup
+      std::vector<int> v;
+      for (int i = 0; i < 10000; i++)
+         v.push_back((i * 7919) % 5000);
+      // exercise
+      custom::set <int> s(v.begin(), v.end(), 4);
+      // verify
+      assertUnit(s.size() == 5000);
+      int expected = 0;
+      bool inOrder = true;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         inOrder = inOrder && *it == expected++;
+      assertUnit(inOrder);
+      assertUnit(expected == 5000);
+      assertUnit(height(s.bst.root) <= 13);   // ceil(log2(5001))
+      assertUnit(parentsLinked(s.bst.root));
+   }  // teardown
+
+   // Spy counts what every thread did: one copy in, one move into each node
+   void test_constructParallel_spy()
+   {  // setup
+      std::vector<Spy> v;
+      for (int i = 0; i < 20000; i++)
+         v.push_back(Spy((i * 7919) % 20000));
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s(v.begin(), v.end(), 4);
+      // verify
+      assertUnit(s.size() == 20000);
+      assertUnit(Spy::numCopy() == 20000);
+      assertUnit(Spy::numAlloc() == 20000);
+      assertUnit(Spy::numCopyMove() >= 20000);
+      assertUnit(Spy::numLessthan() >= 20000);
+   }  // teardown
+
    /***************************************
     * CONSTRUCTOR INITIALIZE LIST
     ***************************************/
@@ -543,6 +740,184 @@ public:
       teardownStandardFixture(s);
    }
 
+   // a batch is relinked balanced and colored red-black
+   void test_stats_batch()
+   {  // setup
+      custom::set <int> s;
+      std::vector<int> values;
+      for (int i = 0; i < 100; i++)
+         values.push_back(i);
+      // exercise
+      s.insert_batch(values.begin(), values.end());
+      custom::tree_stats stats = s.stats();
+      // verify
+      assertUnit(stats.numNodes == 100);
+      assertUnit(stats.height == 7);
+      assertUnit(stats.isValid);
+      assertUnit(stats.isRedBlack);
+   }  // teardown
+
+   // inserting in order, one at a time, makes a chain
+   void test_stats_sorted()
+   {  // setup
+      custom::set <int> s;
+      // exercise
+      for (int i = 0; i < 100; i++)
+         s.insert(i);
+      custom::tree_stats stats = s.stats();
+      // verify
+      assertUnit(stats.numNodes == 100);
+      assertUnit(stats.height == 100);
+      assertUnit(stats.depthCounts == std::vector<size_t>(100, 1));
+      assertUnit(stats.isValid);
+      assertUnit(!stats.isRedBlack);
+   }  // teardown
+
+   /***************************************
+    * COUNTERS
+    *    set <T, set_counters> :: counters()
+    ***************************************/
+
+   // by default nothing is counted and nothing is added to the set
+   void test_counters_disabled()
+   {  // setup
+      custom::set <int> s;
+      // exercise
+      s.insert(50);
+      s.find(50);
+      // verify
+      assertUnit(s.counters().finds() == 0);
+      assertUnit(s.counters().inserts() == 0);
+      assertUnit(sizeof(custom::BST<int>) == sizeof(void *) + sizeof(size_t));
+      assertUnit(sizeof(custom::set<int, custom::set_counters>) ==
+                 sizeof(custom::set<int>) + 9 * sizeof(uint64_t));
+   }  // teardown
+
+   // finds and contains, hit or miss, and the comparisons they make
+   //                (50)
+   //          +-------+-------+
+   //        (30)            (70)
+   //     +----+----+     +----+----+
+   //   (20)       (40) (60)       (80)
+   void test_counters_find()
+   {  // setup
+      custom::set <int, custom::set_counters> s{ 50, 30, 70, 20, 40, 60, 80 };
+      s.counters_reset();
+      // exercise
+      s.find(40);        // == and < at 50 and 30, == at 40
+      s.find(45);        // == and < at 50, 30, and 40
+      s.contains(80);    // < at 50, 70, and 80, then < to confirm
+      // verify
+      assertUnit(s.counters().finds() == 3);
+      assertUnit(s.counters().hits() == 2);
+      assertUnit(s.counters().misses() == 1);
+      assertUnit(s.counters().comparisons() == 15);
+      assertUnit(s.counters().inserts() == 0);
+      assertUnit(s.counters().allocations() == 0);
+   }  // teardown
+
+   // a duplicate is counted and allocates nothing
+   void test_counters_insert()
+   {  // setup
+      custom::set <int, custom::set_counters> s;
+      // exercise
+      s.insert(50);      // an empty tree: no comparison
+      s.insert(30);      // == and < at 50
+      s.insert(30);      // == and < at 50, == at 30
+      // verify
+      assertUnit(s.counters().inserts() == 3);
+      assertUnit(s.counters().duplicates() == 1);
+      assertUnit(s.counters().allocations() == 2);
+      assertUnit(s.counters().comparisons() == 5);
+      assertUnit(s.counters().finds() == 0);
+      assertUnit(s.counters().rotations() == 0);
+   }  // teardown
+
+   // erases count the elements removed; erasing by key is not also a find
+   void test_counters_erase()
+   {  // setup
+      custom::set <int, custom::set_counters> s{ 50, 30, 70, 20, 40, 60, 80 };
+      s.counters_reset();
+      // exercise
+      s.erase(30);
+      s.erase(99);
+      s.erase_range(60, 90);
+      custom::erase_if(s, [](int value) { return value == 20; });
+      // verify
+      assertUnit(s.counters().erases() == 5);
+      assertUnit(s.counters().finds() == 0);
+      assertUnit(s.size() == 2);
+   }  // teardown
+
+   // a batch counts its duplicates; new nodes taking their first
+   // color are not recolorings
+   void test_counters_batch()
+   {  // setup
+      custom::set <int, custom::set_counters> s;
+      // exercise
+      s.insert_batch({ 3, 1, 2, 2 });
+      // verify
+      assertUnit(s.counters().inserts() == 4);
+      assertUnit(s.counters().duplicates() == 1);
+      assertUnit(s.counters().allocations() == 3);
+      assertUnit(s.counters().recolorings() == 0);   // 1 and 3 are new, red from the start
+      assertUnit(s.stats().isRedBlack);
+   }  // teardown
+
+   // relinking counts the old nodes whose color changed
+   //        (40b)                      (30b)
+   //     +----+----+       ->     +-----+-----+
+   //   (20b)     (60b)          (15b)       (50b)
+   //                          +--+--+     +--+--+
+   //                        (10r) (20r) (40r) (60r)
+   void test_counters_batchRecolors()
+   {  // setup
+      custom::set <int, custom::set_counters> s;
+      s.insert(40);
+      s.insert(20);
+      s.insert(60);
+      assertUnit(s.bst.root && s.bst.root->pLeft && !s.bst.root->pLeft->isRed);
+      s.counters_reset();
+      // exercise
+      s.insert_batch({ 10, 15, 30, 50 });
+      // verify
+      assertUnit(s.counters().recolorings() == 3);   // 20, 40, and 60 turn red
+      assertUnit(s.size() == 7);
+      assertUnit(s.stats().isRedBlack);
+   }  // teardown
+
+   // a relinked batch counts the comparisons of its walk and merge
+   void test_counters_batchCompares()
+   {  // setup
+      custom::set <int, custom::set_counters> s{ 20, 40 };
+      s.counters_reset();
+      // exercise
+      s.insert_batch({ 50, 10, 40, 30 });
+      // verify
+      //   walk:  10 at 20 (2), 30 at 20 and 40 (3), 40 at 40 (2), 50 at 40 (1)
+      //   merge: 20 against 10 and 30, 40 against 30 and 50
+      assertUnit(s.counters().comparisons() == 12);
+      assertUnit(s.counters().inserts() == 4);
+      assertUnit(s.counters().duplicates() == 1);
+      assertUnit(s.size() == 5);
+   }  // teardown
+
+   // the counters belong to the object: a copy starts over
+   void test_counters_copy()
+   {  // setup
+      custom::set <int, custom::set_counters> sSrc{ 50, 30, 70 };
+      sSrc.find(30);
+      // exercise
+      custom::set <int, custom::set_counters> sCopy(sSrc);
+      sCopy.find(70);
+      // verify
+      assertUnit(sSrc.counters().finds() == 1);
+      assertUnit(sSrc.counters().inserts() == 3);
+      assertUnit(sCopy.counters().finds() == 1);
+      assertUnit(sCopy.counters().inserts() == 0);
+      assertUnit(sCopy.counters().allocations() == 3);   // the copy's own nodes
+   }  // teardown
+
 
    /***************************************
     * Assignment
@@ -1516,6 +1891,140 @@ public:
    }
 
 
+   /***************************************
+    * FIND BATCH
+    *  set::find_batch(first, last, out)
+    *  set::contains_batch(first, last, out)
+    ***************************************/
+
+   // every key of a batch misses an empty set
+   void test_findBatch_empty()
+   {  // setup
+      custom::set <int> s;
+      std::vector<int> keys{ 50, 30 };
+      std::vector<custom::set<int>::iterator> results;
+      // exercise
+      s.find_batch(keys.begin(), keys.end(), std::back_inserter(results));
+      // verify
+      assertUnit(results.size() == 2);
+      for (auto & it : results)
+         assertUnit(it == s.end());
+   }  // teardown
+
+   // hits and misses come back in the order of the keys
+   void test_findBatch_standard()
+   {  // setup
+      //                 50 
+      //          +-------+-------+
+      //         30              70  
+      //     +----+----+     +----+----+
+      //    20        40    60        80  
+      custom::set <int> s;
+      setupStandardFixture(s);
+      std::vector<int> keys{ 40, 99, 20, 50, 10 };
+      std::vector<custom::set<int>::iterator> results;
+      // exercise
+      s.find_batch(keys.begin(), keys.end(), std::back_inserter(results));
+      // verify
+      assertUnit(results.size() == 5);
+      if (results.size() == 5)
+      {
+         assertUnit(results[0] == s.find(40));
+         assertUnit(results[1] == s.end());
+         assertUnit(results[2] == s.find(20));
+         assertUnit(results[3] == s.find(50));
+         assertUnit(results[4] == s.end());
+      }
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // more keys than descend together in one group
+   void test_findBatch_manyKeys()
+   {  // setup
+      custom::set <int> s;
+      for (int i = 0; i < 100; i += 2)
+         s.insert(i);
+      std::vector<int> keys;
+      for (int i = 99; i >= 0; i--)
+         keys.push_back(i);
+      std::vector<custom::set<int>::iterator> results;
+      // exercise
+      s.find_batch(keys.begin(), keys.end(), std::back_inserter(results));
+      // verify
+      assertUnit(results.size() == keys.size());
+      bool allMatch = true;
+      for (size_t i = 0; i < results.size(); i++)
+         allMatch = allMatch && results[i] == s.find(keys[i]);
+      assertUnit(allMatch);
+   }  // teardown
+
+   // contains answers the same questions with a bool
+   void test_containsBatch_standard()
+   {  // setup
+      custom::set <int> s;
+      setupStandardFixture(s);
+      std::vector<int> keys{ 40, 99, 80, 10 };
+      bool results[4] = { false, true, false, true };
+      // exercise
+      bool * pEnd = s.contains_batch(keys.begin(), keys.end(), results);
+      // verify
+      assertUnit(pEnd == results + 4);
+      assertUnit(results[0] == true);
+      assertUnit(results[1] == false);
+      assertUnit(results[2] == true);
+      assertUnit(results[3] == false);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // with a hash index every key is a probe, not a descent
+   void test_findBatch_indexed()
+   {  // setup
+      custom::set <int, custom::set_counters> s{ 50, 30, 70, 20, 40, 60, 80 };
+      s.hash_indexed(true);
+      s.counters_reset();
+      std::vector<int> keys{ 40, 99, 20, 50, 10 };
+      std::vector<custom::set<int, custom::set_counters>::iterator> results;
+      // exercise
+      s.find_batch(keys.begin(), keys.end(), std::back_inserter(results));
+      // verify
+      assertUnit(s.counters().comparisons() == 0);
+      assertUnit(s.counters().hits() == 3);
+      assertUnit(s.counters().misses() == 2);
+      assertUnit(results.size() == 5);
+      if (results.size() == 5)
+      {
+         assertUnit(results[0] != s.end() && *results[0] == 40);
+         assertUnit(results[1] == s.end());
+         assertUnit(results[2] != s.end() && *results[2] == 20);
+         assertUnit(results[3] != s.end() && *results[3] == 50);
+         assertUnit(results[4] == s.end());
+      }
+   }  // teardown
+
+   // as find_batch, contains_batch only probes the index
+   void test_containsBatch_indexed()
+   {  // setup
+      custom::set <int, custom::set_counters> s{ 50, 30, 70, 20, 40, 60, 80 };
+      s.hash_indexed(true);
+      s.counters_reset();
+      std::vector<int> keys{ 40, 99, 80, 10 };
+      bool results[4] = { false, true, false, true };
+      // exercise
+      bool * pEnd = s.contains_batch(keys.begin(), keys.end(), results);
+      // verify
+      assertUnit(pEnd == results + 4);
+      assertUnit(results[0] == true);
+      assertUnit(results[1] == false);
+      assertUnit(results[2] == true);
+      assertUnit(results[3] == false);
+      assertUnit(s.counters().comparisons() == 0);
+      assertUnit(s.counters().finds() == 4);
+   }  // teardown
+
+
    /***************************************
     * INSERT
     *  set::insert(const T &)
@@ -1947,6 +2456,87 @@ public:
    }
 
 
+   /***************************************
+    * INSERT BATCH
+    *    set::insert_batch(first, last)
+    ***************************************/
+
+   // insert batch: {}.insert_batch(shuffled, with duplicates)
+   void test_insertBatch_emptyInsertMany()
+   {  // setup
+      custom::set <int> s;
+      std::vector<int> v{ 60, 20, 80, 50, 30, 20, 40, 70, 60 };
+      // exercise
+      s.insert_batch(v.begin(), v.end());
+      // verify
+      //                (50b) = s
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // insert batch: standard.insert_batch({50, 40}) changes nothing
+   void test_insertBatch_standardInsertDuplicates()
+   {  // setup
+      //                (50b) = s
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <int> s;
+      setupStandardFixture(s);
+      custom::BST <int>::BNode * p40 = s.bst.root->pLeft->pRight;
+      // exercise
+      s.insert_batch({ int(50), int(40) });
+      // verify
+      assertStandardFixture(s);
+      assertUnit(s.bst.root->pLeft->pRight == p40);   // relinked, not copied
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // insert batch: the batch is merged and the whole tree rebalanced
+   void test_insertBatch_manyInsertMany()
+   {  // setup
+      //                (50b) = s
+      //          +-------+-------+
+      //        (30b)           (70b)
+      custom::set <int> s{ int(50), int(30), int(70) };
+      std::vector<int> v{ int(80), int(20), int(60), int(40), int(80) };
+      // exercise
+      s.insert_batch(v.begin(), v.end());
+      // verify
+      //                (50b) = s
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // insert batch: a couple of elements into a big set, one at a time
+   void test_insertBatch_largeInsertFew()
+   {  // setup
+      custom::set <int> s;
+      for (int i = 0; i < 1000; i += 2)
+         s.insert(i);
+      custom::BST <int>::BNode * pRoot = s.bst.root;
+      // exercise
+      s.insert_batch({ int(501), int(3) });
+      // verify
+      assertUnit(s.size() == 502);
+      assertUnit(s.bst.root == pRoot);   // no rebuild
+      assertUnit(s.find(501) != s.end());
+      assertUnit(s.find(3) != s.end());
+   }  // teardown
+
+
    /***************************************
     * Erase Range
     *    set::erase(itBegin, itBEnd)
@@ -2577,47 +3167,1381 @@ public:
 
    }
 
-   /*************************************************************
-    * SETUP STANDARD FIXTURE
-    *                (50b)
-    *          +-------+-------+
-    *        (30b)           (70b)
-    *     +----+----+     +----+----+
-    *   (20r)     (40r) (60r)     (80r)
-    *************************************************************/
-   void setupStandardFixture(custom::set<int>& s)
-   {
-      // make sure that bst is clean
-      assertUnit(s.bst.numElements == 0);
-      assertUnit(s.bst.root == nullptr);
-
-      // allocate
-      custom::BST<int>::BNode* p20 = new custom::BST<int>::BNode(int(20));
-      custom::BST<int>::BNode* p30 = new custom::BST<int>::BNode(int(30));
-      custom::BST<int>::BNode* p40 = new custom::BST<int>::BNode(int(40));
-      custom::BST<int>::BNode* p50 = new custom::BST<int>::BNode(int(50));
-      custom::BST<int>::BNode* p60 = new custom::BST<int>::BNode(int(60));
-      custom::BST<int>::BNode* p70 = new custom::BST<int>::BNode(int(70));
-      custom::BST<int>::BNode* p80 = new custom::BST<int>::BNode(int(80));
-
-      // hook up the pointers down
-      p30->pLeft = p20;
-      p30->pRight = p40;
-      p50->pLeft = p30;
-      p50->pRight = p70;
-      p70->pLeft = p60;
-      p70->pRight = p80;
-
-      // hook up the pointers up
-      p20->pParent = p40->pParent = p30;
-      p30->pParent = p70->pParent = p50;
-      p60->pParent = p80->pParent = p70;
-
-      // color everything
+   /***************************************
+    * ERASE RANGE OF KEYS
+    *    set::erase_range(lo, hi)
+    ***************************************/
 
-      // now assign everything to the bst
-      s.bst.root = p50;
-      s.bst.numElements = 7;
+   // a window with nothing in it leaves the set alone
+   void test_eraseKeys_standardNone()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <int> s;
+      setupStandardFixture(s);
+      // exercise
+      size_t num = s.erase_range(41, 50);
+      // verify
+      assertUnit(num == 0);
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // [30, 61) takes the root and parts of both sides
+   void test_eraseKeys_standardMiddle()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <int> s;
+      setupStandardFixture(s);
+      // exercise
+      size_t num = s.erase_range(30, 61);
+      // verify
+      //        (20)
+      //          +----+
+      //              (70)
+      //                +----+
+      //                    (80)
+      assertUnit(num == 4);
+      assertUnit(s.size() == 3);
+      assertUnit(s.bst.root != nullptr);
+      if (s.bst.root)
+      {
+         assertUnit(s.bst.root->data == 20);
+         assertUnit(s.bst.root->pParent == nullptr);
+         assertUnit(s.bst.root->pLeft == nullptr);
+         assertUnit(s.bst.root->pRight != nullptr);
+         if (s.bst.root->pRight)
+         {
+            assertUnit(s.bst.root->pRight->data == 70);
+            assertUnit(s.bst.root->pRight->pLeft == nullptr);
+            assertUnit(s.bst.root->pRight->pRight != nullptr);
+         }
+      }
+      assertUnit(parentsLinked(s.bst.root));
+   }  // teardown
+
+   // a window around everything empties the set
+   void test_eraseKeys_standardAll()
+   {  // setup
+      custom::set <int> s;
+      setupStandardFixture(s);
+      // exercise
+      size_t num = s.erase_range(0, 100);
+      // verify
+      assertUnit(num == 7);
+      assertUnit(s.bst.root == nullptr);
+      assertUnit(s.bst.numElements == 0);
+   }  // teardown
+
+   // expire a window out of the middle of a big set
+   void test_eraseKeys_largeWindow()
+   {  // setup
+      std::vector<int> v;
+      for (int i = 0; i < 1000; i++)
+         v.push_back(i);
+      custom::set <int> s(v.begin(), v.end(), 1);
+      // exercise
+      size_t num = s.erase_range(100, 900);
+      // verify
+      assertUnit(num == 800);
+      assertUnit(s.size() == 200);
+      std::vector<int> remaining;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         remaining.push_back(*it);
+      bool inOrder = remaining.size() == 200;
+      for (size_t i = 0; inOrder && i < 200; i++)
+         inOrder = remaining[i] == (int)(i < 100 ? i : i + 800);
+      assertUnit(inOrder);
+      assertUnit(parentsLinked(s.bst.root));
+   }  // teardown
+
+   /***************************************
+    * ERASE IF
+    *    custom::erase_if(set, pred)
+    ***************************************/
+
+   // nothing matches, nothing moves
+   void test_eraseIf_standardNone()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <int> s;
+      setupStandardFixture(s);
+      int numCalls = 0;
+      // exercise
+      size_t num = custom::erase_if(s, [&numCalls](int value)
+      {
+         numCalls++;
+         return value > 100;
+      });
+      // verify
+      assertUnit(num == 0);
+      assertUnit(numCalls == 7);
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // everything matches
+   void test_eraseIf_standardAll()
+   {  // setup
+      custom::set <int> s;
+      setupStandardFixture(s);
+      // exercise
+      size_t num = custom::erase_if(s, [](int value) { return value < 100; });
+      // verify
+      assertUnit(num == 7);
+      assertUnit(s.bst.root == nullptr);
+      assertUnit(s.bst.numElements == 0);
+   }  // teardown
+
+   // a few matches are erased one at a time, the rest stay put
+   void test_eraseIf_largeFew()
+   {  // setup
+      std::vector<int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      custom::set <int> s(v.begin(), v.end(), 1);
+      custom::BST <int>::BNode * p1 = s.bst.root->pLeft;
+      // exercise
+      size_t num = custom::erase_if(s, [](int value) { return value % 10 == 7; });
+      // verify
+      assertUnit(num == 10);
+      assertUnit(s.size() == 90);
+      assertUnit(s.bst.root->pLeft == p1);    // no rebuild
+      assertUnit(s.find(17) == s.end());
+      assertUnit(s.find(18) != s.end());
+      assertUnit(parentsLinked(s.bst.root));
+   }  // teardown
+
+   // most match, so the survivors are rebuilt balanced
+   void test_eraseIf_largeMany()
+   {  // setup
+      custom::set <int> s;
+      for (int i = 0; i < 1000; i++)
+         s.insert(i);                         // one long chain
+      // exercise
+      size_t num = custom::erase_if(s, [](int value) { return value % 4 != 0; });
+      // verify
+      assertUnit(num == 750);
+      assertUnit(s.size() == 250);
+      int expected = 0;
+      bool inOrder = true;
+      for (auto it = s.begin(); it != s.end(); ++it, expected += 4)
+         inOrder = inOrder && *it == expected;
+      assertUnit(inOrder);
+      assertUnit(expected == 1000);
+      assertUnit(height(s.bst.root) <= 8);    // ceil(log2(251))
+      assertUnit(parentsLinked(s.bst.root));
+   }  // teardown
+
+   /***************************************
+    * SERIALIZE
+    *    set::serialize(ostream)
+    *    set::deserialize(istream)
+    ***************************************/
+
+   // nothing in, nothing out
+   void test_serialize_empty()
+   {  // setup
+      custom::set <int> sSrc;
+      custom::set <int> sDest{ 1, 2 };
+      std::stringstream stream;
+      // exercise
+      sSrc.serialize(stream);
+      bool isRead = sDest.deserialize(stream);
+      // verify
+      assertUnit(isRead);
+      assertUnit(stream.str().size() == 1);   // the count
+      assertUnit(sDest.bst.root == nullptr);
+      assertUnit(sDest.bst.numElements == 0);
+   }  // teardown
+
+   // the elements come back as a balanced tree
+   void test_serialize_standard()
+   {  // setup
+      custom::set <int> sSrc{ 20, 30, 40, 50, 60, 70, 80 };   // a chain
+      custom::set <int> sDest;
+      std::stringstream stream;
+      // exercise
+      sSrc.serialize(stream);
+      bool isRead = sDest.deserialize(stream);
+      // verify
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      assertUnit(isRead);
+      assertStandardFixture(sDest);
+      // teardown
+      teardownStandardFixture(sDest);
+   }
+
+   // consecutive integers take a byte each
+   void test_serialize_denseIsSmall()
+   {  // setup
+      custom::set <uint64_t> s;
+      for (uint64_t i = 1000000; i < 1001000; i++)
+         s.insert(i);
+      std::stringstream stream;
+      // exercise
+      s.serialize(stream);
+      // verify
+      assertUnit(stream.str().size() == 2 + 3 + 999);   // count, first, gaps
+   }  // teardown
+
+   // negative numbers survive the gaps
+   void test_serialize_negative()
+   {  // setup
+      custom::set <int> sSrc{ -2000000000, -5, 0, 7, 2000000000 };
+      custom::set <int> sDest;
+      std::stringstream stream;
+      // exercise
+      sSrc.serialize(stream);
+      bool isRead = sDest.deserialize(stream);
+      // verify
+      assertUnit(isRead);
+      std::vector<int> v = contents(sDest);
+      assertUnit(v == std::vector<int>({ -2000000000, -5, 0, 7, 2000000000 }));
+   }  // teardown
+
+   // strings are length-prefixed, so they may hold anything
+   void test_serialize_strings()
+   {  // setup
+      custom::set <std::string> sSrc{ "", "b", std::string("a\0z", 3), "long string" };
+      custom::set <std::string> sDest;
+      std::stringstream stream;
+      // exercise
+      sSrc.serialize(stream);
+      bool isRead = sDest.deserialize(stream);
+      // verify
+      assertUnit(isRead);
+      assertUnit(contents(sDest) == contents(sSrc));
+      assertUnit(sDest.size() == 4);
+   }  // teardown
+
+   // a stream cut short leaves an empty set
+   void test_deserialize_truncated()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70, 20, 40, 60, 80 };
+      custom::set <int> sDest{ 1, 2 };
+      std::stringstream stream;
+      sSrc.serialize(stream);
+      std::string bytes = stream.str();
+      std::stringstream streamShort(bytes.substr(0, bytes.size() - 2));
+      // exercise
+      bool isRead = sDest.deserialize(streamShort);
+      // verify
+      assertUnit(!isRead);
+      assertUnit(sDest.empty());
+      assertUnit(sDest.bst.root == nullptr);
+   }  // teardown
+
+   // a stream that is not in order is rejected
+   void test_deserialize_outOfOrder()
+   {  // setup
+      custom::set <std::string> sDest;
+      std::stringstream stream;
+      custom::writeVarint(stream, 2);
+      custom::serializer<std::string>().write(stream, "b");
+      custom::serializer<std::string>().write(stream, "a");
+      // exercise
+      bool isRead = sDest.deserialize(stream);
+      // verify
+      assertUnit(!isRead);
+      assertUnit(sDest.empty());
+   }  // teardown
+
+   /***************************************
+    * HASH INDEX
+    ***************************************/
+
+   // turning the index on indexes every node already there
+   void test_hashIndexed_enableStandard()
+   {  // setup
+      custom::set <int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      s.hash_indexed(true);
+      // verify
+      assertUnit(s.hash_indexed());
+      assertUnit(indexMatches(s));
+      auto it = s.find(40);
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(it.it.pNode == s.bst.root->pLeft->pRight);
+      assertUnit(s.find(45) == s.end());
+      assertUnit(s.contains(80));
+      assertUnit(!s.contains(10));
+   }  // teardown
+
+   // turning it off frees it and the tree answers again
+   void test_hashIndexed_disable()
+   {  // setup
+      custom::set <int> s{ 50, 30, 70 };
+      s.hash_indexed(true);
+      // exercise
+      s.hash_indexed(false);
+      // verify
+      assertUnit(!s.hash_indexed());
+      assertUnit(s.pIndex == nullptr);
+      assertUnit(s.contains(30));
+      assertUnit(s.find(70) != s.end());
+   }  // teardown
+
+   // inserts and erases in any order keep the index in step
+   void test_hashIndexed_insertErase()
+   {  // setup
+      custom::set <int> s;
+      s.hash_indexed(true);
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         s.insert((i * 7919) % 1000);
+      for (int i = 0; i < 1000; i += 3)
+         s.erase((i * 7919) % 1000);
+      // verify
+      assertUnit(s.size() == 666);
+      assertUnit(indexMatches(s));
+      bool isCorrect = true;
+      for (int i = 0; i < 1000; i++)
+         isCorrect = isCorrect && s.contains((i * 7919) % 1000) == (i % 3 != 0);
+      assertUnit(isCorrect);
+      s.clear();
+      assertUnit(s.pIndex->size() == 0);
+   }  // teardown
+
+   // the index answers a duplicate without a descent
+   void test_hashIndexed_insertDuplicate()
+   {  // setup
+      custom::set <int> s{ 50, 30, 70 };
+      s.hash_indexed(true);
+      // exercise
+      auto result = s.insert(30);
+      // verify
+      assertUnit(!result.second);
+      assertUnit(result.first.it.pNode == s.bst.root->pLeft);
+      assertUnit(s.size() == 3);
+      assertUnit(indexMatches(s));
+   }  // teardown
+
+   // both ways of batch inserting index the new nodes
+   void test_hashIndexed_insertBatch()
+   {  // setup
+      std::vector<int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i * 2);
+      custom::set <int> s(v.begin(), v.end(), 1);
+      s.hash_indexed(true);
+      // exercise
+      s.insert_batch({ 1, 3, 5 });              // one at a time
+      std::vector<int> odd;
+      for (int i = 0; i < 100; i++)
+         odd.push_back(i * 2 + 1);
+      s.insert_batch(odd.begin(), odd.end());   // relinked
+      // verify
+      assertUnit(s.size() == 200);
+      assertUnit(indexMatches(s));
+   }  // teardown
+
+   // a range erase takes its keys out of the index
+   void test_hashIndexed_eraseRange()
+   {  // setup
+      custom::set <int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      s.hash_indexed(true);
+      // exercise
+      size_t num = s.erase_range(30, 65);
+      // verify
+      assertUnit(num == 4);
+      assertUnit(indexMatches(s));
+      assertUnit(!s.contains(40));
+      assertUnit(s.contains(70));
+   }  // teardown
+
+   // erase_if keeps the index whether it rebuilds the tree or not
+   void test_hashIndexed_eraseIf()
+   {  // setup
+      std::vector<int> v;
+      for (int i = 0; i < 100; i++)
+         v.push_back(i);
+      custom::set <int> s(v.begin(), v.end(), 1);
+      s.hash_indexed(true);
+      // exercise
+      custom::erase_if(s, [](int value) { return value % 10 == 7; });
+      assertUnit(indexMatches(s));
+      custom::erase_if(s, [](int value) { return value % 2 == 0; });
+      // verify
+      assertUnit(s.size() == 40);
+      assertUnit(indexMatches(s));
+      assertUnit(!s.contains(17));
+      assertUnit(s.contains(19));
+   }  // teardown
+
+   // a copy indexes its own nodes, not the original's
+   void test_hashIndexed_copy()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      sSrc.hash_indexed(true);
+      // exercise
+      custom::set <int> sDest(sSrc);
+      // verify
+      assertUnit(sDest.hash_indexed());
+      assertUnit(indexMatches(sDest));
+      assertUnit(sDest.find(30).it.pNode != sSrc.find(30).it.pNode);
+   }  // teardown
+
+   // the copy that clones the shared nodes re-indexes them
+   void test_hashIndexed_copyOnWriteDetach()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      sSrc.copy_on_write(true);
+      sSrc.hash_indexed(true);
+      custom::set <int> sDest(sSrc);
+      assertUnit(sDest.find(30).it.pNode == sSrc.find(30).it.pNode);
+      // exercise
+      sDest.insert(40);
+      // verify
+      assertUnit(indexMatches(sSrc));
+      assertUnit(indexMatches(sDest));
+      assertUnit(sDest.find(30).it.pNode != sSrc.find(30).it.pNode);
+      assertUnit(!sSrc.contains(40));
+   }  // teardown
+
+#ifdef SET_LATENCY
+   /***************************************
+    * LATENCY
+    ***************************************/
+
+   // every insert is timed, a duplicate included
+   void test_latency_insert()
+   {  // setup
+      custom::set <int> s;
+      // exercise
+      s.insert(50);
+      s.insert(30);
+      s.insert(50);
+      // verify
+      assertUnit(s.latency(custom::set<int>::LATENCY_INSERT).count() == 3);
+      assertUnit(s.latency(custom::set<int>::LATENCY_ERASE).empty());
+      assertUnit(s.latency(custom::set<int>::LATENCY_FIND).empty());
+      assertUnit(s.latency(custom::set<int>::LATENCY_INSERT).max() >=
+                 s.latency(custom::set<int>::LATENCY_INSERT).min());
+   }  // teardown
+
+   // erasing by key finds the node, but counts as one erase and no find
+   void test_latency_eraseOnce()
+   {  // setup
+      custom::set <int> s{ 50, 30, 70 };
+      s.latency_clear();
+      // exercise
+      size_t numErased = s.erase(30);
+      numErased += s.erase(99);
+      // verify
+      assertUnit(numErased == 1);
+      assertUnit(s.latency(custom::set<int>::LATENCY_ERASE).count() == 2);
+      assertUnit(s.latency(custom::set<int>::LATENCY_FIND).empty());
+      assertUnit(s.latency(custom::set<int>::LATENCY_INSERT).empty());
+   }  // teardown
+
+   // hits and misses alike, and contains on a const set
+   void test_latency_find()
+   {  // setup
+      custom::set <int> s{ 50, 30, 70 };
+      const custom::set <int> & sConst = s;
+      // exercise
+      bool isFound = s.find(30) != s.end();
+      isFound = s.find(99) != s.end() || isFound;
+      isFound = sConst.contains(70) && isFound;
+      // verify
+      assertUnit(isFound);
+      assertUnit(s.latency(custom::set<int>::LATENCY_FIND).count() == 3);
+      assertUnit(s.latency(custom::set<int>::LATENCY_FIND).percentile(50.0) <=
+                 s.latency(custom::set<int>::LATENCY_FIND).max());
+   }  // teardown
+
+   // a batch or range call is one sample
+   void test_latency_batch()
+   {  // setup
+      custom::set <int> s;
+      std::vector<int> keys = { 30, 99, 50 };
+      std::vector<custom::set <int>::iterator> found;
+      bool isFound[3];
+      // exercise
+      s.insert_batch({ 50, 30, 70, 20 });
+      s.find_batch(keys.begin(), keys.end(), std::back_inserter(found));
+      s.contains_batch(keys.begin(), keys.end(), isFound);
+      s.erase_range(25, 55);
+      custom::erase_if(s, [](int value) { return value > 60; });
+      // verify
+      assertUnit(s.latency(custom::set<int>::LATENCY_INSERT).count() == 1);
+      assertUnit(s.latency(custom::set<int>::LATENCY_FIND).count() == 2);
+      assertUnit(s.latency(custom::set<int>::LATENCY_ERASE).count() == 2);
+      assertUnit(s.size() == 1);
+   }  // teardown
+
+   // copy-assign is timed in the set assigned to
+   void test_latency_copyAssign()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      custom::set <int> sDest;
+      // exercise
+      sDest = sSrc;
+      // verify
+      assertUnit(sDest.latency(custom::set<int>::LATENCY_ASSIGN).count() == 1);
+      assertUnit(sSrc.latency(custom::set<int>::LATENCY_ASSIGN).empty());
+   }  // teardown
+
+   // a copy starts with no history of its own, and a swap keeps each
+   void test_latency_stayWithObject()
+   {  // setup
+      custom::set <int> sSrc;
+      sSrc.insert(50);
+      sSrc.insert(30);
+      custom::set <int> sOther;
+      sOther.insert(10);
+      // exercise
+      custom::set <int> sCopy(sSrc);
+      sSrc.swap(sOther);
+      // verify
+      assertUnit(sCopy.latency(custom::set<int>::LATENCY_INSERT).empty());
+      assertUnit(sSrc.latency(custom::set<int>::LATENCY_INSERT).count() == 2);
+      assertUnit(sOther.latency(custom::set<int>::LATENCY_INSERT).count() == 1);
+   }  // teardown
+#endif // SET_LATENCY
+
+   /***************************************
+    * COPY ON WRITE
+    ***************************************/
+
+   // a copy of a copy-on-write set points at the same nodes
+   void test_cow_copyShares()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <int> sSrc;
+      setupStandardFixture(sSrc);
+      sSrc.copy_on_write(true);
+      // exercise
+      custom::set <int> sDest(sSrc);
+      // verify
+      assertUnit(sDest.bst.root == sSrc.bst.root);
+      assertUnit(sDest.pShared == sSrc.pShared);
+      assertUnit(sSrc.pShared.use_count() == 2);
+      assertUnit(sDest.copy_on_write());
+      assertStandardFixture(sSrc);
+      assertStandardFixture(sDest);
+   }  // teardown
+
+   // read-only copies never touch the elements
+   void test_cow_copyAllocatesNothing()
+   {  // setup
+      custom::set <Spy> sSrc{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40) };
+      sSrc.copy_on_write(true);
+      Spy::reset();
+      // exercise
+      {
+         custom::set <Spy> sCopy1(sSrc);
+         custom::set <Spy> sCopy2(sCopy1);
+         custom::set <Spy> sCopy3;
+         sCopy3 = sCopy2;
+         size_t count = 0;
+         for (auto it = sCopy3.begin(); it != sCopy3.end(); ++it)
+            count++;
+         // verify
+         assertUnit(count == 5);
+         assertUnit(sCopy3.find(Spy(40)) != sCopy3.end());
+      }
+      assertUnit(Spy::numAlloc() == 1);       // the Spy(40) key
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(sSrc.size() == 5);
+   }  // teardown
+
+   // assignment from a copy-on-write set drops our nodes and shares
+   void test_cow_assignShares()
+   {  // setup
+      custom::set <int> sSrc;
+      setupStandardFixture(sSrc);
+      sSrc.copy_on_write(true);
+      custom::set <int> sDest{ 1, 2, 3 };
+      // exercise
+      sDest = sSrc;
+      // verify
+      assertUnit(sDest.bst.root == sSrc.bst.root);
+      assertStandardFixture(sDest);
+      assertStandardFixture(sSrc);
+   }  // teardown
+
+   // the first insert into a copy clones it, the source is untouched
+   void test_cow_insertDetaches()
+   {  // setup
+      custom::set <Spy> sSrc{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40) };
+      sSrc.copy_on_write(true);
+      custom::set <Spy> sDest(sSrc);
+      Spy s(60);
+      Spy::reset();
+      // exercise
+      auto pairSet = sDest.insert(s);
+      // verify
+      assertUnit(pairSet.second == true);
+      assertUnit(Spy::numCopy() == 6);        // clone [20][30][40][50][70], copy [60]
+      assertUnit(Spy::numAlloc() == 6);
+      assertUnit(sDest.bst.root != sSrc.bst.root);
+      assertUnit(sDest.pShared.use_count() == 1);  // a fresh owner of the clone
+      assertUnit(sDest.pShared->root == sDest.bst.root);
+      assertUnit(sSrc.pShared.use_count() == 1);
+      assertUnit(sDest.size() == 6);
+      assertUnit(sSrc.size() == 5);
+      assertUnit(sSrc.find(Spy(60)) == sSrc.end());
+   }  // teardown
+
+   // a copy shares and indexes because its source does
+   void test_cow_copyTakesModes()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      sSrc.copy_on_write(true);
+      sSrc.hash_indexed(true);
+      // exercise
+      custom::set <int> sDest(sSrc);
+      // verify
+      assertUnit(sDest.copy_on_write());
+      assertUnit(sDest.hash_indexed());
+      assertUnit(sDest.bst.root == sSrc.bst.root);
+      assertUnit(sDest.contains(30));
+   }  // teardown
+
+   // assignment takes the modes of the source, as a copy does
+   void test_cow_assignTakesModes()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      sSrc.copy_on_write(true);
+      sSrc.hash_indexed(true);
+      custom::set <int> sDest{ 99 };
+      // exercise
+      sDest = sSrc;
+      // verify
+      assertUnit(sDest.copy_on_write());
+      assertUnit(sDest.hash_indexed());
+      assertUnit(sDest.bst.root == sSrc.bst.root);
+      assertUnit(sDest.contains(30));
+      assertUnit(!sDest.contains(99));
+      assertUnit(indexMatches(sDest));
+   }  // teardown
+
+   // assignment from a plain set leaves a plain set
+   void test_cow_assignDropsModes()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      custom::set <int> sDest{ 99 };
+      sDest.copy_on_write(true);
+      sDest.hash_indexed(true);
+      // exercise
+      sDest = sSrc;
+      // verify
+      assertUnit(!sDest.copy_on_write());
+      assertUnit(!sDest.hash_indexed());
+      assertUnit(sDest.bst.root != sSrc.bst.root);
+      assertUnit(sDest.size() == 3);
+   }  // teardown
+
+   // the set written to clones, so its old iterators now point into
+   // the nodes its copy kept
+   void test_cow_writeInvalidatesIterators()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      sSrc.copy_on_write(true);
+      auto it = sSrc.find(30);
+      custom::set <int> sCopy(sSrc);
+      // exercise
+      sSrc.insert(60);
+      // verify
+      assertUnit(sSrc.find(30) != it);
+      assertUnit(sCopy.find(30) == it);
+      assertUnit(sSrc.bst.root != sCopy.bst.root);
+   }  // teardown
+
+   // turning the mode on puts the nodes in a shared owner at once
+   void test_cow_enableMakesOwner()
+   {  // setup
+      custom::set <int> s{ 50, 30, 70 };
+      // exercise
+      s.copy_on_write(true);
+      // verify
+      assertUnit(s.pShared.use_count() == 1);
+      assertUnit(s.pShared->root == s.bst.root);
+      assertUnit(s.pShared->numElements == 3);
+   }  // teardown
+
+   // turning the mode off takes the nodes back from an unshared owner
+   void test_cow_disableTakesBack()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70) };
+      s.copy_on_write(true);
+      Spy::reset();
+      // exercise
+      s.copy_on_write(false);
+      // verify
+      assertUnit(s.pShared == nullptr);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(s.size() == 3);
+      assertUnit(s.contains(Spy(30)));
+   }  // teardown
+
+   // a copy leaves its const source exactly as it was
+   void test_cow_copyOnlyReads()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70 };
+      sSrc.copy_on_write(true);
+      const custom::set <int> & sConst = sSrc;
+      custom::BST <int> * pOwner = sSrc.pShared.get();
+      // exercise
+      custom::set <int> sDest(sConst);
+      // verify
+      assertUnit(sSrc.pShared.get() == pOwner);
+      assertUnit(sDest.pShared.get() == pOwner);
+      assertUnit(pOwner->root == sSrc.bst.root);
+      assertUnit(pOwner->numElements == 3);
+   }  // teardown
+
+   // many threads may copy the same const set at once
+   void test_cow_copyConcurrent()
+   {  // setup
+      custom::set <int> sSrc{ 50, 30, 70, 20, 40, 60, 80 };
+      sSrc.copy_on_write(true);
+      const custom::set <int> & sConst = sSrc;
+      std::atomic<size_t> numShared(0);
+      // exercise
+      custom::parallel_for(64, 4, [&](size_t)
+      {
+         custom::set <int> sCopy(sConst);
+         if (sCopy.bst.root == sConst.bst.root && sCopy.size() == 7)
+            numShared++;
+      });
+      // verify
+      assertUnit(numShared == 64);
+      assertUnit(sSrc.pShared.use_count() == 1);
+   }  // teardown
+
+   // an iterator into the shared nodes follows the clone
+   void test_cow_eraseIteratorDetaches()
+   {  // setup
+      custom::set <int> sSrc;
+      setupStandardFixture(sSrc);
+      sSrc.copy_on_write(true);
+      custom::set <int> sDest(sSrc);
+      auto it = sDest.find(40);
+      // exercise
+      auto itNext = sDest.erase(it);
+      // verify
+      assertUnit(itNext != sDest.end());
+      if (itNext != sDest.end())
+         assertUnit(*itNext == 50);
+      assertUnit(sDest.size() == 6);
+      assertUnit(sDest.find(40) == sDest.end());
+      assertUnit(sDest.bst.root != sSrc.bst.root);
+      assertStandardFixture(sSrc);
+   }  // teardown
+
+   // both ends of a range follow the clone
+   void test_cow_eraseRangeDetaches()
+   {  // setup
+      custom::set <int> sSrc;
+      setupStandardFixture(sSrc);
+      sSrc.copy_on_write(true);
+      custom::set <int> sDest(sSrc);
+      auto itBegin = sDest.find(30);
+      auto itEnd = sDest.find(60);
+      // exercise
+      sDest.erase(itBegin, itEnd);
+      // verify
+      std::vector<int> v;
+      for (auto it = sDest.begin(); it != sDest.end(); ++it)
+         v.push_back(*it);
+      assertUnit(v == std::vector<int>({ 20, 60, 70, 80 }));
+      assertStandardFixture(sSrc);
+   }  // teardown
+
+   // clearing a copy just lets go of the shared nodes
+   void test_cow_clearDetaches()
+   {  // setup
+      custom::set <Spy> sSrc{ Spy(50), Spy(30), Spy(70) };
+      sSrc.copy_on_write(true);
+      custom::set <Spy> sDest(sSrc);
+      Spy::reset();
+      // exercise
+      sDest.clear();
+      // verify
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(sDest.empty());
+      assertUnit(sDest.bst.root == nullptr);
+      assertUnit(sSrc.size() == 3);
+      assertUnit(sSrc.pShared.use_count() == 1);
+   }  // teardown
+
+   // once the other copies are gone the nodes come back without a clone
+   void test_cow_soleOwnerTakesBack()
+   {  // setup
+      custom::set <Spy> * pSrc = new custom::set <Spy>{ Spy(50), Spy(30), Spy(70) };
+      pSrc->copy_on_write(true);
+      custom::set <Spy> sDest(*pSrc);
+      delete pSrc;
+      Spy s(60);
+      Spy::reset();
+      // exercise
+      sDest.insert(s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);        // copy [60], nothing cloned
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(sDest.pShared.use_count() == 1);
+      assertUnit(sDest.pShared->root == sDest.bst.root);
+      assertUnit(sDest.pShared->numElements == 4);
+      assertUnit(sDest.size() == 4);
+   }  // teardown
+
+   // without copy-on-write a copy is still a deep copy
+   void test_cow_disabledClones()
+   {  // setup
+      custom::set <int> sSrc;
+      setupStandardFixture(sSrc);
+      // exercise
+      custom::set <int> sDest(sSrc);
+      // verify
+      assertUnit(!sSrc.copy_on_write());
+      assertUnit(sDest.bst.root != sSrc.bst.root);
+      assertUnit(sSrc.pShared == nullptr);
+      assertUnit(sDest.pShared == nullptr);
+      assertStandardFixture(sDest);
+      // teardown
+      teardownStandardFixture(sSrc);
+      teardownStandardFixture(sDest);
+   }
+
+   /***************************************
+    * PARALLEL
+    ***************************************/
+
+   // an empty set has nothing to split
+   void test_chunks_empty()
+   {  // setup
+      custom::set <int> s;
+      // exercise
+      auto ranges = s.chunks(4);
+      // verify
+      assertUnit(ranges.empty());
+      assertEmptyFixture(s);
+   }  // teardown
+
+   // asking for one chunk gives the whole set
+   void test_chunks_one()
+   {  // setup
+      custom::set <int> s;
+      setupStandardFixture(s);
+      // exercise
+      auto ranges = s.chunks(1);
+      // verify
+      assertUnit(ranges.size() == 1);
+      if (ranges.size() == 1)
+      {
+         assertUnit(ranges[0].first == s.begin());
+         assertUnit(ranges[0].second == s.end());
+      }
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // four chunks split at the top two levels: [20] [30 40] [50 60] [70 80]
+   void test_chunks_standard()
+   {  // setup
+      //                (50b)
+      //          +-------+-------+
+      //        (30b)           (70b)
+      //     +----+----+     +----+----+
+      //   (20r)     (40r) (60r)     (80r)
+      custom::set <int> s;
+      setupStandardFixture(s);
+      // exercise
+      auto ranges = s.chunks(4);
+      // verify
+      assertUnit(ranges.size() == 4);
+      std::vector<std::vector<int>> contents;
+      for (auto & range : ranges)
+      {
+         contents.push_back(std::vector<int>());
+         for (auto it = range.first; it != range.second; ++it)
+            contents.back().push_back(*it);
+      }
+      assertUnit(contents == std::vector<std::vector<int>>({ { 20 }, { 30, 40 }, { 50, 60 }, { 70, 80 } }));
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   // nothing to visit
+   void test_parallelForEach_empty()
+   {  // setup
+      custom::set <int> s;
+      int count = 0;
+      // exercise
+      s.parallel_for_each([&count](int) { count++; }, 4);
+      // verify
+      assertUnit(count == 0);
+   }  // teardown
+
+   // every element is visited exactly once
+   void test_parallelForEach_standard()
+   {  // setup
+      custom::set <int> s;
+      setupStandardFixture(s);
+      std::atomic<int> sum(0);
+      std::atomic<int> count(0);
+      // exercise
+      s.parallel_for_each([&](int value)
+      {
+         sum += value;
+         count++;
+      }, 4);
+      // verify
+      assertUnit(sum == 350);
+      assertUnit(count == 7);
+      assertStandardFixture(s);
+      // teardown
+      teardownStandardFixture(s);
+   }
+
+   /***************************************
+    * ALLOCATIONS
+    ***************************************/
+
+   // each new element is one node, all of one size
+   void test_allocs_insert()
+   {  // setup
+      custom::set<int> s;
+      presizeLatencies(s);
+      custom::alloc_scope scope;
+      // exercise
+      s.insert(50);
+      s.insert(30);
+      s.insert(70);
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.numAllocs == 3);
+      assertUnit(stats.numFrees == 0);
+      assertUnit(stats.bytesAllocated % 3 == 0);
+      assertUnit(stats.bytesAllocated / 3 <= s.stats().bytesNode);
+      assertUnit(stats.sizeCounts[custom::alloc_stats::sizeClass(stats.bytesAllocated / 3)] == 3);
+   }  // teardown
+
+   // a duplicate allocates nothing
+   void test_allocs_insertDuplicate()
+   {  // setup
+      custom::set<int> s{ 50, 30, 70 };
+      presizeLatencies(s);
+      custom::alloc_scope scope;
+      // exercise
+      s.insert(30);
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.empty());
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // looking, hit or miss, allocates nothing
+   void test_allocs_find()
+   {  // setup
+      custom::set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      presizeLatencies(s);
+      custom::alloc_scope scope;
+      // exercise
+      bool isFound = s.find(40) != s.end() && !s.contains(45);
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(isFound);
+      assertUnit(stats.empty());
+   }  // teardown
+
+   // erasing frees the one node and allocates nothing
+   void test_allocs_erase()
+   {  // setup
+      custom::set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      presizeLatencies(s);
+      custom::alloc_scope scope;
+      // exercise
+      s.erase(40);
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.numAllocs == 0);
+      assertUnit(stats.numFrees == 1);
+      assertUnit(stats.bytesLive() < 0);
+   }  // teardown
+
+   // a copy allocates one node for each element
+   void test_allocs_copy()
+   {  // setup
+      custom::set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      custom::alloc_scope scope;
+      // exercise
+      custom::set<int> sCopy(s);
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.numAllocs == 7);
+      assertUnit(stats.numFrees == 0);
+      assertUnit(stats.bytesAllocated <= 7 * s.stats().bytesNode);
+   }  // teardown
+
+   // a copy on write shares the nodes; the first change clones every one
+   void test_allocs_copyOnWrite()
+   {  // setup
+      custom::set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      s.copy_on_write(true);
+      custom::alloc_scope scope;
+      // exercise
+      custom::set<int> sCopy(s);
+      custom::alloc_stats statsCopy = scope.stats();
+      presizeLatencies(sCopy);
+      scope.restart();
+      sCopy.insert(90);
+      custom::alloc_stats statsWrite = scope.stats();
+      // verify
+      assertUnit(statsCopy.numAllocs == 0);    // the owner was made by copy_on_write(true)
+      assertUnit(statsWrite.numAllocs == 9);   // 7 cloned, [90], and the clone's owner
+   }  // teardown
+
+   // a set gives back all it took
+   void test_allocs_destroy()
+   {  // setup
+      custom::alloc_scope scope;
+      // exercise
+      {
+         custom::set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+         s.erase(30);
+         s.insert(35);
+         custom::set<int> sCopy(s);
+         sCopy.insert(90);
+      }
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(stats.numAllocs > 0);
+      assertUnit(stats.numAllocs == stats.numFrees);
+      assertUnit(stats.bytesLive() == 0);
+      assertUnit(stats.bytesPeak > 0);
+   }  // teardown
+
+   /***************************************
+    * BUDGETS
+    * The fewest copies, moves, and allocations
+    * each way in can get away with
+    ***************************************/
+
+   // copy insert: one copy into the new node
+   void test_budget_insertCopy()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70) };
+      Spy spy(40);
+      Spy::reset();
+      // exercise
+      s.insert(spy);
+      // verify
+      assertUnit(s.size() == 4);
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // move insert: one move into the new node, nothing allocated
+   void test_budget_insertMove()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70) };
+      Spy spy(40);
+      Spy::reset();
+      // exercise
+      s.insert(std::move(spy));
+      // verify
+      assertUnit(s.size() == 4);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 1);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // a duplicate is neither copied nor moved
+   void test_budget_insertDuplicate()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70) };
+      Spy spy(30);
+      Spy::reset();
+      // exercise
+      s.insert(spy);
+      s.insert(std::move(spy));
+      // verify
+      assertUnit(s.size() == 3);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // an initializer list: one copy for each new element, none for a duplicate
+   void test_budget_insertInitializer()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70) };
+      std::initializer_list<Spy> il{ Spy(20), Spy(40), Spy(30), Spy(60) };
+      Spy::reset();
+      // exercise
+      s.insert(il);
+      // verify
+      assertUnit(s.size() == 6);
+      assertUnit(Spy::numCopy() == 3);
+      assertUnit(Spy::numAlloc() == 3);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // a range of move iterators is moved from, not copied
+   void test_budget_insertRangeMove()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70) };
+      std::vector<Spy> v;
+      v.reserve(3);
+      v.push_back(Spy(20));
+      v.push_back(Spy(40));
+      v.push_back(Spy(60));
+      Spy::reset();
+      // exercise
+      s.insert(std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+      // verify
+      assertUnit(s.size() == 6);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 3);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // a range of move iterators builds a new set without a copy
+   void test_budget_constructRangeMove()
+   {  // setup
+      std::vector<Spy> v;
+      v.reserve(3);
+      v.push_back(Spy(20));
+      v.push_back(Spy(40));
+      v.push_back(Spy(40));
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s(std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+      // verify
+      assertUnit(s.size() == 2);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 2);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // an initializer list builds one node for each distinct element
+   void test_budget_constructInitializer()
+   {  // setup
+      std::initializer_list<Spy> il{ Spy(50), Spy(30), Spy(50), Spy(70) };
+      Spy::reset();
+      // exercise
+      custom::set <Spy> s(il);
+      // verify
+      assertUnit(s.size() == 3);
+      assertUnit(Spy::numCopy() == 3);
+      assertUnit(Spy::numAlloc() == 3);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // assigning a list the same size reuses every node
+   void test_budget_assignInitializerSame()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70) };
+      std::initializer_list<Spy> il{ Spy(20), Spy(10), Spy(40) };
+      Spy::reset();
+      // exercise
+      s = il;
+      // verify
+      assertUnit(s.size() == 3);
+      assertUnit(s.find(Spy(10)) != s.end());
+      Spy::reset();
+      s = il;
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 3);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // assigning a shorter list reuses what it needs and deletes the rest
+   void test_budget_assignInitializerShorter()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40) };
+      std::initializer_list<Spy> il{ Spy(99), Spy(98) };
+      Spy::reset();
+      // exercise
+      s = il;
+      // verify
+      assertUnit(s.size() == 2);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 2);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 3);
+   }  // teardown
+
+   // assigning a longer list reuses every node and copies only the rest
+   void test_budget_assignInitializerLonger()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30) };
+      std::initializer_list<Spy> il{ Spy(20), Spy(10), Spy(40), Spy(60), Spy(10) };
+      Spy::reset();
+      // exercise
+      s = il;
+      // verify
+      assertUnit(s.size() == 4);
+      assertUnit(Spy::numCopy() == 2);
+      assertUnit(Spy::numAlloc() == 2);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 2);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // assigning a set of another shape reuses every node it can
+   void test_budget_assignCopy()
+   {  // setup
+      custom::set <Spy> sSrc{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40) };
+      custom::set <Spy> sDest{ Spy(10), Spy(20), Spy(30) };
+      Spy::reset();
+      // exercise
+      sDest = sSrc;
+      // verify
+      assertUnit(sDest.size() == 5);
+      assertUnit(Spy::numCopy() == 2);
+      assertUnit(Spy::numAlloc() == 2);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 3);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // copying a set copies each element once; moving it touches none
+   void test_budget_copyMove()
+   {  // setup
+      custom::set <Spy> sSrc{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40) };
+      Spy::reset();
+      // exercise
+      custom::set <Spy> sCopy(sSrc);
+      custom::set <Spy> sMove(std::move(sSrc));
+      // verify
+      assertUnit(sCopy.size() == 5);
+      assertUnit(sMove.size() == 5);
+      assertUnit(Spy::numCopy() == 5);
+      assertUnit(Spy::numAlloc() == 5);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // finding and erasing relink nodes and never touch an element
+   void test_budget_findErase()
+   {  // setup
+      custom::set <Spy> s{ Spy(50), Spy(30), Spy(70), Spy(20), Spy(40), Spy(60), Spy(80) };
+      Spy spy30(30);
+      Spy spy50(50);
+      Spy spy99(99);
+      Spy::reset();
+      // exercise
+      bool isFound = s.find(spy30) != s.end() && !s.contains(spy99);
+      s.erase(spy30);    // two children
+      s.erase(spy50);    // the root
+      s.erase(spy99);    // not there
+      // verify
+      assertUnit(isFound);
+      assertUnit(s.size() == 5);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numAssign() == 0);
+      assertUnit(Spy::numAssignMove() == 0);
+      assertUnit(Spy::numDelete() == 2);
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *                (50b)
+    *          +-------+-------+
+    *        (30b)           (70b)
+    *     +----+----+     +----+----+
+    *   (20r)     (40r) (60r)     (80r)
+    *************************************************************/
+   void setupStandardFixture(custom::set<int>& s)
+   {
+      // make sure that bst is clean
+      assertUnit(s.bst.numElements == 0);
+      assertUnit(s.bst.root == nullptr);
+
+      // allocate
+      custom::BST<int>::BNode* p20 = new custom::BST<int>::BNode(int(20));
+      custom::BST<int>::BNode* p30 = new custom::BST<int>::BNode(int(30));
+      custom::BST<int>::BNode* p40 = new custom::BST<int>::BNode(int(40));
+      custom::BST<int>::BNode* p50 = new custom::BST<int>::BNode(int(50));
+      custom::BST<int>::BNode* p60 = new custom::BST<int>::BNode(int(60));
+      custom::BST<int>::BNode* p70 = new custom::BST<int>::BNode(int(70));
+      custom::BST<int>::BNode* p80 = new custom::BST<int>::BNode(int(80));
+
+      // hook up the pointers down
+      p30->pLeft = p20;
+      p30->pRight = p40;
+      p50->pLeft = p30;
+      p50->pRight = p70;
+      p70->pLeft = p60;
+      p70->pRight = p80;
+
+      // hook up the pointers up
+      p20->pParent = p40->pParent = p30;
+      p30->pParent = p70->pParent = p50;
+      p60->pParent = p80->pParent = p70;
+
+      // color everything
+
+      // now assign everything to the bst
+      s.bst.root = p50;
+      s.bst.numElements = 7;
    }
 
    /*************************************************************
@@ -2705,7 +4629,80 @@ public:
       }
    }
 
+   /*************************************************************
+    * PRESIZE LATENCIES
+    * With SET_LATENCY, a set's histograms grow as they record.
+    * Grow them first so a test counts only what the set allocates.
+    *************************************************************/
+   template <class T, class Counters>
+   static void presizeLatencies(custom::set<T, Counters> & s)
+   {
+#ifdef SET_LATENCY
+      for (auto & histogram : s.latencies)
+      {
+         histogram.record(1000000000000ULL);   // a thousand seconds
+         histogram.clear();
+      }
+#else
+      (void)s;
+#endif // SET_LATENCY
+   }
+
+   /*************************************************************
+    * CONTENTS
+    * The elements of a set, in order
+    *************************************************************/
+   template <class T>
+   std::vector<T> contents(const custom::set<T> & s)
+   {
+      std::vector<T> v;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         v.push_back(*it);
+      return v;
+   }
+
+   /*************************************************************
+    * INDEX MATCHES
+    * The hash index holds exactly the nodes of the tree
+    *************************************************************/
+   template <class T>
+   bool indexMatches(const custom::set<T> & s)
+   {
+      if (!s.pIndex || s.pIndex->size() != s.size())
+         return false;
+      for (auto it = s.bst.begin(); it != s.bst.end(); ++it)
+         if (s.pIndex->find(*it) != it.pNode)
+            return false;
+      return true;
+   }
+
+   /*************************************************************
+    * HEIGHT
+    * Levels in the subtree, zero for an empty one
+    *************************************************************/
+   template <class Node>
+   size_t height(const Node * p)
+   {
+      if (!p)
+         return 0;
+      return 1 + std::max(height(p->pLeft), height(p->pRight));
+   }
 
+   /*************************************************************
+    * PARENTS LINKED
+    * Every child points back up at its parent
+    *************************************************************/
+   template <class Node>
+   bool parentsLinked(const Node * p)
+   {
+      if (!p)
+         return true;
+      if (p->pLeft && p->pLeft->pParent != p)
+         return false;
+      if (p->pRight && p->pRight->pParent != p)
+         return false;
+      return parentsLinked(p->pLeft) && parentsLinked(p->pRight);
+   }
 };
 
 #endif // DEBUG
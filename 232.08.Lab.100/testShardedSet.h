@@ -0,0 +1,283 @@
+/***********************************************************************
+ * Header:
+ *    TEST SHARDED SET
+ * Summary:
+ *    Unit tests for sharded_set
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "shardedSet.h"
+#include "unitTest.h"
+
+#include <thread>
+#include <vector>
+
+/***********************************************
+ * TEST SHARDED SET
+ * Unit tests for the sharded_set class
+ ***********************************************/
+class TestShardedSet : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructInit_standard();
+
+      // Iterator
+      test_iterator_ordered();
+      test_iterator_oneShard();
+
+      // Access
+      test_find_standard();
+      test_find_missing();
+
+      // Insert
+      test_insert_empty();
+      test_insert_duplicate();
+      test_insert_spinlock();
+      test_insert_concurrent();
+
+      // Remove
+      test_erase_standard();
+      test_erase_missing();
+      test_clear_standard();
+
+      // Layout
+      test_layout_heapShardsApart();
+
+      report("ShardedSet");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, every shard empty
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::sharded_set<int, 4> s;
+      // verify
+      assertUnit(s.size() == 0);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+      for (size_t i = 0; i < 4; i++)
+         assertUnit(s.shards[i].data.empty());
+   }  // teardown
+
+   // initializer list spreads over the shards
+   void test_constructInit_standard()
+   {  // setup
+      // exercise
+      custom::sharded_set<int, 4> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // verify
+      assertUnit(s.size() == 7);
+      size_t total = 0;
+      for (size_t i = 0; i < 4; i++)
+         total += s.shards[i].data.size();
+      assertUnit(total == 7);
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // walking the set merges the shards into sorted order
+   void test_iterator_ordered()
+   {  // setup
+      custom::sharded_set<int, 4> s{ 50, 30, 70, 20, 40, 60, 80 };
+      std::vector<int> v;
+      // exercise
+      for (auto it = s.begin(); it != s.end(); ++it)
+         v.push_back(*it);
+      // verify
+      assertUnit(v == std::vector<int>({ 20, 30, 40, 50, 60, 70, 80 }));
+   }  // teardown
+
+   // a single shard behaves like a plain set
+   void test_iterator_oneShard()
+   {  // setup
+      custom::sharded_set<int, 1> s{ 3, 1, 2 };
+      std::vector<int> v;
+      // exercise
+      for (auto it = s.begin(); it != s.end(); it++)
+         v.push_back(*it);
+      // verify
+      assertUnit(v == std::vector<int>({ 1, 2, 3 }));
+      assertUnit(s.shards[0].data.size() == 3);
+   }  // teardown
+
+   /***************************************
+    * FIND
+    ***************************************/
+
+   // find positions the merge so iteration continues in order
+   void test_find_standard()
+   {  // setup
+      custom::sharded_set<int, 4> s{ 50, 30, 70, 20, 40, 60, 80 };
+      std::vector<int> v;
+      // exercise
+      auto it = s.find(40);
+      // verify
+      assertUnit(it != s.end());
+      for (; it != s.end(); ++it)
+         v.push_back(*it);
+      assertUnit(v == std::vector<int>({ 40, 50, 60, 70, 80 }));
+   }  // teardown
+
+   // a missing key gives end()
+   void test_find_missing()
+   {  // setup
+      custom::sharded_set<int, 4> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      auto it = s.find(42);
+      // verify
+      assertUnit(it == s.end());
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert into an empty set
+   void test_insert_empty()
+   {  // setup
+      custom::sharded_set<int, 4> s;
+      // exercise
+      bool inserted = s.insert(42);
+      // verify
+      assertUnit(inserted);
+      assertUnit(s.size() == 1);
+      assertUnit(s.begin() != s.end());
+      if (s.begin() != s.end())
+         assertUnit(*s.begin() == 42);
+   }  // teardown
+
+   // inserting a key twice keeps one copy
+   void test_insert_duplicate()
+   {  // setup
+      custom::sharded_set<int, 4> s{ 50, 30, 70 };
+      // exercise
+      bool inserted = s.insert(30);
+      // verify
+      assertUnit(!inserted);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // the lock type can be swapped for a spinlock
+   void test_insert_spinlock()
+   {  // setup
+      custom::sharded_set<int, 8, custom::spinlock> s;
+      // exercise
+      for (int i = 100; i > 0; i--)
+         s.insert(i);
+      // verify
+      assertUnit(s.size() == 100);
+      int expected = 1;
+      bool ordered = true;
+      for (auto it = s.begin(); it != s.end(); ++it)
+         ordered = ordered && (*it == expected++);
+      assertUnit(ordered);
+   }  // teardown
+
+   // many threads inserting overlapping keys at once
+   void test_insert_concurrent()
+   {  // setup
+      custom::sharded_set<int, 8> s;
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.push_back(std::thread([&s, t]()
+         {
+            for (int i = 0; i < 1000; i++)
+               s.insert((i * 7 + t * 250) % 2000);
+         }));
+      for (auto & thread : threads)
+         thread.join();
+      // verify
+      size_t count = 0;
+      bool ordered = true;
+      int prev = -1;
+      for (auto it = s.begin(); it != s.end(); ++it, ++count)
+      {
+         ordered = ordered && (prev < *it);
+         prev = *it;
+      }
+      assertUnit(ordered);
+      assertUnit(count == s.size());
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erase a key that is there
+   void test_erase_standard()
+   {  // setup
+      custom::sharded_set<int, 4> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      size_t numErased = s.erase(40);
+      // verify
+      assertUnit(numErased == 1);
+      assertUnit(s.size() == 6);
+      assertUnit(s.find(40) == s.end());
+   }  // teardown
+
+   // erase a key that is not there
+   void test_erase_missing()
+   {  // setup
+      custom::sharded_set<int, 4> s{ 50, 30, 70 };
+      // exercise
+      size_t numErased = s.erase(42);
+      // verify
+      assertUnit(numErased == 0);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // clear empties every shard
+   void test_clear_standard()
+   {  // setup
+      custom::sharded_set<int, 4> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      s.clear();
+      // verify
+      assertUnit(s.size() == 0);
+      assertUnit(s.begin() == s.end());
+      for (size_t i = 0; i < 4; i++)
+         assertUnit(s.shards[i].data.empty());
+   }  // teardown
+
+   /***************************************
+    * LAYOUT
+    ***************************************/
+
+   // a heap-allocated set still keeps a cache line between the shards
+   void test_layout_heapShardsApart()
+   {  // setup
+      custom::sharded_set<int, 4, custom::spinlock> * pSet =
+         new custom::sharded_set<int, 4, custom::spinlock>;
+      // exercise
+      for (size_t i = 0; i + 1 < 4; i++)
+      {
+         const char * pEnd  = (const char *)&pSet->shards[i].data + sizeof(pSet->shards[i].data);
+         const char * pNext = (const char *)&pSet->shards[i + 1].lock;
+         // verify
+         assertUnit(pNext - pEnd >= 64);
+      }
+      const char * pLast = (const char *)&pSet->shards[3].data + sizeof(pSet->shards[3].data);
+      assertUnit((const char *)&pSet->numElements - pLast >= 64);
+      // teardown
+      delete pSet;
+   }
+};
+
+#endif // DEBUG
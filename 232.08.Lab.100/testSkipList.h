@@ -0,0 +1,303 @@
+/***********************************************************************
+ * Header:
+ *    TEST SKIP LIST
+ * Summary:
+ *    Unit tests for concurrent_skiplist_set
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "skipList.h"
+#include "allocTracker.h"
+#include "unitTest.h"
+
+#include <thread>
+#include <vector>
+
+/***********************************************
+ * TEST SKIP LIST
+ * Unit tests for the concurrent_skiplist_set class
+ ***********************************************/
+class TestSkipList : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructInit_standard();
+
+      // Iterator
+      test_iterator_ordered();
+
+      // Access
+      test_find_standard();
+      test_find_missing();
+      test_contains_standard();
+
+      // Insert
+      test_insert_empty();
+      test_insert_duplicate();
+      test_insertMove_string();
+
+      // Remove
+      test_erase_standard();
+      test_erase_missing();
+      test_erase_reinsert();
+      test_clear_standard();
+      test_clear_reclaims();
+
+      // Concurrency
+      test_stress_insertErase();
+
+      report("SkipList");
+   }
+
+   /***************************************
+    * CONSTRUCTORS
+    ***************************************/
+
+   // default constructor, nothing linked from the head
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::concurrent_skiplist_set<int> s;
+      // verify
+      assertUnit(s.size() == 0);
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+      bool allNull = true;
+      for (int level = 0; level < custom::concurrent_skiplist_set<int>::MAX_LEVEL; level++)
+         allNull = allNull && s.head[level].load() == 0;
+      assertUnit(allNull);
+   }  // teardown
+
+   // initializer list
+   void test_constructInit_standard()
+   {  // setup
+      // exercise
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // verify
+      assertUnit(s.size() == 7);
+      assertUnit(!s.empty());
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // level 0 is kept in sorted order
+   void test_iterator_ordered()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      std::vector<int> v;
+      // exercise
+      for (auto it = s.begin(); it != s.end(); ++it)
+         v.push_back(*it);
+      // verify
+      assertUnit(v == std::vector<int>({ 20, 30, 40, 50, 60, 70, 80 }));
+   }  // teardown
+
+   /***************************************
+    * FIND
+    ***************************************/
+
+   // find something that is there
+   void test_find_standard()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      auto it = s.find(60);
+      // verify
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == 60);
+      ++it;
+      assertUnit(it != s.end());
+      if (it != s.end())
+         assertUnit(*it == 70);
+   }  // teardown
+
+   // find something that is not there
+   void test_find_missing()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      auto it = s.find(42);
+      // verify
+      assertUnit(it == s.end());
+   }  // teardown
+
+   // contains is the same search without the iterator
+   void test_contains_standard()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70 };
+      // exercise / verify
+      assertUnit(s.contains(30));
+      assertUnit(!s.contains(31));
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert into an empty set
+   void test_insert_empty()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s;
+      // exercise
+      auto pairSet = s.insert(42);
+      // verify
+      assertUnit(pairSet.second == true);
+      assertUnit(pairSet.first != s.end());
+      if (pairSet.first != s.end())
+         assertUnit(*pairSet.first == 42);
+      assertUnit(s.size() == 1);
+      assertUnit(s.head[0].load() != 0);
+   }  // teardown
+
+   // a duplicate gives back the one already there
+   void test_insert_duplicate()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70 };
+      // exercise
+      auto pairSet = s.insert(30);
+      // verify
+      assertUnit(pairSet.second == false);
+      assertUnit(pairSet.first != s.end());
+      if (pairSet.first != s.end())
+         assertUnit(*pairSet.first == 30);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // move insert of a non-trivial type
+   void test_insertMove_string()
+   {  // setup
+      custom::concurrent_skiplist_set<std::string> s;
+      std::string str("moved");
+      // exercise
+      auto pairSet = s.insert(std::move(str));
+      // verify
+      assertUnit(pairSet.second == true);
+      assertUnit(s.contains(std::string("moved")));
+   }  // teardown
+
+   /***************************************
+    * ERASE
+    ***************************************/
+
+   // erase an element that is there
+   void test_erase_standard()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      std::vector<int> v;
+      // exercise
+      size_t numErased = s.erase(50);
+      // verify
+      assertUnit(numErased == 1);
+      assertUnit(s.size() == 6);
+      for (auto it = s.begin(); it != s.end(); ++it)
+         v.push_back(*it);
+      assertUnit(v == std::vector<int>({ 20, 30, 40, 60, 70, 80 }));
+   }  // teardown
+
+   // erase an element that is not there
+   void test_erase_missing()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70 };
+      // exercise
+      size_t numErased = s.erase(42);
+      // verify
+      assertUnit(numErased == 0);
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // erase and insert the same key again
+   void test_erase_reinsert()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70 };
+      // exercise
+      s.erase(30);
+      auto pairSet = s.insert(30);
+      // verify
+      assertUnit(pairSet.second == true);
+      assertUnit(s.contains(30));
+      assertUnit(s.size() == 3);
+   }  // teardown
+
+   // clear removes everything
+   void test_clear_standard()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s{ 50, 30, 70, 20, 40, 60, 80 };
+      // exercise
+      s.clear();
+      // verify
+      assertUnit(s.empty());
+      assertUnit(s.begin() == s.end());
+   }  // teardown
+
+   // clear() pins one element at a time, so the nodes it erases are
+   // freed as it goes rather than piling up behind a pinned epoch
+   void test_clear_reclaims()
+   {  // setup
+      const int num = 20000;
+      custom::concurrent_skiplist_set<int> s;
+      for (int i = 0; i < num; i++)
+         s.insert(i);
+      custom::alloc_scope scope;
+      // exercise
+      s.clear();
+      custom::alloc_stats stats = scope.stats();
+      // verify
+      assertUnit(s.empty());
+      assertUnit(custom::alloc_tracker::isHooked());
+      assertUnit(stats.numFrees >= (uint64_t)num - 1000);
+   }  // teardown
+
+   /***************************************
+    * STRESS
+    ***************************************/
+
+   // threads insert and erase overlapping keys, then the
+   // survivors must be sorted, unique and counted correctly
+   void test_stress_insertErase()
+   {  // setup
+      custom::concurrent_skiplist_set<int> s;
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.push_back(std::thread([&s, t]()
+         {
+            for (int i = 0; i < 5000; i++)
+            {
+               int key = (i * 31 + t * 17) % 512;
+               if ((i + t) % 3 == 0)
+                  s.erase(key);
+               else
+                  s.insert(key);
+            }
+         }));
+      for (auto & thread : threads)
+         thread.join();
+      // verify
+      size_t count = 0;
+      bool ordered = true;
+      int prev = -1;
+      for (auto it = s.begin(); it != s.end(); ++it, ++count)
+      {
+         ordered = ordered && (prev < *it);
+         prev = *it;
+      }
+      assertUnit(ordered);
+      assertUnit(count == s.size());
+      custom::epoch_domain::instance().reclaim();
+   }  // teardown
+};
+
+#endif // DEBUG
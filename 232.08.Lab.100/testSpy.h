@@ -13,6 +13,9 @@
 #include "spy.h"        // class under test
 #include "unitTest.h"   // unit test baseclass
 
+#include <thread>       // for std::thread
+#include <vector>
+
 /***********************************************
  * TEST SPY
  * Unit tests for the Spy class
@@ -68,6 +71,14 @@ public:
       test_lessthan_same();
       test_lessthan_firstSmaller();
       test_lessthan_firstLarger();
+
+      // Threads
+      test_threads_count();
+      test_threads_reuse();
+
+      // Snapshot
+      test_snapshot_diff();
+      test_snapshot_nested();
   
       report("Spy");
    }
@@ -733,8 +744,93 @@ public:
          delete sDes.p;
       sDes.p = sSrc.p = nullptr;
    }
-};
 
-#endif // DEBUG
+   /***************************************
+    * THREADS
+    ***************************************/
 
+   // uses on several threads at once all add up
+   void test_threads_count()
+   {  // setup
+      Spy::reset();
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < NUM_THREADS; t++)
+         threads.push_back(std::thread([]()
+         {
+            for (int i = 0; i < NUM_PER_THREAD; i++)
+            {
+               Spy s(i);
+               Spy sCopy(s);
+            }
+         }));
+      for (auto & thread : threads)
+         thread.join();
+      // verify
+      assertUnit(Spy::numNondefault() == NUM_THREADS * NUM_PER_THREAD);
+      assertUnit(Spy::numCopy()       == NUM_THREADS * NUM_PER_THREAD);
+      assertUnit(Spy::numAlloc()      == 2 * NUM_THREADS * NUM_PER_THREAD);
+      assertUnit(Spy::numDelete()     == 2 * NUM_THREADS * NUM_PER_THREAD);
+      assertUnit(Spy::numDestructor() == 2 * NUM_THREADS * NUM_PER_THREAD);
+   }  // teardown
 
+   // a thread that ended keeps its counts for the next one
+   void test_threads_reuse()
+   {  // setup
+      Spy::reset();
+      // exercise
+      for (int t = 0; t < NUM_THREADS; t++)
+         std::thread([]() { Spy s; }).join();
+      Spy s;
+      // verify
+      assertUnit(Spy::numDefault() == NUM_THREADS + 1);
+      assertUnit(Spy::numDestructor() == NUM_THREADS);
+   }  // teardown
+
+   /***************************************
+    * SNAPSHOT
+    *    Spy::Snapshot
+    ***************************************/
+
+   // a snapshot counts from when it was made, without a reset
+   void test_snapshot_diff()
+   {  // setup
+      Spy s(5);
+      uint64_t numNondefaultBefore = Spy::numNondefault();
+      Spy::Snapshot snapshot;
+      // exercise
+      Spy sCopy(s);
+      bool isLess = s < sCopy;
+      // verify
+      assertUnit(!isLess);
+      assertUnit(snapshot.count(COPY) == 1);
+      assertUnit(snapshot.count(ALLOC) == 1);
+      assertUnit(snapshot.count(LESSTHAN) == 1);
+      assertUnit(snapshot.count(NONDEFAULT) == 0);
+      assertUnit(snapshot.total() == 3);
+      assertUnit(Spy::numNondefault() == numNondefaultBefore);
+   }  // teardown
+
+   // snapshots overlap without disturbing each other
+   void test_snapshot_nested()
+   {  // setup
+      Spy::Snapshot outer;
+      Spy s1(1);
+      // exercise
+      Spy::Snapshot inner;
+      Spy s2(2);
+      Spy s3(3);
+      // verify
+      assertUnit(outer.count(NONDEFAULT) == 3);
+      assertUnit(inner.count(NONDEFAULT) == 2);
+      inner.restart();
+      assertUnit(inner.count(NONDEFAULT) == 0);
+      assertUnit(outer.count(NONDEFAULT) == 3);
+   }  // teardown
+
+private:
+   static const int NUM_THREADS = 4;
+   static const int NUM_PER_THREAD = 10000;
+};
+
+#endif // DEBUG
@@ -0,0 +1,414 @@
+/***********************************************************************
+ * Header:
+ *    TEST TRACE
+ * Summary:
+ *    Unit tests for trace_writer, trace_load, and set::trace()
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "trace.h"
+#include "set.h"
+#include "spy.h"
+#include "unitTest.h"
+
+#include <cstdint>
+#include <cstdio>      // for std::remove
+#include <fstream>
+#include <functional>  // for std::hash
+#include <iterator>    // for std::back_inserter
+#include <string>
+#include <vector>
+
+/***********************************************
+ * TEST TRACE
+ * Unit tests for capturing a set's calls
+ ***********************************************/
+class TestTrace : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Writer
+      test_write_empty();
+      test_write_roundTrip();
+      test_write_extremeKeys();
+      test_write_manyEvents();
+      test_write_notOpen();
+
+      // Load
+      test_load_missing();
+      test_load_badHeader();
+      test_load_truncated();
+
+      // Set
+      test_set_traceOps();
+      test_set_traceStop();
+      test_set_traceCopy();
+      test_set_traceStrings();
+      test_set_traceNoHash();
+      test_set_traceBatch();
+      test_set_traceRanges();
+
+      report("Trace");
+   }
+
+   /***************************************
+    * WRITER
+    ***************************************/
+
+   // a trace with no events is still a trace
+   void test_write_empty()
+   {  // setup
+      custom::trace_writer writer;
+      std::vector<custom::trace_event> events{ { custom::TRACE_FIND, false, 0, 1 } };
+      // exercise
+      bool isOpen = writer.open(PATH);
+      bool isClosed = writer.close();
+      // verify
+      assertUnit(isOpen);
+      assertUnit(isClosed);
+      assertUnit(!writer.is_open());
+      assertUnit(custom::trace_load(PATH, events));
+      assertUnit(events.empty());
+      std::remove(PATH);
+   }  // teardown
+
+   // what goes in comes out, in order, with the time never going back
+   void test_write_roundTrip()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      std::vector<custom::trace_event> events;
+      // exercise
+      writer.write(custom::TRACE_INSERT, 50);
+      writer.write(custom::TRACE_FIND, 30);
+      writer.write(custom::TRACE_ERASE, -7);
+      writer.write(custom::TRACE_CLEAR);
+      writer.write(custom::TRACE_CONTAINS, 2);
+      writer.close();
+      // verify
+      assertUnit(writer.size() == 5);
+      assertUnit(custom::trace_load(PATH, events));
+      assertUnit(events.size() == 5);
+      if (events.size() == 5)
+      {
+         assertUnit(events[0].op == custom::TRACE_INSERT   && events[0].key == 50);
+         assertUnit(events[1].op == custom::TRACE_FIND     && events[1].key == 30);
+         assertUnit(events[2].op == custom::TRACE_ERASE    && events[2].key == -7);
+         assertUnit(events[3].op == custom::TRACE_CLEAR    && events[3].key == 0);
+         assertUnit(events[4].op == custom::TRACE_CONTAINS && events[4].key == 2);
+         for (size_t i = 1; i < events.size(); i++)
+            assertUnit(events[i - 1].time <= events[i].time);
+         assertUnit(!events[0].isHashed);
+      }
+      std::remove(PATH);
+   }  // teardown
+
+   // the ends of the 64 bit range survive the zigzag
+   void test_write_extremeKeys()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      std::vector<custom::trace_event> events;
+      // exercise
+      writer.write(custom::TRACE_INSERT, INT64_MIN);
+      writer.write(custom::TRACE_INSERT, INT64_MAX);
+      writer.write(custom::TRACE_INSERT, (int64_t)-1);
+      writer.close();
+      // verify
+      assertUnit(custom::trace_load(PATH, events));
+      assertUnit(events.size() == 3);
+      if (events.size() == 3)
+      {
+         assertUnit(events[0].key == INT64_MIN);
+         assertUnit(events[1].key == INT64_MAX);
+         assertUnit(events[2].key == -1);
+      }
+      std::remove(PATH);
+   }  // teardown
+
+   // more than one buffer's worth, a few bytes each
+   void test_write_manyEvents()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      std::vector<custom::trace_event> events;
+      const int num = 100000;
+      // exercise
+      for (int i = 0; i < num; i++)
+         writer.write(custom::TRACE_INSERT, i);
+      writer.close();
+      // verify
+      assertUnit(custom::trace_load(PATH, events));
+      assertUnit(events.size() == (size_t)num);
+      bool isInOrder = true;
+      for (size_t i = 0; i < events.size(); i++)
+         isInOrder = isInOrder && events[i].key == (int64_t)i;
+      assertUnit(isInOrder);
+      std::ifstream in(PATH, std::ios::binary | std::ios::ate);
+      assertUnit((size_t)in.tellg() < (size_t)num * 8);
+      in.close();
+      std::remove(PATH);
+   }  // teardown
+
+   // writing to a closed writer does nothing
+   void test_write_notOpen()
+   {  // setup
+      custom::trace_writer writer;
+      // exercise
+      writer.write(custom::TRACE_INSERT, 1);
+      // verify
+      assertUnit(!writer.is_open());
+      assertUnit(writer.size() == 0);
+      assertUnit(writer.close());
+   }  // teardown
+
+   /***************************************
+    * LOAD
+    ***************************************/
+
+   // no file
+   void test_load_missing()
+   {  // setup
+      std::remove(PATH);
+      std::vector<custom::trace_event> events;
+      // exercise
+      bool isLoaded = custom::trace_load(PATH, events);
+      // verify
+      assertUnit(!isLoaded);
+      assertUnit(events.empty());
+   }  // teardown
+
+   // a file that is not a trace
+   void test_load_badHeader()
+   {  // setup
+      {
+         std::ofstream out(PATH, std::ios::binary);
+         out << "NOTATRACE and some more";
+      }
+      std::vector<custom::trace_event> events;
+      // exercise
+      bool isLoaded = custom::trace_load(PATH, events);
+      // verify
+      assertUnit(!isLoaded);
+      assertUnit(events.empty());
+      std::remove(PATH);
+   }  // teardown
+
+   // a trace cut off in the middle of an event
+   void test_load_truncated()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      writer.write(custom::TRACE_INSERT, 1);
+      writer.write(custom::TRACE_INSERT, 1000000);
+      writer.close();
+      std::ifstream in(PATH, std::ios::binary);
+      std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      in.close();
+      {
+         std::ofstream out(PATH, std::ios::binary | std::ios::trunc);
+         out.write(bytes.data(), bytes.size() - 1);
+      }
+      std::vector<custom::trace_event> events;
+      // exercise
+      bool isLoaded = custom::trace_load(PATH, events);
+      // verify
+      assertUnit(!isLoaded);
+      assertUnit(events.empty());
+      std::remove(PATH);
+   }  // teardown
+
+   /***************************************
+    * SET
+    ***************************************/
+
+   // each traced call is one event; an erase by key is not also a find
+   void test_set_traceOps()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      custom::set <int> s;
+      s.trace(&writer);
+      std::vector<custom::trace_event> events;
+      // exercise
+      s.insert(50);
+      s.insert(30);
+      s.find(30);
+      s.contains(99);
+      s.erase(50);
+      auto it = s.find(30);
+      s.erase(it);
+      s.clear();
+      writer.close();
+      // verify
+      assertUnit(s.trace() == &writer);
+      assertUnit(custom::trace_load(PATH, events));
+      custom::trace_op ops[] = { custom::TRACE_INSERT, custom::TRACE_INSERT, custom::TRACE_FIND,
+                                 custom::TRACE_CONTAINS, custom::TRACE_ERASE, custom::TRACE_FIND,
+                                 custom::TRACE_ERASE, custom::TRACE_CLEAR };
+      int64_t keys[] = { 50, 30, 30, 99, 50, 30, 30, 0 };
+      assertUnit(events.size() == 8);
+      if (events.size() == 8)
+         for (size_t i = 0; i < 8; i++)
+         {
+            assertUnit(events[i].op == ops[i]);
+            assertUnit(events[i].key == keys[i]);
+         }
+      std::remove(PATH);
+   }  // teardown
+
+   // trace(nullptr) stops the log
+   void test_set_traceStop()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      custom::set <int> s;
+      s.trace(&writer);
+      s.insert(1);
+      // exercise
+      s.trace(nullptr);
+      s.insert(2);
+      // verify
+      assertUnit(s.trace() == nullptr);
+      assertUnit(writer.size() == 1);
+      writer.close();
+      std::remove(PATH);
+   }  // teardown
+
+   // a copy is a different set, and is not traced
+   void test_set_traceCopy()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      custom::set <int> sSrc{ 50, 30 };
+      sSrc.trace(&writer);
+      // exercise
+      custom::set <int> sCopy(sSrc);
+      sCopy.insert(70);
+      // verify
+      assertUnit(sCopy.trace() == nullptr);
+      assertUnit(writer.size() == 0);
+      writer.close();
+      std::remove(PATH);
+   }  // teardown
+
+   // a key that is not an integer is logged as its hash
+   void test_set_traceStrings()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      custom::set <std::string> s;
+      s.trace(&writer);
+      std::vector<custom::trace_event> events;
+      // exercise
+      s.insert(std::string("apple"));
+      writer.close();
+      // verify
+      assertUnit(custom::trace_load(PATH, events));
+      assertUnit(events.size() == 1);
+      if (events.size() == 1)
+      {
+         assertUnit(events[0].isHashed);
+         assertUnit(events[0].key == (int64_t)std::hash<std::string>()("apple"));
+      }
+      std::remove(PATH);
+   }  // teardown
+
+   // a key with no hash is still an event, with key 0
+   void test_set_traceNoHash()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      custom::set <Spy> s;
+      s.trace(&writer);
+      std::vector<custom::trace_event> events;
+      // exercise
+      s.insert(Spy(42));
+      writer.close();
+      // verify
+      assertUnit(custom::trace_load(PATH, events));
+      assertUnit(events.size() == 1);
+      if (events.size() == 1)
+      {
+         assertUnit(events[0].isHashed);
+         assertUnit(events[0].key == 0);
+      }
+      std::remove(PATH);
+   }  // teardown
+
+   // a batch is an event for each key it was given, duplicates included
+   void test_set_traceBatch()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      custom::set <int> s;
+      s.trace(&writer);
+      std::vector<custom::trace_event> events;
+      std::vector<int> keys = { 30, 99 };
+      std::vector<custom::set <int>::iterator> found;
+      bool isFound[2];
+      // exercise
+      s.insert_batch({ 50, 30, 50 });
+      s.find_batch(keys.begin(), keys.end(), std::back_inserter(found));
+      s.contains_batch(keys.begin(), keys.end(), isFound);
+      writer.close();
+      // verify
+      assertUnit(custom::trace_load(PATH, events));
+      custom::trace_op ops[] = { custom::TRACE_INSERT, custom::TRACE_INSERT, custom::TRACE_INSERT,
+                                 custom::TRACE_FIND, custom::TRACE_FIND,
+                                 custom::TRACE_CONTAINS, custom::TRACE_CONTAINS };
+      int64_t expected[] = { 50, 30, 50, 30, 99, 30, 99 };
+      assertUnit(events.size() == 7);
+      if (events.size() == 7)
+         for (size_t i = 0; i < 7; i++)
+         {
+            assertUnit(events[i].op == ops[i]);
+            assertUnit(events[i].key == expected[i]);
+         }
+      std::remove(PATH);
+   }  // teardown
+
+   // the range erases and erase_if log an erase for each element removed
+   void test_set_traceRanges()
+   {  // setup
+      custom::trace_writer writer;
+      writer.open(PATH);
+      custom::set <int> s{ 10, 20, 30, 40, 50, 60, 70 };
+      s.trace(&writer);
+      std::vector<custom::trace_event> events;
+      // exercise
+      s.erase_range(15, 35);
+      custom::erase_if(s, [](int value) { return value == 50; });
+      auto itBegin = s.find(60);
+      auto itEnd = s.end();
+      s.erase(itBegin, itEnd);
+      writer.close();
+      // verify
+      assertUnit(custom::trace_load(PATH, events));
+      custom::trace_op ops[] = { custom::TRACE_ERASE, custom::TRACE_ERASE, custom::TRACE_ERASE,
+                                 custom::TRACE_FIND, custom::TRACE_ERASE, custom::TRACE_ERASE };
+      int64_t expected[] = { 20, 30, 50, 60, 60, 70 };
+      assertUnit(events.size() == 6);
+      if (events.size() == 6)
+         for (size_t i = 0; i < 6; i++)
+         {
+            assertUnit(events[i].op == ops[i]);
+            assertUnit(events[i].key == expected[i]);
+         }
+      assertUnit(s.size() == 2);
+      std::remove(PATH);
+   }  // teardown
+
+private:
+   static constexpr const char * PATH = "testTrace.tmp";
+};
+
+#endif // DEBUG
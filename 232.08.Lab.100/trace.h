@@ -0,0 +1,277 @@
+/***********************************************************************
+ * Header:
+ *    Trace
+ * Summary:
+ *    A log of the calls made on a set, compact enough to leave running
+ *    against real traffic and replay later against any set. Each event
+ *    is an operation, when it happened, and its key:
+ *
+ *       "SETTRACE" version
+ *       op         one byte; 0x80 set when the key is a hash
+ *       time       varint nanoseconds since the event before
+ *       key        zigzag varint
+ *
+ *    A set logs the calls that take many keys as the calls on one key
+ *    that would do the same: insert_batch, find_batch, and
+ *    contains_batch log an event for each key given, and the range
+ *    erases and erase_if an erase for each element removed. The events
+ *    of one such call share about the same time.
+ *
+ *    Integer keys are logged as they are. Any other key is logged as
+ *    its std::hash, which keeps the pattern of repeats and misses but
+ *    not the order; a key with no std::hash is logged as 0.
+ *
+ *    The writer fills a buffer in memory and writes it out 64KB at a
+ *    time, so a traced call costs a clock read and a few bytes. Like
+ *    set itself it is not synchronized: give each thread its own.
+ *
+ *    This will contain the class definitions of:
+ *        trace_writer        : Log events to a file
+ *        trace_event         : One event read back
+ *        trace_load          : Read a whole trace file
+ * Author
+ *    Sara Nuss, William Patrick Barr
+ ************************************************************************/
+
+#pragma once
+
+#include "hashIndex.h"  // for is_hashable
+
+#include <chrono>       // for std::chrono::steady_clock
+#include <cstdint>      // for uint8_t, int64_t, and uint64_t
+#include <cstring>      // for memcmp
+#include <fstream>      // for std::ofstream and std::ifstream
+#include <iterator>     // for std::istreambuf_iterator
+#include <string>
+#include <type_traits>  // for std::is_integral
+#include <vector>
+
+namespace custom
+{
+
+// the calls a trace records
+enum trace_op : uint8_t
+{
+   TRACE_INSERT = 1,
+   TRACE_ERASE,
+   TRACE_FIND,
+   TRACE_CONTAINS,
+   TRACE_CLEAR,
+   TRACE_OP_MAX = TRACE_CLEAR
+};
+
+/************************************************
+ * TRACE EVENT
+ * One call, as read back from a trace
+ ***********************************************/
+struct trace_event
+{
+   trace_op op;
+   bool     isHashed;   // key is std::hash of the real key
+   uint64_t time;       // nanoseconds since the trace began
+   int64_t  key;
+};
+
+/************************************************
+ * TRACE KEY
+ * What a trace logs for a key: the integer itself,
+ * or its hash
+ ***********************************************/
+template <typename T>
+struct trace_key
+{
+   static const bool isHashed = !std::is_integral<T>::value;
+
+   static int64_t of(const T & t)
+   {
+      return ofKey(t, std::integral_constant<int,
+         std::is_integral<T>::value ? 0 : is_hashable<T>::value ? 1 : 2>());
+   }
+
+private:
+   static int64_t ofKey(const T & t, std::integral_constant<int, 0>)
+   {
+      return (int64_t)t;
+   }
+   static int64_t ofKey(const T & t, std::integral_constant<int, 1>)
+   {
+      return (int64_t)std::hash<T>()(t);
+   }
+   static int64_t ofKey(const T &, std::integral_constant<int, 2>)
+   {
+      return 0;
+   }
+};
+
+/************************************************
+ * TRACE WRITER
+ * Buffers events and writes them to a file
+ ***********************************************/
+class trace_writer
+{
+public:
+
+   static constexpr const char * MAGIC = "SETTRACE";
+   static const uint8_t VERSION = 1;
+
+   trace_writer() : numEvents(0), timeLast(0)
+   {
+   }
+   ~trace_writer()
+   {
+      close();
+   }
+   trace_writer(const trace_writer &) = delete;
+   trace_writer & operator = (const trace_writer &) = delete;
+
+   /*************************************************************
+    * OPEN
+    * Start a new trace at path; false if it cannot be written
+    *************************************************************/
+   bool open(const std::string & path)
+   {
+      close();
+      out.open(path.c_str(), std::ios::binary | std::ios::trunc);
+      if (!out)
+         return false;
+      out.write(MAGIC, 8);
+      out.put((char)VERSION);
+      buffer.reserve(BUFFER_MAX);
+      numEvents = 0;
+      timeLast = 0;
+      start = std::chrono::steady_clock::now();
+      return (bool)out;
+   }
+   bool is_open() const
+   {
+      return out.is_open();
+   }
+
+   /*************************************************************
+    * CLOSE
+    * Write what is buffered; false if any of the file failed
+    *************************************************************/
+   bool close()
+   {
+      if (!out.is_open())
+         return true;
+      flush();
+      bool isGood = (bool)out;
+      out.close();
+      return isGood && !out.fail();
+   }
+
+   /*************************************************************
+    * WRITE
+    * Log one call on a key, or one with no key such as clear()
+    *************************************************************/
+   template <typename T>
+   void write(trace_op op, const T & t)
+   {
+      event(op, trace_key<T>::isHashed, trace_key<T>::of(t));
+   }
+   void write(trace_op op)
+   {
+      event(op, false, 0);
+   }
+
+   uint64_t size() const
+   {
+      return numEvents;
+   }
+
+private:
+
+   static const size_t BUFFER_MAX = 1 << 16;
+   static const size_t EVENT_MAX = 1 + 10 + 10;   // op and two varints
+
+   void event(trace_op op, bool isHashed, int64_t key)
+   {
+      if (!out.is_open())
+         return;
+      uint64_t time = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>
+                      (std::chrono::steady_clock::now() - start).count();
+      if (buffer.size() + EVENT_MAX > BUFFER_MAX)
+         flush();
+      buffer.push_back((char)(op | (isHashed ? 0x80 : 0)));
+      putVarint(time - timeLast);
+      putVarint(((uint64_t)key << 1) ^ (uint64_t)(key >> 63));   // zigzag
+      timeLast = time;
+      numEvents++;
+   }
+
+   void putVarint(uint64_t value)
+   {
+      while (value >= 0x80)
+      {
+         buffer.push_back((char)((value & 0x7f) | 0x80));
+         value >>= 7;
+      }
+      buffer.push_back((char)value);
+   }
+
+   void flush()
+   {
+      out.write(buffer.data(), buffer.size());
+      buffer.clear();
+   }
+
+   std::ofstream out;
+   std::vector<char> buffer;                      // events not yet written
+   uint64_t numEvents;                            // events logged since open()
+   uint64_t timeLast;                             // nanoseconds of the last event
+   std::chrono::steady_clock::time_point start;   // when open() was called
+};
+
+/************************************************
+ * TRACE LOAD
+ * Every event in a trace file, in order. False, and
+ * no events, if the file is missing, is not a trace,
+ * or ends in the middle of an event.
+ ***********************************************/
+inline bool trace_load(const std::string & path, std::vector<trace_event> & events)
+{
+   events.clear();
+   std::ifstream in(path.c_str(), std::ios::binary);
+   if (!in)
+      return false;
+   std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   if (bytes.size() < 9 || memcmp(bytes.data(), trace_writer::MAGIC, 8) != 0 ||
+       (uint8_t)bytes[8] != trace_writer::VERSION)
+      return false;
+
+   const char * p = bytes.data() + 9;
+   const char * pEnd = bytes.data() + bytes.size();
+   auto getVarint = [&p, pEnd](uint64_t & value)
+   {
+      value = 0;
+      for (int shift = 0; shift < 64 && p < pEnd; shift += 7)
+      {
+         uint8_t c = (uint8_t)*p++;
+         value |= (uint64_t)(c & 0x7f) << shift;
+         if (!(c & 0x80))
+            return true;
+      }
+      return false;
+   };
+
+   uint64_t time = 0;
+   while (p < pEnd)
+   {
+      uint8_t op = (uint8_t)*p++;
+      uint64_t delta;
+      uint64_t zigzag;
+      if ((op & 0x7f) < TRACE_INSERT || (op & 0x7f) > TRACE_OP_MAX ||
+          !getVarint(delta) || !getVarint(zigzag))
+      {
+         events.clear();
+         return false;
+      }
+      time += delta;
+      events.push_back(trace_event{ (trace_op)(op & 0x7f), (op & 0x80) != 0, time,
+                                    (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1) });
+   }
+   return true;
+}
+
+}; // namespace custom
@@ -28,6 +28,8 @@
 #include <vector>    // for std::vector
 #include <map>       // for std::map
 
+#include "allocTracker.h"  // for custom::alloc_scope
+
 
 class UnitTest
 {
@@ -45,6 +47,9 @@ private:
    // each test has a name (the key) and the list of failures(value).
    std::map<std::string, std::vector<Failure>> tests;
 
+   // what the tests allocated since reset(), when operator new is hooked
+   custom::alloc_scope allocScope;
+
 protected:
    /*************************************************************
     * RESET
@@ -53,6 +58,16 @@ protected:
    void reset()
    {
       tests.clear();
+      allocScope.restart();
+   }
+
+   /*************************************************************
+    * ALLOCATIONS
+    * What the tests allocated since reset()
+    *************************************************************/
+   custom::alloc_stats allocations() const
+   {
+      return allocScope.stats();
    }
    
    /*************************************************************
@@ -93,7 +108,17 @@ protected:
       std::cerr << "There were "
          << tests.size()
          << " tests run for a success rate of: "
-         << (successRate * 100.0) << "%\n";
+         << (successRate * 100.0) << "%";
+
+      // and what it took from the heap, if we can tell
+      if (custom::alloc_tracker::isHooked())
+      {
+         custom::alloc_stats stats = allocations();
+         std::cerr << ", " << stats.numAllocs << " allocations of "
+                   << stats.bytesAllocated << " bytes, peak "
+                   << stats.bytesPeak << " bytes";
+      }
+      std::cerr << "\n";
 
    }
    